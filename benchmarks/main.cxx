@@ -1,6 +1,10 @@
 #include <benchmark/benchmark.h>
 #include <fsmpp2/states.hpp>
 #include <fsmpp2/state_machine.hpp>
+#include <fsmpp2/tracers.hpp>
+#include <fsmpp2/lockstep.hpp>
+#include <utility>
+#include <vector>
 
 namespace
 {
@@ -36,22 +40,21 @@ static void BM_DispatchEventToSingleStateMachineHandlingTheEvent(benchmark::Stat
 
 BENCHMARK(BM_DispatchEventToSingleStateMachineHandlingTheEvent);
 
-template<std::size_t I, bool Last = false> struct StPI : fsmpp2::state<> {
-    auto handle(EvA) { return transition<StPI<I+1>>(); }
-};
-template<std::size_t I> struct StPI<I,true> : fsmpp2::state<> {
-    auto handle(EvA) { return transition<StPI<0>>(); }
+template<std::size_t I, std::size_t N> struct StPI : fsmpp2::state<> {
+    auto handle(EvA) { return transition<StPI<(I + 1) % N, N>>(); }
 };
 
-template<std::size_t... I>
-struct generate_i_stpis {
-    using states = fsmpp2::states<StPI<I>..., StPI<sizeof...(I), true>>;
-};
+template<std::size_t N, std::size_t... I>
+auto generate_stpis(std::index_sequence<I...>) -> fsmpp2::states<StPI<I, N>...>;
+
+// ring of N states, each one moves to the next on EvA
+template<std::size_t N>
+using stpi_states = decltype(generate_stpis<N>(std::make_index_sequence<N>{}));
 
 template<std::size_t N>
 void BM_ProgressThroughStateMachine(benchmark::State& state) {
     using events = fsmpp2::events<EvA>;
-    using states = typename generate_i_stpis<10>::states;
+    using states = stpi_states<11>;
     fsmpp2::state_machine<states, events, NullCtx> sm;
     for (auto _ : state) {
         sm.dispatch(EvA{});
@@ -65,4 +68,84 @@ BENCHMARK(BM_ProgressThroughStateMachine<100>);
 BENCHMARK(BM_ProgressThroughStateMachine<1000>);
 BENCHMARK(BM_ProgressThroughStateMachine<10000>);
 
-}
\ No newline at end of file
+template<class Tracer>
+void BM_ProgressThroughStateMachineWithTracer(benchmark::State& state) {
+    using events = fsmpp2::events<EvA>;
+    using states = stpi_states<11>;
+    fsmpp2::state_machine<states, events, NullCtx, Tracer> sm;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sm.dispatch(EvA{}));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+using NullTracer = fsmpp2::detail::NullTracer;
+
+// composite of NullTracers is expected to cost exactly the same as a single NullTracer
+BENCHMARK(BM_ProgressThroughStateMachineWithTracer<NullTracer>);
+BENCHMARK(BM_ProgressThroughStateMachineWithTracer<fsmpp2::tracers<NullTracer, NullTracer, NullTracer>>);
+
+struct CountingTracer {
+    template<class State, class E>
+    void begin_event_handling() { events ++; }
+    void end_event_handling(bool) {}
+    template<class State>
+    void transition() { transitions ++; }
+
+    std::size_t events = 0;
+    std::size_t transitions = 0;
+};
+
+// toggled tracer which is switched off is expected to cost a single branch per callback over NullTracer
+BENCHMARK(BM_ProgressThroughStateMachineWithTracer<fsmpp2::toggled_tracer<NullTracer>>);
+BENCHMARK(BM_ProgressThroughStateMachineWithTracer<fsmpp2::toggled_tracer<CountingTracer>>);
+BENCHMARK(BM_ProgressThroughStateMachineWithTracer<CountingTracer>);
+
+static void BM_ProgressThroughStateMachineWithEnabledToggledTracer(benchmark::State& state) {
+    using events = fsmpp2::events<EvA>;
+    using states = stpi_states<11>;
+    fsmpp2::state_machine<states, events, NullCtx, fsmpp2::toggled_tracer<CountingTracer>> sm;
+    sm.tracer().enable();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sm.dispatch(EvA{}));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ProgressThroughStateMachineWithEnabledToggledTracer);
+
+template<std::size_t I, std::size_t N>
+struct StRing : fsmpp2::state<> {
+    using transition_table = fsmpp2::transition_table<fsmpp2::edge<StRing<I, N>, EvA, StRing<(I + 1) % N, N>>>;
+};
+
+template<std::size_t N, std::size_t... I>
+auto generate_strings(std::index_sequence<I...>) -> fsmpp2::states<StRing<I, N>...>;
+
+// every item is a single machine handling a single event
+template<fsmpp2::lockstep_isa Isa>
+void BM_LockstepStep(benchmark::State& state) {
+    using states = decltype(generate_strings<11>(std::make_index_sequence<11>{}));
+    using lockstep = fsmpp2::lockstep<states, fsmpp2::events<EvA>>;
+
+    auto const count = static_cast<std::size_t>(state.range(0));
+    std::vector<lockstep::index_type> current(count);
+    std::vector<lockstep::index_type> events(count, lockstep::event_index<EvA>());
+
+    for (auto _ : state) {
+        lockstep::step(current.data(), events.data(), count, Isa);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK(BM_LockstepStep<fsmpp2::lockstep_isa::scalar>)->Arg(4096)->Arg(1 << 20);
+BENCHMARK(BM_LockstepStep<fsmpp2::lockstep_isa::avx2>)->Arg(4096)->Arg(1 << 20);
+BENCHMARK(BM_LockstepStep<fsmpp2::lockstep_isa::avx512>)->Arg(4096)->Arg(1 << 20);
+
+}
@@ -0,0 +1,155 @@
+#ifndef FSMPP2_BROADCAST_HPP
+#define FSMPP2_BROADCAST_HPP
+
+#include "fsmpp2/thread_pool.hpp"
+#include "fsmpp2/detail/state_tree.hpp"
+#include "fsmpp2/detail/traits.hpp"
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace fsmpp2
+{
+
+/**
+ * Aggregated outcome of a broadcast.
+ **/
+struct broadcast_result {
+    std::size_t handled = 0;        // event handled
+    std::size_t not_handled = 0;    // event dispatched but not handled
+    std::size_t skipped = 0;        // not dispatched, no active state could handle or defer the event
+    std::size_t transitioned = 0;   // innermost active state changed (not tracked with orthogonal regions)
+
+    broadcast_result& operator+=(broadcast_result const& rhs) noexcept {
+        handled += rhs.handled;
+        not_handled += rhs.not_handled;
+        skipped += rhs.skipped;
+        transitioned += rhs.transitioned;
+        return *this;
+    }
+};
+
+namespace detail
+{
+
+template<class E, class Context, class... S>
+constexpr auto state_handles(meta::type_list<S...>) {
+    return std::array<bool, sizeof...(S) + 1> {
+        (can_handle_event<S, E>::value || can_handle_event_with_context<S, E, Context>::value || can_handle_event_in_table<S, E, Context>::value ||
+            defers_event<S, E>::value)...,
+        false};
+}
+
+/**
+ * For every innermost state id tells if E may be handled or deferred by the state or
+ * any of its parents (an event not handled by a substate is passed to its parent).
+ * The last entry stands for "no active state".
+ **/
+template<class States, class E, class Context>
+constexpr auto path_handles() {
+    constexpr auto count = states_count<States>();
+    constexpr auto parents = state_parents<States>();
+    auto result = state_handles<E, Context>(typename all_states<States>::type{});
+
+    // a parent always has lower id than its substates
+    for (std::size_t id = 0; id < count; ++id) {
+        if (parents[id] < count) {
+            result[id] = result[id] || result[parents[id]];
+        }
+    }
+
+    return result;
+}
+
+template<class StateMachine, class E>
+void broadcast_one(StateMachine& sm, E const& e, broadcast_result& result) {
+    using states = typename StateMachine::states_type;
+    using context = std::remove_reference_t<typename StateMachine::context_type>;
+
+    if constexpr (!any_state_handles<states, E, context>::value) {
+        result.skipped ++;
+    } else if constexpr (has_regions<states>::value) {
+        (sm.dispatch(e) ? result.handled : result.not_handled) ++;
+    } else {
+        static constexpr auto handles = path_handles<states, E, context>();
+        auto const before = sm.current_path_id();
+
+        if (!handles[before]) {
+            result.skipped ++;
+            return;
+        }
+
+        (sm.dispatch(e) ? result.handled : result.not_handled) ++;
+
+        if (sm.current_path_id() != before) {
+            result.transitioned ++;
+        }
+    }
+}
+
+// per thread result, on its own cache line
+struct alignas(64) broadcast_partial {
+    broadcast_result value;
+};
+
+} // namespace detail
+
+/**
+ * Dispatches an event to every state machine in [first, last) range using a thread pool.
+ *
+ * The range is split into chunks of consecutive machines (chunk = 0 picks the size
+ * automatically), each thread processes whole chunks and accumulates results locally.
+ * A machine is not touched if none of its active states can handle or defer the event,
+ * this is looked up in a table built at compile time.
+ *
+ * Every machine is dispatched by one thread only, but distinct machines must not
+ * share a context unless it is safe to access concurrently. An exception thrown by
+ * a handler is rethrown once all the threads are done, machines of chunks not
+ * started by then are not dispatched.
+ *
+ *      fsmpp2::thread_pool pool;
+ *      auto result = fsmpp2::broadcast(pool, machines.begin(), machines.end(), ConfigReload{});
+ **/
+template<class RandomIt, class E>
+broadcast_result broadcast(thread_pool& pool, RandomIt first, RandomIt last, E const& e, std::size_t chunk = 0) {
+    auto const count = static_cast<std::size_t>(std::distance(first, last));
+
+    if (chunk == 0) {
+        // a few chunks per thread to balance the load, large enough to amortize scheduling
+        constexpr std::size_t min_chunk = 64;
+        chunk = count / (pool.size() * 4);
+        chunk = chunk < min_chunk ? min_chunk : chunk;
+    }
+
+    std::vector<detail::broadcast_partial> partial(pool.size());
+
+    pool.parallel_for(count, chunk, [&](std::size_t thread, std::size_t begin, std::size_t end) {
+        auto& result = partial[thread].value;
+
+        for (auto it = first + begin; it != first + end; ++it) {
+            detail::broadcast_one(*it, e, result);
+        }
+    });
+
+    broadcast_result result;
+
+    for (auto const& p : partial) {
+        result += p.value;
+    }
+
+    return result;
+}
+
+/**
+ * Dispatches an event to every state machine in a range (eg. std::vector) using a thread pool.
+ **/
+template<class Range, class E>
+broadcast_result broadcast(thread_pool& pool, Range& machines, E const& e, std::size_t chunk = 0) {
+    return broadcast(pool, std::begin(machines), std::end(machines), e, chunk);
+}
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_BROADCAST_HPP
@@ -0,0 +1,335 @@
+#ifndef FSMPP2_CHROME_TRACE_HPP
+#define FSMPP2_CHROME_TRACE_HPP
+
+#include "fsmpp2/reflection.hpp"
+#include "fsmpp2/detail/spsc_ring.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace fsmpp2::chrome_trace
+{
+
+namespace detail
+{
+
+using name_function = std::string (*)();
+
+/**
+ * Single complete ("X") slice, either a state residency or a handler execution.
+ **/
+struct record {
+    std::uint64_t   begin_ns = 0;
+    std::uint64_t   end_ns = 0;
+    name_function   state = nullptr;
+    name_function   event = nullptr; // nullptr for state residency
+};
+
+template<std::size_t Capacity>
+struct channel {
+    channel(std::size_t i, std::string n)
+        : id {i}
+        , name {std::move(n)}
+    {}
+
+    fsmpp2::detail::spsc_ring<record, Capacity> ring;
+    std::atomic<std::uint64_t>                  dropped {0};
+    std::size_t const                           id;
+    std::string const                           name;
+};
+
+inline std::uint64_t now_ns() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void write_escaped(std::ostream& os, std::string const& str) {
+    for (auto c : str) {
+        if (c == '"' || c == '\\') {
+            os << '\\';
+        }
+        os << c;
+    }
+}
+
+} // namespace detail
+
+/**
+ * Per state machine tracer, records slices into a bounded lock-free ring.
+ *
+ * It only takes timestamps and stores type name getters, all the formatting
+ * is done by the session on its own thread. If the ring is full the slice is
+ * dropped and counted.
+ **/
+template<std::size_t Capacity>
+class tracer {
+public:
+    // maximum number of states recorded at once, states entered beyond it are not recorded
+    static constexpr std::size_t max_active = 16;
+
+    explicit tracer(detail::channel<Capacity>& ch) noexcept
+        : channel_ {&ch}
+    {}
+
+    template<class State, class E>
+    void begin_event_handling() {
+        handler_ = detail::record{
+            detail::now_ns(),
+            0,
+            &reflection::get_type_name<State>,
+            &reflection::get_type_name<E>};
+        handler_open_ = true;
+    }
+
+    void end_event_handling(bool result) {
+        if (handler_open_ && result) {
+            close_handler();
+        }
+
+        handler_open_ = false;
+    }
+
+    template<class State>
+    void transition() {
+        // the handler has already returned, close it before any state is left
+        // so the handler slice is nested within its state slice
+        close_handler();
+    }
+
+    template<class State>
+    void enter_state(State const&) {
+        if (active_ < max_active) {
+            entered_[active_++] = entry{&reflection::get_type_name<State>, detail::now_ns()};
+        }
+    }
+
+    template<class State>
+    void exit_state(State const&) {
+        auto const state = &reflection::get_type_name<State>;
+
+        // states of orthogonal regions are not left in reverse order of entering,
+        // so the entry is looked up by the state instead of popped
+        for (auto i = active_; i-- > 0; ) {
+            if (entered_[i].state == state) {
+                push(detail::record{entered_[i].begin_ns, detail::now_ns(), state, nullptr});
+                entered_[i] = entered_[--active_];
+                return;
+            }
+        }
+
+        // not found if entered while tracing was disabled (see toggled_tracer) or over max_active
+    }
+
+private:
+    struct entry {
+        detail::name_function   state = nullptr;
+        std::uint64_t           begin_ns = 0;
+    };
+
+    void close_handler() {
+        if (handler_open_) {
+            handler_.end_ns = detail::now_ns();
+            push(handler_);
+            handler_open_ = false;
+        }
+    }
+
+    void push(detail::record const& r) {
+        if (!channel_->ring.try_push(r)) {
+            channel_->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    detail::channel<Capacity>*                  channel_;
+    detail::record                              handler_ {};
+    bool                                        handler_open_ = false;
+    std::size_t                                 active_ = 0;
+    std::array<entry, max_active>               entered_ {};
+};
+
+/**
+ * Chrome Trace Event (JSON) capture of any number of state machines.
+ *
+ * Every state machine gets its own track (tid), state residencies and handler
+ * executions are written as complete slices and nested by the viewer
+ * (chrome://tracing, ui.perfetto.dev). Serialization is done by a background
+ * thread which periodically drains all the per machine rings.
+ *
+ *      fsmpp2::chrome_trace::session session{ofs};
+ *      fsmpp2::state_machine sm{States{}, Events{}, ctx, session.make_tracer("machine-1")};
+ **/
+template<std::size_t Capacity = 1024>
+class basic_session {
+public:
+    using tracer_type = tracer<Capacity>;
+
+    explicit basic_session(std::ostream& os, std::chrono::milliseconds flush_interval = std::chrono::milliseconds{10})
+        : os_ {os}
+        , flush_interval_ {flush_interval}
+        , origin_ns_ {detail::now_ns()}
+    {
+        os_ << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        thread_ = std::thread{[this] { run(); }};
+    }
+
+    basic_session(basic_session const&) = delete;
+    basic_session& operator=(basic_session const&) = delete;
+
+    ~basic_session() {
+        stop();
+    }
+
+    /**
+     * Creates a tracer writing to a new track.
+     *
+     * The tracer must not be used by more than one thread at a time and
+     * must not outlive the session.
+     **/
+    tracer_type make_tracer(std::string name = {}) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto const id = channels_.size() + 1;
+
+        if (name.empty()) {
+            name = "machine " + std::to_string(id);
+        }
+
+        return tracer_type{channels_.emplace_back(id, std::move(name))};
+    }
+
+    /**
+     * Writes all pending slices, closes JSON document and stops background thread.
+     **/
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+
+            if (stop_) {
+                return;
+            }
+
+            stop_ = true;
+        }
+
+        cv_.notify_one();
+        thread_.join();
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        drain();
+        os_ << "]}\n";
+        os_.flush();
+    }
+
+    /**
+     * Number of slices dropped because a ring was full.
+     **/
+    std::uint64_t dropped() const {
+        std::lock_guard<std::mutex> lock{mutex_};
+        std::uint64_t result = 0;
+
+        for (auto const& ch : channels_) {
+            result += ch.dropped.load(std::memory_order_relaxed);
+        }
+
+        return result;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock{mutex_};
+
+        while (!stop_) {
+            cv_.wait_for(lock, flush_interval_);
+            drain();
+        }
+    }
+
+    // called with mutex_ locked
+    void drain() {
+        for (; named_ < channels_.size(); ++named_) {
+            auto const& ch = channels_[named_];
+            separator();
+            os_ << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ch.id
+                << ",\"args\":{\"name\":\"";
+            detail::write_escaped(os_, ch.name);
+            os_ << "\"}}";
+        }
+
+        detail::record r;
+
+        for (auto& ch : channels_) {
+            while (ch.ring.try_pop(r)) {
+                write(ch.id, r);
+            }
+        }
+    }
+
+    void write(std::size_t tid, detail::record const& r) {
+        separator();
+        os_ << "{\"name\":\"";
+
+        if (r.event) {
+            detail::write_escaped(os_, name(r.event));
+            os_ << "\",\"cat\":\"handler\",\"args\":{\"state\":\"";
+            detail::write_escaped(os_, name(r.state));
+            os_ << "\"}";
+        } else {
+            detail::write_escaped(os_, name(r.state));
+            os_ << "\",\"cat\":\"state\"";
+        }
+
+        os_ << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << micros(r.begin_ns - origin_ns_)
+            << ",\"dur\":" << micros(r.end_ns - r.begin_ns)
+            << "}";
+    }
+
+    std::string const& name(detail::name_function fun) {
+        auto it = names_.find(fun);
+
+        if (it == names_.end()) {
+            it = names_.emplace(fun, fun()).first;
+        }
+
+        return it->second;
+    }
+
+    static std::string micros(std::uint64_t ns) {
+        auto const frac = std::to_string(1000 + ns % 1000);
+        return std::to_string(ns / 1000) + "." + frac.substr(1);
+    }
+
+    void separator() {
+        if (!first_) {
+            os_ << ",\n";
+        } else {
+            os_ << "\n";
+            first_ = false;
+        }
+    }
+
+    std::ostream&                                           os_;
+    std::chrono::milliseconds const                         flush_interval_;
+    std::uint64_t const                                     origin_ns_;
+    mutable std::mutex                                      mutex_;
+    std::condition_variable                                 cv_;
+    bool                                                    stop_ = false;
+    bool                                                    first_ = true;
+    std::size_t                                             named_ = 0;
+    std::deque<detail::channel<Capacity>>                   channels_;
+    std::unordered_map<detail::name_function, std::string>  names_;
+    std::thread                                             thread_;
+};
+
+using session = basic_session<>;
+
+} // namespace fsmpp2::chrome_trace
+
+#endif // FSMPP2_CHROME_TRACE_HPP
@@ -0,0 +1,150 @@
+#ifndef FSMPP2_COALESCING_HPP
+#define FSMPP2_COALESCING_HPP
+
+#include "fsmpp2/envelope.hpp"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fsmpp2
+{
+
+/**
+ * Coalescing policies, applied when an event is enqueued while an event of the
+ * same type is the last one pending in the queue. Events are never merged across
+ * an event of another type, so the order of events of different types is kept.
+ **/
+
+/**
+ * Every event is queued (default).
+ **/
+struct coalesce_none {};
+
+/**
+ * The pending event is replaced by the new one.
+ **/
+struct coalesce_replace_latest {};
+
+/**
+ * The new event is dropped if it compares equal to the pending one.
+ **/
+struct coalesce_drop_duplicates {};
+
+/**
+ * A member of the new event is added to the member of the pending one, eg:
+ * coalesce_sum<&TimeElapsed::delta>.
+ **/
+template<auto Member> struct coalesce_sum {};
+
+namespace detail
+{
+
+template<class E, class = void>
+struct nested_coalescing {
+    using type = coalesce_none;
+};
+
+template<class E>
+struct nested_coalescing<E, std::void_t<typename E::coalescing>> {
+    using type = typename E::coalescing;
+};
+
+} // namespace detail
+
+/**
+ * Coalescing policy of an event type. It is taken from E::coalescing if declared,
+ * may also be specialized for an event type:
+ *
+ *      template<> struct fsmpp2::coalescing<TimeElapsed> {
+ *          using type = fsmpp2::coalesce_sum<&TimeElapsed::delta>;
+ *      };
+ **/
+template<class E>
+struct coalescing : detail::nested_coalescing<E> {};
+
+namespace detail
+{
+
+/**
+ * Queue of pending events (kept in envelopes) applying coalescing policies at enqueue time.
+ *
+ * An event is coalesced only with the last pending event, if it is of the same type.
+ **/
+template<class Envelope>
+class coalescing_buffer {
+public:
+    using events_type = typename Envelope::events_type;
+    using envelope_type = Envelope;
+
+    /**
+     * Enqueues an event, returns false if it was merged into a pending one.
+     * The arena is used if the event does not fit inline in the envelope.
+     **/
+    template<class Ev>
+    bool push(Ev const& e, envelope_arena* arena = nullptr) {
+        using policy = typename coalescing<Ev>::type;
+
+        if constexpr (!std::is_same_v<policy, coalesce_none>) {
+            if (!items_.empty() && items_.back().template holds<Ev>() && merge(items_.back().template get<Ev>(), e, policy{})) {
+                return false;
+            }
+        }
+
+        items_.emplace_back(e, arena);
+        return true;
+    }
+
+    /**
+     * Pending events, in order.
+     **/
+    std::vector<envelope_type>& items() noexcept {
+        return items_;
+    }
+
+    std::size_t size() const noexcept {
+        return items_.size();
+    }
+
+    bool empty() const noexcept {
+        return items_.empty();
+    }
+
+    void clear() noexcept {
+        items_.clear();
+    }
+
+    /**
+     * Moves all the pending events to the output vector (which is cleared first).
+     **/
+    void take(std::vector<envelope_type>& out) noexcept {
+        out.clear();
+        items_.swap(out);
+    }
+
+private:
+    template<class Ev>
+    static bool merge(Ev& pending, Ev const& e, coalesce_replace_latest) {
+        pending = e;
+        return true;
+    }
+
+    template<class Ev>
+    static bool merge(Ev& pending, Ev const& e, coalesce_drop_duplicates) {
+        return pending == e;
+    }
+
+    template<class Ev, class T, T Ev::*Member>
+    static bool merge(Ev& pending, Ev const& e, coalesce_sum<Member>) {
+        pending.*Member += e.*Member;
+        return true;
+    }
+
+    std::vector<envelope_type> items_;
+};
+
+} // namespace detail
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_COALESCING_HPP
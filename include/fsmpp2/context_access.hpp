@@ -0,0 +1,339 @@
+#ifndef FSMPP2_CONTEXT_ACCESS_HPP
+#define FSMPP2_CONTEXT_ACCESS_HPP
+
+#include "fsmpp2/meta.hpp"
+#include "fsmpp2/contexts.hpp"
+#include "fsmpp2/states.hpp"
+#include "fsmpp2/transition_table.hpp"
+#include "fsmpp2/detail/read_only.hpp"
+#include "fsmpp2/detail/state_tree.hpp"
+#include "fsmpp2/detail/traits.hpp"
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+
+namespace fsmpp2
+{
+
+namespace detail
+{
+
+template<class X, class... C>
+using contexts_without = typename meta::type_list_rename<
+    typename meta::type_list_remove<X, meta::type_list<C...>>::result,
+    fsmpp2::contexts
+>::result;
+
+template<bool B, class T>
+using list_if = std::conditional_t<B, meta::type_list<T>, meta::type_list<>>;
+
+/**
+ * Contexts passed to a State constructor. A state may keep the references,
+ * so these are also the contexts it may access in any handler and destructor.
+ *
+ * With a contexts<> bundle a context is required if the state can't be
+ * constructed from a bundle lacking it (eg. a state taking access_context<A, B>).
+ **/
+template<class S, class Context>
+struct construct_access {
+    using type = list_if<std::is_constructible_v<S, Context&>, Context>;
+};
+
+template<class S, class... C>
+struct construct_access<S, fsmpp2::contexts<C...>> {
+    using type = std::conditional_t<
+        std::is_constructible_v<S, fsmpp2::contexts<C...>&>,
+        typename meta::type_list_concat<list_if<!std::is_constructible_v<S, contexts_without<C, C...>&>, C>...>::result,
+        typename meta::type_list_concat<list_if<std::is_constructible_v<S, C&>, C>...>::result
+    >;
+};
+
+template<class S, class E, class Context, bool = can_handle_event_in_table<S, E, Context>::value>
+struct table_access : std::false_type {};
+
+template<class S, class E, class Context>
+struct table_access<S, E, Context, true> : table_uses_context<S, E, Context> {};
+
+/**
+ * Contexts passed to a handler of event E, or to guards and actions of transition_table
+ * rows (all the contexts of a contexts<> bundle).
+ **/
+template<class S, class E, class Context>
+struct handler_access {
+    using type = list_if<
+        (!can_handle_event<S, E>::value && can_handle_event_with_context<S, E, Context>::value) || table_access<S, E, Context>::value,
+        Context>;
+};
+
+template<class S, class E, class... C>
+struct handler_access<S, E, fsmpp2::contexts<C...>> {
+    using type = std::conditional_t<
+        table_access<S, E, fsmpp2::contexts<C...>>::value,
+        meta::type_list<C...>,
+        std::conditional_t<
+            !can_handle_event<S, E>::value && can_handle_event_with_context<S, E, fsmpp2::contexts<C...>>::value,
+            typename meta::type_list_concat<list_if<!can_handle_event_with_context<S, E, contexts_without<C, C...>>::value, C>...>::result,
+            meta::type_list<>
+        >
+    >;
+};
+
+template<class S, class Context, bool = has_completion<S>::value, bool = has_completion_with_context<S, Context>::value>
+struct completion_result { using type = transitions<>; };
+
+template<class S, class Context, bool WithContext>
+struct completion_result<S, Context, true, WithContext> {
+    using type = decltype(std::declval<S&>().completion());
+};
+
+template<class S, class Context>
+struct completion_result<S, Context, false, true> {
+    using type = decltype(std::declval<S&>().completion(std::declval<Context&>()));
+};
+
+/**
+ * Contexts passed to a completion check of a state (see handler_access).
+ **/
+template<class S, class Context>
+struct completion_handler_access {
+    using type = list_if<!has_completion<S>::value && has_completion_with_context<S, Context>::value, Context>;
+};
+
+template<class S, class... C>
+struct completion_handler_access<S, fsmpp2::contexts<C...>> {
+    using type = std::conditional_t<
+        !has_completion<S>::value && has_completion_with_context<S, fsmpp2::contexts<C...>>::value,
+        typename meta::type_list_concat<list_if<!has_completion_with_context<S, contexts_without<C, C...>>::value, C>...>::result,
+        meta::type_list<>
+    >;
+};
+
+template<class S, class Context, class Root, class Visited> struct completion_access;
+template<class States, class Context, class Root, class Visited> struct initial_enter_access;
+
+/**
+ * Contexts accessed when entering a state, including its initial substates and
+ * completion transitions of the entered states.
+ **/
+template<class S, class Context, class Root, class Visited = meta::type_list<>>
+struct enter_access {
+    using type = typename meta::type_list_union<
+        typename construct_access<S, Context>::type,
+        typename initial_enter_access<typename S::substates_type, Context, Root, Visited>::type,
+        typename completion_access<S, Context, Root, Visited>::type
+    >::result;
+};
+
+template<class Context, class Root, class Visited>
+struct initial_enter_access<fsmpp2::states<>, Context, Root, Visited> {
+    using type = meta::type_list<>;
+};
+
+template<class First, class... Rest, class Context, class Root, class Visited>
+struct initial_enter_access<fsmpp2::states<First, Rest...>, Context, Root, Visited> {
+    using type = typename enter_access<First, Context, Root, Visited>::type;
+};
+
+template<class... R, class Context, class Root, class Visited>
+struct initial_enter_access<fsmpp2::regions<R...>, Context, Root, Visited> {
+    using type = typename meta::type_list_union<meta::type_list<>, typename initial_enter_access<R, Context, Root, Visited>::type...>::result;
+};
+
+template<class States, class Context> struct subtree_access_impl;
+
+template<class... S, class Context>
+struct subtree_access_impl<meta::type_list<S...>, Context> {
+    using type = typename meta::type_list_union<typename construct_access<S, Context>::type...>::result;
+};
+
+/**
+ * Contexts possibly accessed when leaving a state with any of its substates active.
+ **/
+template<class S, class Context>
+struct exit_access : subtree_access_impl<typename all_states<fsmpp2::states<S>>::type, Context> {};
+
+template<class Path, class Context, class Root, class Visited> struct path_enter_access;
+
+template<class T, class Context, class Root, class Visited>
+struct path_enter_access<meta::type_list<T>, Context, Root, Visited> : enter_access<T, Context, Root, Visited> {};
+
+template<class S, class Next, class... Rest, class Context, class Root, class Visited>
+struct path_enter_access<meta::type_list<S, Next, Rest...>, Context, Root, Visited> {
+    using type = typename meta::type_list_union<
+        typename construct_access<S, Context>::type,
+        typename path_enter_access<meta::type_list<Next, Rest...>, Context, Root, Visited>::type,
+        typename completion_access<S, Context, Root, Visited>::type
+    >::result;
+};
+
+/**
+ * Contexts accessed by a transition from S to T within Root hierarchy, see transition_route.
+ **/
+template<class S, class T, class Context, class Root, class Visited, class Route = transition_route<S, T, Root>>
+struct route_access {
+    using type = typename meta::type_list_union<
+        typename exit_access<typename Route::source, Context>::type,
+        typename path_enter_access<typename Route::path, Context, Root, Visited>::type
+    >::result;
+};
+
+template<class S, class Context, class Targets, class Root, class Visited = meta::type_list<>>
+struct transition_access;
+
+template<class S, class Context, class... T, class Root, class Visited>
+struct transition_access<S, Context, meta::type_list<T...>, Root, Visited> {
+    using type = typename meta::type_list_union<
+        meta::type_list<>,
+        typename route_access<S, T, Context, Root, Visited>::type...
+    >::result;
+};
+
+template<class S, class Context, class Root, class Visited>
+struct transition_access<S, Context, meta::type_list<>, Root, Visited> {
+    using type = meta::type_list<>;
+};
+
+/**
+ * Contexts accessed by a completion check of a just entered state and the transition it
+ * may request. A chain of completion transitions may return to a state, Visited are the
+ * states whose completion is already accounted for.
+ **/
+template<class S, class Context, class Root, class Visited, bool = true>
+struct completion_access_impl {
+    using type = meta::type_list<>;
+};
+
+template<class S, class Context, class Root, class... V>
+struct completion_access_impl<S, Context, Root, meta::type_list<V...>, false> {
+    using type = typename meta::type_list_union<
+        typename completion_handler_access<S, Context>::type,
+        typename transition_access<S, Context, typename completion_result<S, Context>::type::list, Root, meta::type_list<V..., S>>::type
+    >::result;
+};
+
+template<class S, class Context, class Root, class... V>
+struct completion_access<S, Context, Root, meta::type_list<V...>>
+    : completion_access_impl<S, Context, Root, meta::type_list<V...>, meta::type_pack_contains<S, V...>::value> {};
+
+/**
+ * All contexts which may be accessed when State handles event E: contexts
+ * passed to the handler, kept by the state and, if the handler can request
+ * a transition, used by the states being left and entered.
+ **/
+template<class S, class E, class Context, class Root = fsmpp2::states<S>>
+struct state_event_access {
+    using type = std::conditional_t<
+        can_handle_event<S, E>::value || can_handle_event_with_context<S, E, Context>::value || can_handle_event_in_table<S, E, Context>::value,
+        typename meta::type_list_union<
+            typename construct_access<S, Context>::type,
+            typename handler_access<S, E, Context>::type,
+            typename transition_access<S, Context, typename mutable_handle_result<S, E, Context>::type::list, Root>::type
+        >::result,
+        meta::type_list<>
+    >;
+};
+
+template<class S, class E, class Context>
+struct may_transition : std::bool_constant<
+    !std::is_same_v<typename mutable_handle_result<S, E, Context>::type::list, meta::type_list<>>> {};
+
+template<class E, class Context, class Root, class StatesList>
+struct event_access_impl;
+
+template<class E, class Context, class Root, class... S>
+struct event_access_impl<E, Context, Root, meta::type_list<S...>> {
+    using type = typename meta::type_list_union<meta::type_list<>, typename state_event_access<S, E, Context, Root>::type...>::result;
+    static constexpr bool transitions = (may_transition<S, E, Context>::value || ...);
+};
+
+template<class StatesList> struct deferred_events_of;
+
+template<class... S>
+struct deferred_events_of<meta::type_list<S...>> {
+    using type = typename meta::type_list_union<meta::type_list<>, typename state_deferred_events<S>::type...>::result;
+};
+
+/**
+ * All contexts which may be accessed when E is dispatched to a state machine, whatever its current state is.
+ *
+ * Leaving any state replays deferred events within the same dispatch, so if E may cause
+ * a transition the access sets of all the events deferred anywhere in States are included.
+ **/
+template<class States, class E, class Context, class Deferred = typename deferred_events_of<typename all_states<States>::type>::type>
+struct event_access;
+
+template<class States, class E, class Context, class... D>
+struct event_access<States, E, Context, meta::type_list<D...>> {
+    using handlers = event_access_impl<E, Context, States, typename all_states<States>::type>;
+
+    using type = std::conditional_t<
+        handlers::transitions,
+        typename meta::type_list_union<
+            typename handlers::type,
+            typename event_access_impl<D, Context, States, typename all_states<States>::type>::type...
+        >::result,
+        typename handlers::type
+    >;
+};
+
+} // namespace detail
+
+/**
+ * Checks if two context access sets (type lists) have no context in common.
+ **/
+template<class A, class B>
+struct access_disjoint;
+
+template<class... A, class... B>
+struct access_disjoint<meta::type_list<A...>, meta::type_list<B...>>
+    : std::bool_constant<!(meta::type_pack_contains<A, B...>::value || ...)> {};
+
+template<class A, class B>
+constexpr bool access_disjoint_v = access_disjoint<A, B>::value;
+
+/**
+ * A mutex per context type, allows locking only the contexts an event may access.
+ *
+ *      fsmpp2::context_locks<Config, Stats, Sessions> locks;
+ *      locks.dispatch(sm, Ev{});   // locks only contexts used by Ev handlers
+ *
+ * Mutexes are always locked all at once using std::scoped_lock deadlock avoidance.
+ **/
+template<class... C>
+class context_locks {
+public:
+    using mutex_type = std::mutex;
+
+    /**
+     * Locks all the contexts in an access set (type list), returns a scoped lock.
+     **/
+    template<class AccessSet>
+    auto lock() {
+        return lock_impl(AccessSet{});
+    }
+
+    /**
+     * Dispatches an event to a state machine holding locks for all the contexts it may access.
+     **/
+    template<class StateMachine, class E>
+    auto dispatch(StateMachine& sm, E const& e) {
+        auto guard = lock<typename StateMachine::template event_context_access<E>>();
+        return sm.dispatch(e);
+    }
+
+private:
+    template<class>
+    using mutex_for = mutex_type;
+
+    template<class... L>
+    auto lock_impl(meta::type_list<L...>) {
+        static_assert((meta::type_pack_contains<L, C...>::value && ...), "access set contains a context without a mutex");
+        return std::scoped_lock<mutex_for<L>...>{std::get<meta::type_list_index<L>(meta::type_list<C...>{})>(mutexes_)...};
+    }
+
+    std::tuple<mutex_for<C>...> mutexes_;
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_CONTEXT_ACCESS_HPP
@@ -0,0 +1,216 @@
+#ifndef FSMPP2_DETAIL_ASYNC_RUNTIME_HPP
+#define FSMPP2_DETAIL_ASYNC_RUNTIME_HPP
+
+#include "fsmpp2/config.hpp"
+
+#ifdef FSMPP2_USE_CPP20
+
+#include "fsmpp2/task.hpp"
+#include "fsmpp2/detail/deferred_events.hpp"
+#include "fsmpp2/detail/read_only.hpp"
+#include "fsmpp2/detail/state_tree.hpp"
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <utility>
+
+namespace fsmpp2::detail
+{
+
+/**
+ * Handler coroutine of a state machine, at most one is suspended at a time.
+ **/
+class async_slot {
+public:
+    using finish_type = bool (*)(void* manager, std::coroutine_handle<> frame);
+
+    async_slot(void* machine, void (*replay)(void*)) noexcept
+        : machine_ {machine}
+        , replay_ {replay}
+    {}
+
+    async_slot(async_slot const&) = delete;
+    async_slot& operator=(async_slot const&) = delete;
+
+    ~async_slot() {
+        cancel();
+    }
+
+    bool busy() const noexcept {
+        return static_cast<bool>(pending_);
+    }
+
+    /**
+     * Destroys a suspended handler coroutine, it must not be resumed afterwards.
+     **/
+    void cancel() noexcept {
+        if (pending_) {
+            std::exchange(pending_, {}).destroy();
+        }
+    }
+
+    /**
+     * Runs a handler coroutine until it completes or suspends. finish takes the
+     * result and applies it on completion, now or when the coroutine is resumed.
+     **/
+    template<class R>
+    bool start(task<R> t, finish_type finish, void* manager) {
+        assert(!busy() && "only one asynchronous handler may be suspended at a time");
+
+        auto h = t.release();
+        h.promise().on_done = &completed;
+        h.promise().on_done_arg = this;
+
+        pending_ = h;
+        finish_ = finish;
+        manager_ = manager;
+        starting_ = true;
+
+        h.resume();
+        starting_ = false;
+
+        if (h.done()) {
+            pending_ = {};
+            return finish(manager, h);
+        }
+
+        // the event is considered handled, the outcome is known later
+        return true;
+    }
+
+private:
+    static void completed(void* self) noexcept {
+        auto& slot = *static_cast<async_slot*>(self);
+
+        if (slot.starting_) {
+            // completed synchronously, start() takes it over
+            return;
+        }
+
+        // an exception escaping a resumed handler has no caller to propagate to,
+        // this is noexcept so it terminates
+        slot.finish_(slot.manager_, std::exchange(slot.pending_, {}));
+        slot.replay_(slot.machine_);
+    }
+
+    std::coroutine_handle<>     pending_;
+    finish_type                 finish_ = nullptr;
+    void*                       manager_ = nullptr;
+    void*                       machine_;
+    void                        (*replay_)(void*);
+    bool                        starting_ = false;
+};
+
+template<class C, class StatesList, class E>
+struct any_async_handler;
+
+template<class C, class... S, class E>
+struct any_async_handler<C, meta::type_list<S...>, E>
+    : std::bool_constant<(is_task<typename mutable_handle_result<S, E, C>::type>::value || ...)> {};
+
+/**
+ * Checks if any state handles any of Events with a coroutine.
+ **/
+template<class States, class Events, class C>
+struct has_async_handlers;
+
+template<class States, class... E, class C>
+struct has_async_handlers<States, meta::type_list<E...>, C>
+    : std::bool_constant<(any_async_handler<C, typename all_states<States>::type, E>::value || ...)> {};
+
+/**
+ * Asynchronous handlers support of a state machine: the frame arena, the handler
+ * slot and events queued by the busy policy.
+ **/
+template<class Events, class Options, bool Enabled>
+class async_runtime {
+public:
+    async_runtime(void* machine, void (*replay)(void*)) noexcept
+        : slot_ {machine, replay}
+    {}
+
+    bool busy() const noexcept {
+        return slot_.busy();
+    }
+
+    async_slot* slot() noexcept {
+        return &slot_;
+    }
+
+    frame_pool* pool() noexcept {
+        return &arena_;
+    }
+
+    template<class E>
+    bool queue(E const& e) {
+        if constexpr (meta::type_list_has<E>(Events{})) {
+            return queued_.push(e);
+        } else {
+            return false;
+        }
+    }
+
+    /**
+     * Dispatches queued events until none is left or a handler suspends again.
+     **/
+    template<class StateMachine>
+    void replay(StateMachine& sm) {
+        if constexpr (Options::busy_policy::capacity > 0) {
+            if (replaying_) {
+                return;
+            }
+
+            replaying_ = true;
+
+            while (!busy() && queued_.size() > 0) {
+                queued_.pop().dispatch(sm);
+            }
+
+            replaying_ = false;
+        }
+    }
+
+    std::size_t queued() const noexcept {
+        return queued_.size();
+    }
+
+    void cancel() noexcept {
+        slot_.cancel();
+    }
+
+private:
+    // the arena outlives the frame destroyed by the slot
+    frame_arena<Options::frame_size + frame_header, Options::frames>    arena_;
+    envelope_queue<Events, Options::busy_policy::capacity>              queued_;
+    async_slot                                                          slot_;
+    bool                                                                replaying_ = false;
+};
+
+template<class Events, class Options>
+class async_runtime<Events, Options, false> {
+public:
+    async_runtime(void*, void (*)(void*)) noexcept {}
+
+    bool busy() const noexcept {
+        return false;
+    }
+
+    async_slot* slot() noexcept {
+        return nullptr;
+    }
+
+    template<class StateMachine>
+    void replay(StateMachine&) noexcept {}
+
+    std::size_t queued() const noexcept {
+        return 0;
+    }
+
+    void cancel() noexcept {}
+};
+
+} // namespace fsmpp2::detail
+
+#endif // FSMPP2_USE_CPP20
+
+#endif // FSMPP2_DETAIL_ASYNC_RUNTIME_HPP
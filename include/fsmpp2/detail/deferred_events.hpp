@@ -0,0 +1,151 @@
+#ifndef FSMPP2_DETAIL_DEFERRED_EVENTS_HPP
+#define FSMPP2_DETAIL_DEFERRED_EVENTS_HPP
+
+#include "fsmpp2/meta.hpp"
+#include "fsmpp2/envelope.hpp"
+#include "fsmpp2/detail/state_tree.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+namespace fsmpp2::detail
+{
+
+/**
+ * Bounded FIFO of events kept in envelopes, it never allocates.
+ **/
+template<class Events, std::size_t Capacity>
+class envelope_queue {
+public:
+    using envelope_type = envelope<Events>;
+
+    template<class E>
+    bool push(E const& e) {
+        if (size_ == Capacity) {
+            return false;
+        }
+
+        buffer_[(head_ + size_) % Capacity] = envelope_type {e};
+        size_ ++;
+        return true;
+    }
+
+    envelope_type pop() noexcept {
+        auto e = std::move(buffer_[head_]);
+        head_ = (head_ + 1) % Capacity;
+        size_ --;
+        return e;
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+private:
+    std::array<envelope_type, Capacity> buffer_;
+    std::size_t                         head_ = 0;
+    std::size_t                         size_ = 0;
+};
+
+template<class Events>
+class envelope_queue<Events, 0> {
+public:
+    template<class E>
+    bool push(E const&) noexcept {
+        return false;
+    }
+
+    std::size_t size() const noexcept {
+        return 0;
+    }
+};
+
+template<class S, class = void>
+struct state_deferred_capacity : std::integral_constant<std::size_t, 16> {};
+
+template<class S>
+struct state_deferred_capacity<S, std::void_t<decltype(S::deferred_capacity)>>
+    : std::integral_constant<std::size_t, S::deferred_capacity> {};
+
+template<class StatesList> struct deferred_capacity_impl;
+
+template<class... S>
+struct deferred_capacity_impl<meta::type_list<S...>> : std::integral_constant<std::size_t, std::max({
+    std::size_t{0},
+    (std::is_same_v<typename state_deferred_events<S>::type, meta::type_list<>> ? std::size_t{0} : state_deferred_capacity<S>::value)...
+})> {};
+
+/**
+ * Size of the deferred events buffer of a state machine, the largest capacity
+ * declared by any of its deferring states (0 if there are none).
+ **/
+template<class States>
+struct deferred_capacity : deferred_capacity_impl<typename all_states<States>::type> {};
+
+/**
+ * Events deferred by active states, replayed after the state machine leaves a state.
+ **/
+template<class Events, std::size_t Capacity>
+class deferred_queue {
+public:
+    template<class E>
+    bool defer(E const& e) {
+        static_assert(list_contains<E, Events>::value, "deferred event is not on the events list");
+        return queue_.push(e);
+    }
+
+    void state_left() noexcept {
+        left_ = true;
+    }
+
+    std::size_t size() const noexcept {
+        return queue_.size();
+    }
+
+    /**
+     * Dispatches deferred events again, in order, as long as any state is left in
+     * the meantime. Events still deferred by the new active states are kept.
+     **/
+    template<class StateMachine>
+    void replay(StateMachine& sm) {
+        if (replaying_) {
+            return;
+        }
+
+        replaying_ = true;
+
+        while (left_ && queue_.size() > 0) {
+            left_ = false;
+
+            for (auto count = queue_.size(); count > 0; --count) {
+                queue_.pop().dispatch(sm);
+            }
+        }
+
+        left_ = false;
+        replaying_ = false;
+    }
+
+private:
+    envelope_queue<Events, Capacity>    queue_;
+    bool                                left_ = false;
+    bool                                replaying_ = false;
+};
+
+template<class Events>
+class deferred_queue<Events, 0> {
+public:
+    void state_left() noexcept {}
+
+    std::size_t size() const noexcept {
+        return 0;
+    }
+
+    template<class StateMachine>
+    void replay(StateMachine&) noexcept {}
+};
+
+} // namespace fsmpp2::detail
+
+#endif // FSMPP2_DETAIL_DEFERRED_EVENTS_HPP
@@ -8,6 +8,12 @@ struct handled {};
 struct not_handled {};
 template<class T> struct transition { using type = T; };
 
+enum class handle_outcome {
+    not_handled,
+    handled,
+    transition
+};
+
 } // namespace fsmpp2::detail
 
 #endif // FSMPP2_HANDLE_RESULT_HPP
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef FSMPP2_DETAIL_MPSC_RING_HPP
+#define FSMPP2_DETAIL_MPSC_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace fsmpp2::detail
+{
+
+/**
+ * Bounded, lock-free multi-producer single-consumer ring buffer.
+ *
+ * Capacity must be a power of two. Every cell carries a sequence number telling
+ * whether it is free for the producer claiming a given position or filled for the
+ * consumer, producers claim positions with a CAS on the shared head index.
+ **/
+template<class T, std::size_t Capacity>
+class mpsc_ring {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static constexpr auto capacity = Capacity;
+
+    mpsc_ring() noexcept {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpsc_ring(mpsc_ring const&) = delete;
+    mpsc_ring& operator=(mpsc_ring const&) = delete;
+
+    /**
+     * Producer side, may be called from many threads: try to append an element,
+     * returns false if the ring is full.
+     **/
+    bool try_push(T const& value) noexcept {
+        auto pos = head_.load(std::memory_order_relaxed);
+        cell* c = nullptr;
+
+        while (true) {
+            c = &cells_[pos & (Capacity - 1)];
+            auto const seq = c->seq.load(std::memory_order_acquire);
+            auto const diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // the cell still holds an element from the previous lap
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+
+        c->value = value;
+        c->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer side: try to take the oldest element, returns false if the ring is empty
+     * (or the oldest element is still being written).
+     **/
+    bool try_pop(T& value) noexcept {
+        auto& c = cells_[tail_ & (Capacity - 1)];
+
+        if (c.seq.load(std::memory_order_acquire) != tail_ + 1) {
+            return false;
+        }
+
+        value = std::move(c.value);
+        c.seq.store(tail_ + Capacity, std::memory_order_release);
+        tail_ ++;
+        return true;
+    }
+
+private:
+    static constexpr std::size_t cache_line = 64;
+
+    struct cell {
+        std::atomic<std::size_t>    seq;
+        T                           value {};
+    };
+
+    alignas(cache_line) std::atomic<std::size_t>    head_ {0};
+    alignas(cache_line) std::size_t                 tail_ = 0;
+    alignas(cache_line) std::array<cell, Capacity>  cells_;
+};
+
+} // namespace fsmpp2::detail
+
+#endif // FSMPP2_DETAIL_MPSC_RING_HPP
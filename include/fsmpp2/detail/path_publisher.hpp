@@ -0,0 +1,197 @@
+#ifndef FSMPP2_DETAIL_PATH_PUBLISHER_HPP
+#define FSMPP2_DETAIL_PATH_PUBLISHER_HPP
+
+#include "fsmpp2/detail/state_tree.hpp"
+#include "fsmpp2/detail/tracer_calls.hpp"
+#include "fsmpp2/config.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace fsmpp2::detail
+{
+
+using path_id_type = std::uint32_t;
+
+#ifdef FSMPP2_USE_CPP20
+class async_slot;
+#endif
+
+struct level_entry;
+
+/**
+ * Active states of a state machine, readable from any thread.
+ *
+ * As every state has a single parent, id of the innermost active state encodes
+ * the whole active path. Only entries are published, the last entry of
+ * a transition is always the new innermost state.
+ **/
+template<class States, bool Regions = has_regions<States>::value>
+class active_states {
+public:
+    template<class S>
+    void enter() noexcept {
+        leaf_.store(static_cast<path_id_type>(state_id<S, States>()), std::memory_order_release);
+    }
+
+    template<class S>
+    void exit() noexcept {}
+
+    path_id_type leaf() const noexcept {
+        return leaf_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Checks if a state with a given id and subtree size is active.
+     **/
+    bool is_active(std::size_t id, std::size_t subtree_size) const noexcept {
+        // all the substates of a state have consecutive ids following its own id
+        return leaf() - id < subtree_size;
+    }
+
+private:
+    std::atomic<path_id_type> leaf_ {static_cast<path_id_type>(states_count<States>())};
+};
+
+/**
+ * With orthogonal regions there are many innermost states active at once,
+ * every state has its own bit set while it is active.
+ **/
+template<class States>
+class active_states<States, true> {
+    static constexpr auto words = (states_count<States>() + 63) / 64;
+
+public:
+    template<class S>
+    void enter() noexcept {
+        constexpr auto id = state_id<S, States>();
+        // single writer, no read-modify-write needed
+        auto& word = bits_[id / 64];
+        word.store(word.load(std::memory_order_relaxed) | (std::uint64_t{1} << id % 64), std::memory_order_release);
+    }
+
+    template<class S>
+    void exit() noexcept {
+        constexpr auto id = state_id<S, States>();
+        auto& word = bits_[id / 64];
+        word.store(word.load(std::memory_order_relaxed) & ~(std::uint64_t{1} << id % 64), std::memory_order_release);
+    }
+
+    bool is_active(std::size_t id, std::size_t) const noexcept {
+        return bits_[id / 64].load(std::memory_order_acquire) & (std::uint64_t{1} << id % 64);
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, words> bits_ {};
+};
+
+/**
+ * Tracer wrapper used by the state_machine, forwards all callbacks to the user
+ * tracer and publishes active states on every state entry and exit. It also
+ * gives state managers access to the deferred events of the state machine.
+ **/
+template<class States, class Tracer, class Deferred>
+class path_publisher {
+public:
+    using states_type = States;
+    using enter_type = level_entry (*)(void* manager, bool completing);
+
+    path_publisher(Tracer& tracer, active_states<States>& active, Deferred& deferred) noexcept
+        : tracer_ {tracer}
+        , active_ {active}
+        , deferred_ {deferred}
+    {}
+
+#ifdef FSMPP2_USE_CPP20
+    path_publisher(Tracer& tracer, active_states<States>& active, Deferred& deferred, async_slot* async) noexcept
+        : tracer_ {tracer}
+        , active_ {active}
+        , deferred_ {deferred}
+        , async_ {async}
+    {}
+
+    /**
+     * Slot for a suspended coroutine handler of the state machine.
+     **/
+    async_slot& async() noexcept {
+        return *async_;
+    }
+#endif
+
+    template<class S, class E>
+    void begin_event_handling() {
+        trace_begin<S, E>(tracer_);
+    }
+
+    template<class S, class E>
+    void end_event_handling(bool result) {
+        trace_end<S, E>(tracer_, result);
+    }
+
+    template<class From, class E, class To>
+    void transition() {
+        trace_transition<From, E, To>(tracer_);
+    }
+
+    template<class S>
+    void enter_state(S const& s) {
+        active_.template enter<S>();
+        trace_enter(tracer_, s);
+    }
+
+    template<class S>
+    void exit_state(S const& s) {
+        active_.template exit<S>();
+        deferred_.state_left();
+        trace_exit(tracer_, s);
+    }
+
+    /**
+     * Keeps an event deferred by an active state, false if there's no room for it.
+     **/
+    template<class E>
+    bool defer(E const& e) {
+        return deferred_.defer(e);
+    }
+
+    /**
+     * Keeps a transition to be made by the state manager of a given level (an ancestor
+     * of the requesting one), the first request is kept until it's taken.
+     **/
+    void request_transition(void const* level, enter_type enter) noexcept {
+        if (requested_level_ == nullptr) {
+            requested_level_ = level;
+            requested_enter_ = enter;
+        }
+    }
+
+    bool transition_requested() const noexcept {
+        return requested_level_ != nullptr;
+    }
+
+    /**
+     * Takes a transition requested for a given level, nullptr if there's none.
+     **/
+    enter_type take_transition(void const* level) noexcept {
+        if (requested_level_ != level) {
+            return nullptr;
+        }
+
+        requested_level_ = nullptr;
+        return requested_enter_;
+    }
+
+private:
+    Tracer&                 tracer_;
+    active_states<States>&  active_;
+    Deferred&               deferred_;
+    void const*             requested_level_ = nullptr;
+    enter_type              requested_enter_ = nullptr;
+#ifdef FSMPP2_USE_CPP20
+    async_slot*             async_ = nullptr;
+#endif
+};
+
+} // namespace fsmpp2::detail
+
+#endif // FSMPP2_DETAIL_PATH_PUBLISHER_HPP
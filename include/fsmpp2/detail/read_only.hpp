@@ -0,0 +1,84 @@
+#ifndef FSMPP2_DETAIL_READ_ONLY_HPP
+#define FSMPP2_DETAIL_READ_ONLY_HPP
+
+#include "fsmpp2/transitions.hpp"
+#include "fsmpp2/transition_table.hpp"
+#include "fsmpp2/detail/traits.hpp"
+#include "fsmpp2/detail/state_tree.hpp"
+#include "fsmpp2/detail/deferred_events.hpp"
+#include <type_traits>
+
+namespace fsmpp2::detail
+{
+
+template<class T> struct is_non_transitioning : std::false_type {};
+template<> struct is_non_transitioning<transitions<>> : std::true_type {};
+
+template<class S, class E, class = void>
+struct const_handle : std::false_type {};
+
+template<class S, class E>
+struct const_handle<S, E, std::void_t<decltype(std::declval<S const&>().handle(std::declval<E const&>()))>>
+    : is_non_transitioning<decltype(std::declval<S const&>().handle(std::declval<E const&>()))> {};
+
+template<class S, class E, class C, class = void>
+struct const_handle_with_context : std::false_type {};
+
+template<class S, class E, class C>
+struct const_handle_with_context<S, E, C, std::void_t<decltype(std::declval<S const&>().handle(std::declval<E const&>(), std::declval<C const&>()))>>
+    : is_non_transitioning<decltype(std::declval<S const&>().handle(std::declval<E const&>(), std::declval<C const&>()))> {};
+
+template<class S, class E, class C, class = void>
+struct mutable_handle_result { using type = transitions<>; };
+
+template<class S, class E, class C>
+struct mutable_handle_result<S, E, C, std::enable_if_t<can_handle_event<S, E>::value>> {
+    using type = decltype(std::declval<S&>().handle(std::declval<E const&>()));
+};
+
+template<class S, class E, class C>
+struct mutable_handle_result<S, E, C, std::enable_if_t<!can_handle_event<S, E>::value && can_handle_event_with_context<S, E, C>::value>> {
+    using type = decltype(std::declval<S&>().handle(std::declval<E const&>(), std::declval<C&>()));
+};
+
+template<class S, class E, class C>
+struct mutable_handle_result<S, E, C, std::enable_if_t<can_handle_event_in_table<S, E, C>::value>> {
+    using type = typename table_result<S, E>::type;
+};
+
+/**
+ * Checks if State handles an event E in a read-only manner: the handler is a const
+ * member function (taking the context, if any, by a const reference) which does
+ * not request a transition, ie. returns transitions<>. The handler picked for
+ * a non-const state must not request a transition either.
+ *
+ * A state not handling E at all is read-only too, unless it defers E or has
+ * transition_table rows for it.
+ **/
+template<class S, class E, class C>
+struct is_read_only_handler : std::bool_constant<
+    !defers_event<S, E>::value &&
+    !can_handle_event_in_table<S, E, C>::value &&
+    is_non_transitioning<typename mutable_handle_result<S, E, C>::type>::value && (
+        can_handle_event<S, E>::value
+            ? const_handle<S, E>::value
+            : (!can_handle_event_with_context<S, E, C>::value || const_handle_with_context<S, E, C>::value))
+> {};
+
+template<class E, class C, class StatesList>
+struct is_read_only_event_impl;
+
+template<class E, class C, class... S>
+struct is_read_only_event_impl<E, C, meta::type_list<S...>>
+    : std::bool_constant<(is_read_only_handler<S, E, C>::value && ...)> {};
+
+/**
+ * Checks if all the states (at every hierarchy level) handle an event E in a read-only manner,
+ * such an event can be dispatched to a const state machine.
+ **/
+template<class States, class E, class C>
+struct is_read_only_event : is_read_only_event_impl<E, C, typename all_states<States>::type> {};
+
+} // namespace fsmpp2::detail
+
+#endif // FSMPP2_DETAIL_READ_ONLY_HPP
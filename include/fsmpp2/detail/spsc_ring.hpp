@@ -0,0 +1,136 @@
+#ifndef FSMPP2_DETAIL_SPSC_RING_HPP
+#define FSMPP2_DETAIL_SPSC_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace fsmpp2::detail
+{
+
+/**
+ * Bounded, lock-free single-producer single-consumer ring buffer.
+ *
+ * Capacity must be a power of two. Producer and consumer indexes are kept on
+ * separate cache lines, each side caches the other side index and only reloads
+ * it when the ring looks full (producer) or empty (consumer).
+ **/
+template<class T, std::size_t Capacity>
+class spsc_ring {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static constexpr auto capacity = Capacity;
+
+    /**
+     * Producer side: try to append an element, returns false if the ring is full.
+     **/
+    bool try_push(T const& value) noexcept {
+        auto const head = head_.load(std::memory_order_relaxed);
+
+        if (head - cached_tail_ == Capacity) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+
+            if (head - cached_tail_ == Capacity) {
+                return false;
+            }
+        }
+
+        items_[head & (Capacity - 1)] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer side: try to take the oldest element, returns false if the ring is empty.
+     **/
+    bool try_pop(T& value) noexcept {
+        auto const tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+
+            if (tail == cached_head_) {
+                return false;
+            }
+        }
+
+        value = items_[tail & (Capacity - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Producer side: append up to count elements at once, returns the number of
+     * elements appended. All of them are published with a single store.
+     **/
+    std::size_t try_push(T const* values, std::size_t count) noexcept {
+        auto const head = head_.load(std::memory_order_relaxed);
+        auto free = Capacity - (head - cached_tail_);
+
+        if (free < count) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            free = Capacity - (head - cached_tail_);
+        }
+
+        auto const n = count < free ? count : free;
+
+        for (std::size_t i = 0; i < n; ++i) {
+            items_[(head + i) & (Capacity - 1)] = values[i];
+        }
+
+        if (n > 0) {
+            head_.store(head + n, std::memory_order_release);
+        }
+
+        return n;
+    }
+
+    /**
+     * Consumer side: take up to count oldest elements at once, returns the number
+     * of elements taken. Elements are moved out of the ring.
+     **/
+    std::size_t try_pop(T* values, std::size_t count) noexcept {
+        auto const tail = tail_.load(std::memory_order_relaxed);
+        auto available = cached_head_ - tail;
+
+        if (available < count) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            available = cached_head_ - tail;
+        }
+
+        auto const n = count < available ? count : available;
+
+        for (std::size_t i = 0; i < n; ++i) {
+            values[i] = std::move(items_[(tail + i) & (Capacity - 1)]);
+        }
+
+        if (n > 0) {
+            tail_.store(tail + n, std::memory_order_release);
+        }
+
+        return n;
+    }
+
+    /**
+     * Approximate number of elements, exact if called from producer or consumer
+     * while the other side is idle.
+     **/
+    std::size_t size() const noexcept {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr std::size_t cache_line = 64;
+
+    alignas(cache_line) std::atomic<std::size_t>    head_ {0};
+    std::size_t                                     cached_tail_ = 0;
+    alignas(cache_line) std::atomic<std::size_t>    tail_ {0};
+    std::size_t                                     cached_head_ = 0;
+    alignas(cache_line) std::array<T, Capacity>     items_ {};
+};
+
+} // namespace fsmpp2::detail
+
+#endif // FSMPP2_DETAIL_SPSC_RING_HPP
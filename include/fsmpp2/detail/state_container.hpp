@@ -54,6 +54,11 @@ public:
         std::visit(std::forward<F>(fun), states_);
     }
 
+    template<class F>
+    auto visit(F&& fun) const {
+        std::visit(std::forward<F>(fun), states_);
+    }
+
     template<class State>
     auto is_in() const {
         return std::holds_alternative<State>(states_);
@@ -5,10 +5,18 @@
 #include "fsmpp2/transitions.hpp"
 #include "fsmpp2/states.hpp"
 #include "fsmpp2/contexts.hpp"
+#include "fsmpp2/transition_table.hpp"
 #include "fsmpp2/config.hpp"
 #include "fsmpp2/detail/state_container.hpp"
 #include "fsmpp2/detail/substate_manager_container.hpp"
 #include "fsmpp2/detail/traits.hpp"
+#include "fsmpp2/detail/tracer_calls.hpp"
+#include "fsmpp2/detail/read_only.hpp"
+#include "fsmpp2/detail/deferred_events.hpp"
+#ifdef FSMPP2_USE_CPP20
+#include "fsmpp2/detail/async_runtime.hpp"
+#endif
+#include <utility>
 #include <variant>
 
 namespace fsmpp2::detail
@@ -22,6 +30,39 @@ struct NullTracer {
     void transition() {}
 };
 
+/**
+ * Root of the states hierarchy known to a tracer, transitions may target any state
+ * within it. A bare state_manager only knows its own level and the levels below.
+ **/
+template<class Tracer, class States, class = void>
+struct root_states { using type = States; };
+
+template<class Tracer, class States>
+struct root_states<Tracer, States, std::void_t<typename Tracer::states_type>> { using type = typename Tracer::states_type; };
+
+template<class Tracer, class = void>
+struct has_transition_requests : std::false_type {};
+
+template<class Tracer>
+struct has_transition_requests<Tracer, std::void_t<decltype(&Tracer::transition_requested)>> : std::true_type {};
+
+/**
+ * Unique address identifying a level (a states<> list) of the states hierarchy.
+ **/
+template<class States>
+struct level_key {
+    static constexpr char id = 0;
+};
+
+/**
+ * Type erased entry of a path of states on some level of the hierarchy. Entering it
+ * (with a state manager of that level) returns the entry of a completion transition
+ * to be made next, so a chain of completion transitions is followed in a loop.
+ **/
+struct level_entry {
+    level_entry (*enter)(void* manager, bool completing) = nullptr;
+};
+
 /**
  * Manages a set of state, creates, destroys and pass events to a proper state
  **/
@@ -39,22 +80,82 @@ public:
         enter_first();
     }
 
+    /**
+     * Enters a given path of nested states instead of the initial one.
+     **/
+    template<class... Path>
+    state_manager(Context &ctx, Tracer& tracer, meta::type_list<Path...> path)
+        : context_ {ctx}
+        , tracer_ {tracer}
+    {
+        enter_path(path);
+    }
+
     ~state_manager() {
         exit();
     }
 
     template<class T>
     void enter() {
-        exit();
+        enter_path(meta::type_list<T>{});
+    }
 
-        // create substate manager
-        substates_.template create<T>(context_, tracer_);
+    /**
+     * Enters T (a state of this level) and then the given substates of it, one on every
+     * level below. Substates not given are entered in their initial states.
+     **/
+    template<class T, class... Path>
+    void enter_path(meta::type_list<T, Path...>) {
+        follow(level_entry {&path_entry<meta::type_list<T, Path...>>});
+    }
+
+    /**
+     * Enters a path of states and returns the entry of a completion transition to be made
+     * next on this level, if any. If not completing, the completion check is skipped and
+     * a transition requested by a substate is dropped.
+     **/
+    template<class T, class... Path>
+    level_entry enter_step(meta::type_list<T, Path...>, bool completing) {
+        exit();
 
         // construct state
         emplace_state<T>(context_);
+
+        trace_enter(tracer_, states_.template state<T>());
+
+        // create substate manager, it enters its initial substate
+        if constexpr (sizeof...(Path) == 0) {
+            substates_.template create<T>(context_, tracer_);
+        } else {
+            auto path = meta::type_list<Path...>{};
+            substates_.template create<T>(context_, tracer_, path);
+        }
+
+        if (!completing) {
+            discard_requested_transition();
+            return {};
+        }
+
+        // a completion of a substate may have requested a transition on this level
+        if (transition_requested()) {
+            return take_requested_entry();
+        }
+
+        return complete<T>();
     }
 
     void exit() {
+        // substates are left first so the innermost state is always exited before its parent
+        substates_.reset();
+
+        states_.visit([this](auto &state) {
+            using S = std::remove_reference_t<decltype(state)>;
+
+            if constexpr (!std::is_same_v<S, std::monostate>) {
+                trace_exit(tracer_, state);
+            }
+        });
+
         states_.exit();
     }
 
@@ -62,20 +163,64 @@ public:
     auto dispatch(E const& e) {
         auto result = false;
 
+        // a leaf state has an empty substate manager, nothing to do there
+        if constexpr (States::count == 0) {
+            return result;
+        }
+
         substates_.visit(
             [this, &e, &result](auto &substate) {
                 result = substate_dispatch(substate, e);
             }
         );
 
+        // a transition requested by a substate for this level, a substate handled the event
+        take_requested_transition();
+
         if (result == false) {
             states_.visit([this, &e, &result](auto &state) {
-                tracer_.template begin_event_handling<
-                    std::remove_reference_t<decltype(state)>,
-                    std::remove_reference_t<decltype(e)>>();
+                using S = std::remove_reference_t<decltype(state)>;
+
+                if constexpr (defers_event<S, E>::value) {
+                    // replayed after the state machine leaves a state
+                    result = tracer_.defer(e);
+                } else if constexpr (!std::is_same_v<S, std::monostate>) {
+                    trace_begin<S, E>(tracer_);
 
-                result = handle(state, e);
-                tracer_.end_event_handling(result);
+                    result = handle(state, e);
+                    trace_end<S, E>(tracer_, result);
+                }
+            });
+        }
+
+        return result;
+    }
+
+    /**
+     * Dispatch an event without modifying the state machine.
+     *
+     * Only for events handled in a read-only manner by all the states (see is_read_only_event),
+     * it may be called concurrently from many threads. Tracer is not notified.
+     **/
+    template<class E>
+    auto dispatch(E const& e) const {
+        static_assert(is_read_only_event<States, E, Context>::value, "event handlers may modify a state or request a transition");
+
+        auto result = false;
+
+        if constexpr (States::count == 0) {
+            return result;
+        }
+
+        substates_.visit(
+            [&e, &result](auto const& substate) {
+                result = substate_dispatch(substate, e);
+            }
+        );
+
+        if (result == false) {
+            states_.visit([this, &e, &result](auto const& state) {
+                result = handle_read_only(state, e);
             });
         }
 
@@ -134,19 +279,100 @@ private:
         }
     }
 
+    /**
+     * Enters the states of an entry and follows completion transitions of entered states in a loop,
+     * so a chain of them does not grow the stack. At most FSMPP2_COMPLETION_DEPTH completion
+     * transitions are followed in a row, the last state entered is kept.
+     **/
+    void follow(level_entry next) {
+        for (unsigned count = 0; next.enter != nullptr; ++count) {
+            next = next.enter(this, count < FSMPP2_COMPLETION_DEPTH);
+        }
+    }
+
+    /**
+     * Runs the completion check of a just entered state, returns the entry of the transition
+     * it requests on this level, if any. Transitions to upper levels are requested instead.
+     **/
+    template<class T>
+    level_entry complete() {
+        if constexpr (has_completion<T>::value) {
+            return completion_entry<T>(states_.template state<T>().completion());
+        } else if constexpr (has_completion_with_context<T, Context>::value) {
+            return completion_entry<T>(states_.template state<T>().completion(context_));
+        } else {
+            return {};
+        }
+    }
+
+    bool transition_requested() const noexcept {
+        if constexpr (has_transition_requests<Tracer>::value) {
+            return tracer_.transition_requested();
+        } else {
+            return false;
+        }
+    }
+
+    void take_requested_transition() {
+        follow(take_requested_entry());
+    }
+
+    level_entry take_requested_entry() {
+        if constexpr (has_transition_requests<Tracer>::value) {
+            return level_entry {tracer_.take_transition(&level_key<States>::id)};
+        } else {
+            return {};
+        }
+    }
+
+    void discard_requested_transition() {
+        if constexpr (has_transition_requests<Tracer>::value) {
+            tracer_.take_transition(&level_key<States>::id);
+        }
+    }
+
+    template<class Path>
+    static level_entry path_entry(void* self, bool completing) {
+        return static_cast<state_manager*>(self)->enter_step(Path{}, completing);
+    }
+
+    template<class T, class... S>
+    level_entry completion_entry(transitions<S...> t) {
+        level_entry next;
+
+        if (t.is_transition()) {
+            handle_transition<T, fsmpp2::completion_event>(t, std::make_index_sequence<sizeof...(S)>{}, &next);
+        }
+
+        return next;
+    }
+
     template<class SS, class E>
-    bool substate_dispatch(SS& substate, E const &e) {
+    static bool substate_dispatch(SS& substate, E const &e) {
         return substate.dispatch(e);
     }
 
     template<class E>
-    bool substate_dispatch(std::monostate, E const&) {
+    static bool substate_dispatch(std::monostate, E const&) {
         return false;
     }
 
+    template<class S, class E>
+    bool handle_read_only(S const& state, E const& e) const {
+        if constexpr (std::is_same_v<S, std::monostate>) {
+            return false;
+        } else if constexpr (detail::can_handle_event<S, E>::value) {
+            return state.handle(e).is_handled();
+        } else if constexpr (detail::can_handle_event_with_context<S, E, Context>::value) {
+            return state.handle(e, std::as_const(context_)).is_handled();
+        } else {
+            return false;
+        }
+    }
+
     template<class S, class E>
     auto handle(S &state, E const& e) -> std::enable_if_t<detail::can_handle_event<S, E>::value, bool> {
-        if (handle_result(state.handle(e))) {
+        if (handle_result<S, E>(state.handle(e))) {
             return true;
         } else {
             return false;
@@ -155,50 +381,122 @@ private:
 
     template<class S, class E>
     auto handle(S &state, E const& e) -> std::enable_if_t<detail::can_handle_event_with_context<S, E, Context>::value, bool> {
-        if (handle_result(state.handle(e, context_))) {
+        if (handle_result<S, E>(state.handle(e, context_))) {
             return true;
         } else {
             return false;
         }
     }
 
+    template<class S, class E>
+    auto handle(S&, E const& e) -> std::enable_if_t<detail::can_handle_event_in_table<S, E, Context>::value, bool> {
+        using table = typename S::transition_table;
+        return handle_row<table, table::template first_row<S, E>(), S>(e);
+    }
+
     template<class S, class E>
     auto handle(S& state, E const& e) -> std::enable_if_t<
-            !detail::can_handle_event<S, E>::value && !detail::can_handle_event_with_context<S, E, Context>::value,
+            !detail::can_handle_event<S, E>::value && !detail::can_handle_event_with_context<S, E, Context>::value &&
+            !detail::can_handle_event_in_table<S, E, Context>::value,
     bool> {
         return false;
     }
 
+    // the first row with a passing guard is taken, rows are chained at compile time
+    template<class Table, std::size_t R, class S, class E>
+    bool handle_row(E const& e) {
+        using row = typename meta::type_list_type<R, typename Table::rows>::type;
+
+        if (!table_guard<typename row::guard>(e, context_)) {
+            if constexpr (Table::next_row(R) != Table::npos) {
+                return handle_row<Table, Table::next_row(R), S>(e);
+            } else {
+                return false;
+            }
+        }
+
+        table_action<typename row::action>(e, context_);
+
+        if constexpr (std::is_same_v<typename row::target, fsmpp2::none>) {
+            return true;
+        } else {
+            return handle_result<S, E>(transitions<typename row::target>{detail::transition<typename row::target>{}});
+        }
+    }
+
     // state handler declared a return transitions<> return type
-    template<class... T>
+    template<class S, class E, class... T>
     bool handle_result(transitions<T...> t) {
         if (t.is_transition()) {
-            handle_transition(t, std::make_index_sequence<sizeof...(T)>{});
+            handle_transition<S, E>(t, std::make_index_sequence<sizeof...(T)>{});
             return true;
         }
 
         return t.is_handled();
     }
 
-    template<class Transition, std::size_t... I>
-    void handle_transition(Transition trans, std::index_sequence<I...>) {
-        (handle_transition_impl<I>(trans), ...);
+#ifdef FSMPP2_USE_CPP20
+    // state handler is a coroutine, its result is applied when it completes
+    template<class S, class E, class R>
+    bool handle_result(task<R> t) {
+        static_assert(targets_this_level<S>(typename R::list{}), "coroutine handler may only transition within its own level and levels below");
+        return tracer_.async().start(std::move(t), &finish_task<S, E, R>, this);
+    }
+
+    template<class S, class E, class R>
+    static bool finish_task(void* self, std::coroutine_handle<> frame) {
+        // the frame is released before the state it refers to may be left
+        auto result = task<R>::adopt(frame).result();
+        return static_cast<state_manager*>(self)->template handle_result<S, E>(std::move(result));
+    }
+#endif
+
+    // a transition on this level is entered right away, or returned through next if given
+    template<class S, class E, class Transition, std::size_t... I>
+    void handle_transition(Transition trans, std::index_sequence<I...>, [[maybe_unused]] level_entry* next = nullptr) {
+        (handle_transition_impl<I, S, E>(trans, next), ...);
     }
 
-    template<std::size_t I, class Transition>
-    void handle_transition_impl(Transition trans) {
+    template<std::size_t I, class S, class E, class Transition>
+    void handle_transition_impl(Transition trans, level_entry* next) {
         if (trans.idx == I) {
             using transition_type_list = typename Transition::list;
             using type_at_index = typename meta::type_list_type<I, transition_type_list>::type;
+            using route = transition_route<S, type_at_index, root>;
+
+            static_assert(!std::is_void_v<typename route::level>, "transition target is not a state of this state machine");
+            static_assert(!route::crosses_regions, "transition can't leave an orthogonal region of a parallel_state for another one");
+
+            trace_transition<S, E, type_at_index>(tracer_);
+
+            if constexpr (std::is_void_v<typename route::level>) {
+                return;
+            } else if constexpr (std::is_same_v<typename route::level, States>) {
+                if (next) {
+                    *next = level_entry {&path_entry<typename route::path>};
+                } else {
+                    enter_path(typename route::path{});
+                }
+            } else {
+                // the least common ancestor is above, its state manager makes the transition
+                static_assert(has_transition_requests<Tracer>::value, "transition to a state on an upper level requires a state_machine");
 
-            if constexpr (meta::type_list_has<type_at_index>(type_list{})) {
-                tracer_.template transition<type_at_index>();
-                enter<type_at_index>();
+                using level_manager = state_manager<typename route::level, Context, Tracer>;
+                tracer_.request_transition(&level_key<typename route::level>::id, &level_manager::template path_entry<typename route::path>);
             }
         }
     }
 
+    template<class S, class... T>
+    static constexpr bool targets_this_level(meta::type_list<T...>) {
+        return (std::is_same_v<typename transition_route<S, T, root>::level, States> && ...);
+    }
+
 private:
+    template<class, class, class> friend struct state_manager;
+
+    using root = typename root_states<Tracer, States>::type;
+
     template<class X>
     using SelfWrapper = state_manager<X, Context, Tracer>;
 
@@ -211,6 +509,106 @@ private:
     Tracer&                 tracer_;
 };
 
+template<std::size_t I, class Manager>
+struct region_slot {
+    template<class Context, class Tracer>
+    region_slot(Context& ctx, Tracer& tracer)
+        : manager {ctx, tracer}
+    {}
+
+    Manager manager;
+};
+
+template<class Indexes, class... Managers> struct region_slots;
+
+template<std::size_t... I, class... Managers>
+struct region_slots<std::index_sequence<I...>, Managers...> : region_slot<I, Managers>... {
+    // base classes are constructed in order and destructed in reverse order,
+    // so regions are entered first to last and exited last to first
+    template<class Context, class Tracer>
+    region_slots(Context& ctx, Tracer& tracer)
+        : region_slot<I, Managers> {ctx, tracer}...
+    {}
+};
+
+/**
+ * Manages orthogonal regions of a parallel_state, every region has its own
+ * state_manager and all of them are active at once.
+ **/
+template<class... R, class Context, class Tracer>
+struct state_manager<fsmpp2::regions<R...>, Context, Tracer>
+{
+public:
+    state_manager(Context& ctx, Tracer& tracer)
+        : regions_ {ctx, tracer}
+    {}
+
+    template<class... Path>
+    state_manager(Context& ctx, Tracer& tracer, meta::type_list<Path...>)
+        : regions_ {ctx, tracer}
+    {
+        static_assert(sizeof...(Path) == 0, "transition can't enter a state inside orthogonal regions of a parallel_state");
+    }
+
+    /**
+     * Pass an event to every region which has a state handling it (decided at compile time),
+     * the event is handled if any of the regions handled it.
+     **/
+    template<class E>
+    bool dispatch(E const& e) {
+#ifdef FSMPP2_USE_CPP20
+        // a state machine suspends one coroutine handler at a time
+        static_assert((0 + ... + int(any_async_handler<Context, typename all_states<R>::type, E>::value)) <= 1,
+            "at most one region of a parallel_state may handle an event with a coroutine");
+#endif
+        return dispatch_regions(*this, e, std::index_sequence_for<R...>{});
+    }
+
+    template<class E>
+    bool dispatch(E const& e) const {
+        return dispatch_regions(*this, e, std::index_sequence_for<R...>{});
+    }
+
+private:
+    template<class Self, class E, std::size_t... I>
+    static bool dispatch_regions(Self& self, E const& e, std::index_sequence<I...>) {
+        auto result = false;
+        // every region gets the event, no short-circuit
+        ((result = self.template dispatch_region<I, R>(e) || result), ...);
+        return result;
+    }
+
+    template<std::size_t I, class Region, class E>
+    bool dispatch_region(E const& e) {
+        if constexpr (any_state_handles<Region, E, Context>::value) {
+            return region<I, Region>().dispatch(e);
+        } else {
+            return false;
+        }
+    }
+
+    template<std::size_t I, class Region, class E>
+    bool dispatch_region(E const& e) const {
+        if constexpr (any_state_handles<Region, E, Context>::value) {
+            return region<I, Region>().dispatch(e);
+        } else {
+            return false;
+        }
+    }
+
+    template<std::size_t I, class Region>
+    auto& region() noexcept {
+        return static_cast<region_slot<I, state_manager<Region, Context, Tracer>>&>(regions_).manager;
+    }
+
+    template<std::size_t I, class Region>
+    auto const& region() const noexcept {
+        return static_cast<region_slot<I, state_manager<Region, Context, Tracer>> const&>(regions_).manager;
+    }
+
+    region_slots<std::index_sequence_for<R...>, state_manager<R, Context, Tracer>...> regions_;
+};
+
 } // namespace fsmpp2::detail
 
 #endif // FSMPP2_DETAIL_STATE_MANAGER_HPP
\ No newline at end of file
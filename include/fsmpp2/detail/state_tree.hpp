@@ -0,0 +1,227 @@
+#ifndef FSMPP2_DETAIL_STATE_TREE_HPP
+#define FSMPP2_DETAIL_STATE_TREE_HPP
+
+#include "fsmpp2/meta.hpp"
+#include "fsmpp2/states.hpp"
+#include "fsmpp2/detail/traits.hpp"
+#include <array>
+
+namespace fsmpp2::detail
+{
+
+/**
+ * Flattens a states<> hierarchy into a single type_list.
+ *
+ * States are listed depth-first, every state is followed by all of its
+ * substates, eg. states<A, B> where A is state<A1, A2> gives type_list<A, A1, A2, B>.
+ * The position of a state in this list is used as its compact, machine-wide id.
+ **/
+template<class States> struct all_states;
+
+template<class... S>
+struct all_states<fsmpp2::states<S...>> {
+    using type = typename meta::type_list_concat<
+        typename meta::type_list_concat<
+            meta::type_list<S>,
+            typename all_states<typename S::substates_type>::type
+        >::result...
+    >::result;
+};
+
+template<class... R>
+struct all_states<fsmpp2::regions<R...>> {
+    using type = typename meta::type_list_concat<typename all_states<R>::type...>::result;
+};
+
+template<class T, class States> struct state_path;
+
+template<class... Candidates>
+struct first_state_path {
+    using type = void;
+    using level = void;
+};
+
+template<class First, class... Rest>
+struct first_state_path<First, Rest...>
+    : std::conditional_t<std::is_void_v<typename First::type>, first_state_path<Rest...>, First> {};
+
+template<class S, class SubPath> struct prepend_state { using type = typename meta::type_list_push_front<SubPath, S>::result; };
+template<class S> struct prepend_state<S, void> { using type = void; };
+
+template<class T, class S, class Level>
+struct state_path_in {
+    using sub = state_path<T, typename S::substates_type>;
+    using type = std::conditional_t<std::is_same_v<S, T>, meta::type_list<S>, typename prepend_state<S, typename sub::type>::type>;
+    using level = std::conditional_t<std::is_same_v<S, T>, Level, typename sub::level>;
+};
+
+/**
+ * Path of nested states leading to a state T: type_list of a top level state,
+ * its substate and so on down to T itself, void if T is not in States hierarchy.
+ * level is the states<> list T directly belongs to.
+ **/
+template<class T, class... S>
+struct state_path<T, fsmpp2::states<S...>> : first_state_path<state_path_in<T, S, fsmpp2::states<S...>>...> {};
+
+template<class T, class... R>
+struct state_path<T, fsmpp2::regions<R...>> : first_state_path<state_path<T, R>...> {};
+
+template<class PathS, class PathT>
+struct transition_route_impl {
+    using source = typename meta::type_list_first<PathS>::type;
+    using path = PathT;
+};
+
+// strip the common ancestors, the state being left and the one being entered are below them
+template<class A, class S, class... SR, class T, class... TR>
+struct transition_route_impl<meta::type_list<A, S, SR...>, meta::type_list<A, T, TR...>>
+    : transition_route_impl<meta::type_list<S, SR...>, meta::type_list<T, TR...>> {};
+
+/**
+ * Exit/entry sequence of a transition from a state S to a state T anywhere in Root
+ * hierarchy, below their least common ancestor: source is the state left (with all
+ * its active substates), path lists the states entered from the outermost to T,
+ * level is the states<> list source belongs to, the first state of path belongs to it
+ * as well unless the transition crosses orthogonal regions of a parallel_state.
+ *
+ * A state transitioning to itself, its ancestor or its descendant is left as well.
+ * level is void if T is not in Root hierarchy.
+ **/
+template<class S, class T, class Root, class PathT = typename state_path<T, Root>::type>
+struct transition_route : transition_route_impl<typename state_path<S, Root>::type, PathT> {
+    using level = typename state_path<typename transition_route::source, Root>::level;
+
+    // source and the first state entered are in different orthogonal regions
+    static constexpr bool crosses_regions = !meta::type_list_has<typename meta::type_list_first<typename transition_route::path>::type>(
+        typename level::type_list{});
+};
+
+template<class S, class T, class Root>
+struct transition_route<S, T, Root, void> {
+    using source = S;
+    using path = meta::type_list<T>;
+    using level = void;
+    static constexpr bool crosses_regions = false;
+};
+
+/**
+ * Checks if there is a parallel_state anywhere in States hierarchy.
+ **/
+template<class States> struct has_regions;
+
+template<class... S>
+struct has_regions<fsmpp2::states<S...>> : std::bool_constant<(has_regions<typename S::substates_type>::value || ...)> {};
+
+template<class... R>
+struct has_regions<fsmpp2::regions<R...>> : std::true_type {};
+
+/**
+ * Checks if any of the states within States hierarchy handles or defers event E.
+ **/
+template<class States, class E, class Context, class = typename all_states<States>::type>
+struct any_state_handles;
+
+template<class States, class E, class Context, class... S>
+struct any_state_handles<States, E, Context, meta::type_list<S...>>
+    : std::bool_constant<((can_handle_event<S, E>::value || can_handle_event_with_context<S, E, Context>::value || can_handle_event_in_table<S, E, Context>::value ||
+        defers_event<S, E>::value) || ...)> {};
+
+/**
+ * Machine-wide id of a State within States hierarchy.
+ **/
+template<class State, class States>
+constexpr std::size_t state_id() {
+    return meta::type_list_index<State>(typename all_states<States>::type{});
+}
+
+/**
+ * Total number of states within States hierarchy (all levels).
+ **/
+template<class States>
+constexpr std::size_t states_count() {
+    return meta::type_list_size(typename all_states<States>::type{});
+}
+
+template<std::size_t N, class... R>
+constexpr void fill_state_depths(fsmpp2::regions<R...>, std::array<std::size_t, N>& out, std::size_t& idx, std::size_t depth);
+
+template<std::size_t N, class... R>
+constexpr std::size_t fill_state_subtrees(fsmpp2::regions<R...>, std::array<std::size_t, N>& sizes, std::array<std::size_t, N>& parents, std::size_t& idx, std::size_t parent);
+
+template<std::size_t N, class... S>
+constexpr void fill_state_depths(fsmpp2::states<S...>, std::array<std::size_t, N>& out, std::size_t& idx, std::size_t depth) {
+    ((out[idx ++] = depth, fill_state_depths(typename S::substates_type{}, out, idx, depth + 1)), ...);
+}
+
+template<std::size_t N, class... R>
+constexpr void fill_state_depths(fsmpp2::regions<R...>, std::array<std::size_t, N>& out, std::size_t& idx, std::size_t depth) {
+    (fill_state_depths(R{}, out, idx, depth), ...);
+}
+
+/**
+ * Depth (hierarchy level) of every state, indexed by state id. Top level states have depth 0.
+ **/
+template<class States>
+constexpr auto state_depths() {
+    std::array<std::size_t, states_count<States>()> result {};
+    std::size_t idx = 0;
+    fill_state_depths(States{}, result, idx, 0);
+    return result;
+}
+
+template<std::size_t N, class... S>
+constexpr std::size_t fill_state_subtrees(fsmpp2::states<S...>, std::array<std::size_t, N>& sizes, std::array<std::size_t, N>& parents, std::size_t& idx, [[maybe_unused]] std::size_t parent) {
+    std::size_t total = 0;
+
+    ((total += [&] {
+        auto const self = idx ++;
+        parents[self] = parent;
+        sizes[self] = 1 + fill_state_subtrees(typename S::substates_type{}, sizes, parents, idx, self);
+        return sizes[self];
+    }()), ...);
+
+    return total;
+}
+
+template<std::size_t N, class... R>
+constexpr std::size_t fill_state_subtrees(fsmpp2::regions<R...>, std::array<std::size_t, N>& sizes, std::array<std::size_t, N>& parents, std::size_t& idx, std::size_t parent) {
+    std::size_t total = 0;
+    ((total += fill_state_subtrees(R{}, sizes, parents, idx, parent)), ...);
+    return total;
+}
+
+template<class States>
+struct state_subtrees {
+    static constexpr auto count = states_count<States>();
+
+    std::array<std::size_t, count> sizes {};
+    std::array<std::size_t, count> parents {};
+
+    constexpr state_subtrees() {
+        std::size_t idx = 0;
+        fill_state_subtrees(States{}, sizes, parents, idx, count);
+    }
+};
+
+/**
+ * Number of states in a subtree of every state (including the state itself), indexed by state id.
+ *
+ * A state and all its substates have consecutive ids, a state with id I is
+ * active if the innermost active state has an id in range [I, I + size).
+ **/
+template<class States>
+constexpr auto state_subtree_sizes() {
+    return state_subtrees<States>{}.sizes;
+}
+
+/**
+ * Id of a parent of every state, indexed by state id. Top level states have states_count<States>() as a parent.
+ **/
+template<class States>
+constexpr auto state_parents() {
+    return state_subtrees<States>{}.parents;
+}
+
+} // namespace fsmpp2::detail
+
+#endif // FSMPP2_DETAIL_STATE_TREE_HPP
@@ -25,6 +25,13 @@ public:
         managers_.template emplace<1 + Index>(args...);
     }
 
+    /**
+     * Destroy current substate manager (if any), leaving all its states.
+     **/
+    void reset() {
+        managers_.template emplace<0>();
+    }
+
     /**
      * Visit current state_manager with a given visitor.
      **/
@@ -33,6 +40,11 @@ public:
         std::visit(std::forward<Fun>(fun), managers_);
     }
 
+    template<class Fun>
+    void visit(Fun&& fun) const {
+        std::visit(std::forward<Fun>(fun), managers_);
+    }
+
 private:
     // a list of states: type_list<A, B, C...>;
     using type_list = typename States::type_list;
@@ -0,0 +1,66 @@
+#ifndef FSMPP2_DETAIL_TRACER_CALLS_HPP
+#define FSMPP2_DETAIL_TRACER_CALLS_HPP
+
+#include "fsmpp2/detail/traits.hpp"
+#include <type_traits>
+
+namespace fsmpp2::detail
+{
+
+/**
+ * Tracer callbacks invoked by the state_manager.
+ *
+ * Required callbacks are begin_event_handling<State, E>(), end_event_handling(bool)
+ * and transition<To>(). A tracer may instead implement typed forms
+ * end_event_handling<State, E>(bool) and transition<From, E, To>() which carry
+ * all the types involved, optional enter_state/exit_state hooks and begin_dispatch()
+ * called by a state_machine before every event. These helpers
+ * pick the best form the tracer provides, all at compile time.
+ **/
+template<class Tracer>
+void trace_dispatch(Tracer& tracer) {
+    if constexpr (has_dispatch_hook<Tracer>::value) {
+        tracer.begin_dispatch();
+    }
+}
+
+template<class State, class E, class Tracer>
+void trace_begin(Tracer& tracer) {
+    tracer.template begin_event_handling<State, E>();
+}
+
+template<class State, class E, class Tracer>
+void trace_end(Tracer& tracer, bool result) {
+    if constexpr (has_typed_end_event_handling<Tracer, State, E>::value) {
+        tracer.template end_event_handling<State, E>(result);
+    } else {
+        tracer.end_event_handling(result);
+    }
+}
+
+template<class From, class E, class To, class Tracer>
+void trace_transition(Tracer& tracer) {
+    if constexpr (has_typed_transition<Tracer, From, E, To>::value) {
+        tracer.template transition<From, E, To>();
+    } else {
+        tracer.template transition<To>();
+    }
+}
+
+template<class State, class Tracer>
+void trace_enter(Tracer& tracer, State const& state) {
+    if constexpr (has_state_hooks<Tracer, State>::value) {
+        tracer.template enter_state<State>(state);
+    }
+}
+
+template<class State, class Tracer>
+void trace_exit(Tracer& tracer, State const& state) {
+    if constexpr (has_state_hooks<Tracer, State>::value) {
+        tracer.template exit_state<State>(state);
+    }
+}
+
+} // namespace fsmpp2::detail
+
+#endif // FSMPP2_DETAIL_TRACER_CALLS_HPP
@@ -34,6 +34,153 @@ public:
     static constexpr auto value = std::is_same_v<std::true_type, decltype(test<T>(0))>;
 };
 
+/**
+ * Detects transition_table rows for a state T and an event E, used when T declares:
+ *
+ *      using transition_table = fsmpp2::transition_table<...>;
+ *
+ * and has no handle() overload for E.
+ **/
+template<class T, class E, class C, class = void>
+struct can_handle_event_in_table : std::false_type {};
+
+template<class T, class E, class C>
+struct can_handle_event_in_table<T, E, C, std::void_t<typename T::transition_table>> : std::bool_constant<
+    !can_handle_event<T, E>::value &&
+    !can_handle_event_with_context<T, E, C>::value &&
+    T::transition_table::template has_rows<T, E>()> {};
+
+template<class S, class = void>
+struct state_deferred_events { using type = meta::type_list<>; };
+
+template<class S>
+struct state_deferred_events<S, std::void_t<typename S::deferred_events>> { using type = typename S::deferred_events; };
+
+template<class E, class List> struct list_contains;
+template<class E, class... L> struct list_contains<E, meta::type_list<L...>> : meta::type_pack_contains<E, L...> {};
+
+/**
+ * Checks if a state S defers an event E, ie. declares:
+ *
+ *      using deferred_events = fsmpp2::events<E, ...>;
+ **/
+template<class S, class E>
+struct defers_event : list_contains<E, typename state_deferred_events<S>::type> {};
+
+/**
+ * Detects a completion check of a state, called right after it is entered:
+ *
+ *      auto completion() -> transitions<...>;
+ *      auto completion(Context&) -> transitions<...>;
+ **/
+template<class T>
+class has_completion
+{
+    template<class U>
+    static auto test(int) -> decltype(std::declval<U&>().completion(), std::true_type{});
+
+    template<class>
+    static std::false_type test(...);
+
+public:
+    static constexpr auto value = std::is_same_v<std::true_type, decltype(test<T>(0))>;
+};
+
+template<class T, class C>
+class has_completion_with_context
+{
+    static C& get_context() noexcept;
+
+    template<class U>
+    static auto test(int) -> decltype(std::declval<U&>().completion(get_context()), std::true_type{});
+
+    template<class>
+    static std::false_type test(...);
+
+public:
+    static constexpr auto value = std::is_same_v<std::true_type, decltype(test<T>(0))>;
+};
+
+/**
+ * Detects optional Tracer hooks called when a State is entered and exited:
+ *
+ *      template<class State> void enter_state(State const&);
+ *      template<class State> void exit_state(State const&);
+ **/
+template<class T, class S>
+class has_state_hooks
+{
+    template<class U>
+    static auto test(int) -> decltype(
+        std::declval<U&>().template enter_state<S>(std::declval<S const&>()),
+        std::declval<U&>().template exit_state<S>(std::declval<S const&>()),
+        std::true_type{});
+
+    template<class>
+    static std::false_type test(...);
+
+public:
+    static constexpr auto value = std::is_same_v<std::true_type, decltype(test<T>(0))>;
+};
+
+/**
+ * Detects optional Tracer hook called by a state_machine before an event is dispatched:
+ *
+ *      void begin_dispatch();
+ **/
+template<class T>
+class has_dispatch_hook
+{
+    template<class U>
+    static auto test(int) -> decltype(std::declval<U&>().begin_dispatch(), std::true_type{});
+
+    template<class>
+    static std::false_type test(...);
+
+public:
+    static constexpr auto value = std::is_same_v<std::true_type, decltype(test<T>(0))>;
+};
+
+/**
+ * Detects optional typed form of end_event_handling callback:
+ *
+ *      template<class State, class E> void end_event_handling(bool);
+ **/
+template<class T, class S, class E>
+class has_typed_end_event_handling
+{
+    template<class U>
+    static auto test(int) -> decltype(
+        std::declval<U&>().template end_event_handling<S, E>(true),
+        std::true_type{});
+
+    template<class>
+    static std::false_type test(...);
+
+public:
+    static constexpr auto value = std::is_same_v<std::true_type, decltype(test<T>(0))>;
+};
+
+/**
+ * Detects optional typed form of transition callback:
+ *
+ *      template<class From, class E, class To> void transition();
+ **/
+template<class T, class From, class E, class To>
+class has_typed_transition
+{
+    template<class U>
+    static auto test(int) -> decltype(
+        std::declval<U&>().template transition<From, E, To>(),
+        std::true_type{});
+
+    template<class>
+    static std::false_type test(...);
+
+public:
+    static constexpr auto value = std::is_same_v<std::true_type, decltype(test<T>(0))>;
+};
+
 } // namespace fsmpp2::detail
 
 #endif // FSMPP_DETAIL_TRAITS_HPP
\ No newline at end of file
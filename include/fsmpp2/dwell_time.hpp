@@ -0,0 +1,132 @@
+#ifndef FSMPP2_DWELL_TIME_HPP
+#define FSMPP2_DWELL_TIME_HPP
+
+#include "fsmpp2/detail/state_tree.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace fsmpp2
+{
+
+/**
+ * Dwell-time statistics of a single state.
+ *
+ * Histogram bucket I counts visits which lasted [2^I, 2^(I+1)) clock ticks,
+ * bucket 0 also counts visits shorter than one tick.
+ **/
+template<class Duration>
+struct dwell_time_stats {
+    static constexpr std::size_t buckets = 64;
+
+    std::uint64_t                       visits = 0;
+    Duration                            total = Duration::zero();
+    Duration                            min = Duration::max();
+    Duration                            max = Duration::zero();
+    std::array<std::uint64_t, buckets>  histogram {};
+
+    void record(Duration d) noexcept {
+        visits ++;
+        total += d;
+
+        if (d < min) min = d;
+        if (d > max) max = d;
+
+        histogram[bucket(d)] ++;
+    }
+
+    static std::size_t bucket(Duration d) noexcept {
+        auto const ticks = d.count() > 0 ? static_cast<std::uint64_t>(d.count()) : std::uint64_t{0};
+
+        if (ticks == 0) {
+            return 0;
+        }
+
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(ticks);
+#else
+        std::size_t idx = 0;
+        for (auto t = ticks; t >>= 1; ) idx ++;
+        return idx;
+#endif
+    }
+};
+
+/**
+ * Tracer measuring how long the state machine stays in each state.
+ *
+ * Every state of the States hierarchy (all levels) has its own statistics. The
+ * clock is read once per transition made while handling an event, all the states
+ * left and entered by that transition share the same timestamp. Other entries and
+ * exits read the clock on their own.
+ *
+ * When not used, the state_manager does not call any enter/exit hooks so there's
+ * no cost involved.
+ **/
+template<class States, class Clock = std::chrono::steady_clock>
+class dwell_time_tracer {
+public:
+    using duration = typename Clock::duration;
+    using time_point = typename Clock::time_point;
+    using stats_type = dwell_time_stats<duration>;
+
+    /**
+     * Gets statistics of a given state.
+     **/
+    template<class State>
+    stats_type const& stats() const noexcept {
+        return entries_[detail::state_id<State, States>()].stats;
+    }
+
+    template<class State, class E>
+    void begin_event_handling() {
+        handling_ ++;
+    }
+
+    void end_event_handling(bool) {
+        if (-- handling_ == 0) {
+            stamped_ = false;
+        }
+    }
+
+    template<class State>
+    void transition() {
+        // transitions made outside of event handling (completion transitions of initial
+        // states, resumed coroutine handlers) have no end to drop the timestamp
+        if (handling_ > 0) {
+            now_ = Clock::now();
+            stamped_ = true;
+        }
+    }
+
+    template<class State>
+    void enter_state(State const&) {
+        entries_[detail::state_id<State, States>()].entered = now();
+    }
+
+    template<class State>
+    void exit_state(State const&) {
+        auto& entry = entries_[detail::state_id<State, States>()];
+        entry.stats.record(now() - entry.entered);
+    }
+
+private:
+    time_point now() {
+        // outside of a transition made while handling an event
+        return stamped_ ? now_ : Clock::now();
+    }
+
+    struct entry {
+        time_point entered {};
+        stats_type stats;
+    };
+
+    std::array<entry, detail::states_count<States>()>   entries_;
+    time_point                                          now_ {};
+    bool                                                stamped_ = false;
+    unsigned                                            handling_ = 0;
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_DWELL_TIME_HPP
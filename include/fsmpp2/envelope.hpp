@@ -0,0 +1,349 @@
+#ifndef FSMPP2_ENVELOPE_HPP
+#define FSMPP2_ENVELOPE_HPP
+
+#include "fsmpp2/meta.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fsmpp2
+{
+
+/**
+ * Pool of fixed size memory blocks for events which do not fit inline in an envelope.
+ *
+ * All the memory is allocated up front, allocate() and deallocate() are thread-safe.
+ **/
+class envelope_arena {
+    struct node {
+        node* next;
+    };
+
+public:
+    envelope_arena(std::size_t block_size, std::size_t blocks)
+        : block_size_ {round_up(block_size < sizeof(node) ? sizeof(node) : block_size)}
+        , memory_ {new std::max_align_t[block_size_ / sizeof(std::max_align_t) * blocks]}
+        , available_ {blocks}
+    {
+        auto* bytes = reinterpret_cast<unsigned char*>(memory_.get());
+
+        for (std::size_t i = blocks; i-- > 0; ) {
+            free_ = new (bytes + i * block_size_) node {free_};
+        }
+    }
+
+    envelope_arena(envelope_arena const&) = delete;
+    envelope_arena& operator=(envelope_arena const&) = delete;
+
+    /**
+     * Takes a block, throws std::bad_alloc if there are no free blocks.
+     **/
+    void* allocate() {
+        std::lock_guard<std::mutex> lock {mutex_};
+
+        if (free_ == nullptr) {
+            throw std::bad_alloc {};
+        }
+
+        auto* block = free_;
+        free_ = free_->next;
+        available_ --;
+        return block;
+    }
+
+    void deallocate(void* block) noexcept {
+        std::lock_guard<std::mutex> lock {mutex_};
+        free_ = new (block) node {free_};
+        available_ ++;
+    }
+
+    std::size_t block_size() const noexcept {
+        return block_size_;
+    }
+
+    /**
+     * Number of free blocks.
+     **/
+    std::size_t available() const {
+        std::lock_guard<std::mutex> lock {mutex_};
+        return available_;
+    }
+
+private:
+    static constexpr std::size_t round_up(std::size_t size) noexcept {
+        constexpr auto align = sizeof(std::max_align_t);
+        return (size + align - 1) / align * align;
+    }
+
+    std::size_t                         block_size_;
+    std::unique_ptr<std::max_align_t[]> memory_;
+    node*                               free_ = nullptr;
+    std::size_t                         available_;
+    mutable std::mutex                  mutex_;
+};
+
+namespace detail
+{
+
+template<class Events> struct max_event_size;
+template<class... E> struct max_event_size<meta::type_list<E...>> {
+    static constexpr std::size_t value = std::max({std::size_t{1}, sizeof(E)...});
+};
+
+} // namespace detail
+
+/**
+ * Type-erased container for any event from an events list.
+ *
+ * Holds an event id and inline storage of InlineSize bytes (by default the size of
+ * the largest event, so no event needs extra memory). Events larger than InlineSize
+ * are placed in a block of an envelope_arena, this way a queue can keep envelopes
+ * small if there are a few large, rare events. Neither way allocates from the heap.
+ *
+ * dispatch() calls the state machine through a table of functions indexed by
+ * the event id.
+ *
+ *      fsmpp2::envelope<Events> env {TimeElapsed{1s}};
+ *      env.dispatch(sm);
+ **/
+template<class Events, std::size_t InlineSize = detail::max_event_size<Events>::value>
+class envelope;
+
+template<class... E, std::size_t InlineSize>
+class envelope<meta::type_list<E...>, InlineSize> {
+    static_assert(sizeof...(E) > 0, "empty events list");
+    static_assert((std::is_nothrow_move_constructible_v<E> && ...), "events must be nothrow move constructible");
+
+    struct remote {
+        void*           ptr;
+        envelope_arena* arena;
+    };
+
+    template<class Ev>
+    static constexpr bool fits = sizeof(Ev) <= InlineSize;
+
+    static constexpr bool any_remote = !(fits<E> && ...);
+
+    static constexpr std::size_t storage_size = std::max({
+        InlineSize, any_remote ? sizeof(remote) : std::size_t{1}});
+
+    static constexpr std::size_t storage_align = std::max({
+        alignof(remote), (fits<E> ? alignof(E) : std::size_t{1})...});
+
+public:
+    using events_type = meta::type_list<E...>;
+
+    /**
+     * Id of an event type, 0 stands for an empty envelope.
+     **/
+    template<class Ev>
+    static constexpr std::size_t id_of() noexcept {
+        static_assert(meta::type_pack_contains<Ev, E...>::value, "event is not on the events list");
+        return meta::type_list_index<Ev>(events_type{}) + 1;
+    }
+
+    /**
+     * Checks if an event type is kept inline (otherwise it needs an arena).
+     **/
+    template<class Ev>
+    static constexpr bool is_inline() noexcept {
+        return fits<Ev>;
+    }
+
+    envelope() noexcept = default;
+
+    /**
+     * Creates an envelope with an event stored inline.
+     **/
+    template<class Ev, class = std::enable_if_t<meta::type_pack_contains<Ev, E...>::value>>
+    envelope(Ev const& e) {
+        static_assert(fits<Ev>, "event does not fit inline, an arena is required");
+        new (storage_) Ev(e);
+        id_ = static_cast<std::uint32_t>(id_of<Ev>());
+    }
+
+    /**
+     * Creates an envelope with an event stored inline or in a block of the arena.
+     * Throws std::bad_alloc if the event is too large for the arena blocks or the
+     * arena is exhausted.
+     **/
+    template<class Ev, class = std::enable_if_t<meta::type_pack_contains<Ev, E...>::value>>
+    envelope(Ev const& e, envelope_arena* arena) {
+        if constexpr (fits<Ev>) {
+            new (storage_) Ev(e);
+        } else {
+            if (arena == nullptr || arena->block_size() < sizeof(Ev) || alignof(Ev) > alignof(std::max_align_t)) {
+                throw std::bad_alloc {};
+            }
+
+            auto* block = arena->allocate();
+            new (block) Ev(e);
+            new (storage_) remote {block, arena};
+        }
+
+        id_ = static_cast<std::uint32_t>(id_of<Ev>());
+    }
+
+    envelope(envelope const& other) {
+        if (other.id_ != 0) {
+            copy_table[other.id_ - 1](*this, other);
+            id_ = other.id_;
+        }
+    }
+
+    envelope(envelope&& other) noexcept {
+        if (other.id_ != 0) {
+            move_table[other.id_ - 1](*this, other);
+            id_ = other.id_;
+            other.id_ = 0;
+        }
+    }
+
+    envelope& operator=(envelope const& other) {
+        if (this != &other) {
+            envelope tmp {other};
+            *this = std::move(tmp);
+        }
+
+        return *this;
+    }
+
+    envelope& operator=(envelope&& other) noexcept {
+        if (this != &other) {
+            reset();
+
+            if (other.id_ != 0) {
+                move_table[other.id_ - 1](*this, other);
+                id_ = other.id_;
+                other.id_ = 0;
+            }
+        }
+
+        return *this;
+    }
+
+    ~envelope() {
+        reset();
+    }
+
+    /**
+     * Id of the held event, 0 if empty.
+     **/
+    std::size_t id() const noexcept {
+        return id_;
+    }
+
+    bool empty() const noexcept {
+        return id_ == 0;
+    }
+
+    template<class Ev>
+    bool holds() const noexcept {
+        return id_ == id_of<Ev>();
+    }
+
+    template<class Ev>
+    Ev& get() noexcept {
+        assert(holds<Ev>());
+        return *pointer<Ev>();
+    }
+
+    template<class Ev>
+    Ev const& get() const noexcept {
+        assert(holds<Ev>());
+        return *const_cast<envelope*>(this)->template pointer<Ev>();
+    }
+
+    /**
+     * Dispatches the held event to a state machine, returns false if the envelope is empty.
+     **/
+    template<class StateMachine>
+    bool dispatch(StateMachine& sm) const {
+        using fn = bool (*)(StateMachine&, envelope const&);
+        static constexpr fn table[] = {&dispatch_one<StateMachine, E>...};
+
+        return id_ != 0 && table[id_ - 1](sm, *this);
+    }
+
+    /**
+     * Destroys the held event.
+     **/
+    void reset() noexcept {
+        if (id_ != 0) {
+            destroy_table[id_ - 1](*this);
+            id_ = 0;
+        }
+    }
+
+private:
+    template<class Ev>
+    Ev* pointer() noexcept {
+        if constexpr (fits<Ev>) {
+            return std::launder(reinterpret_cast<Ev*>(storage_));
+        } else {
+            return static_cast<Ev*>(remote_ref().ptr);
+        }
+    }
+
+    remote& remote_ref() noexcept {
+        return *std::launder(reinterpret_cast<remote*>(storage_));
+    }
+
+    template<class StateMachine, class Ev>
+    static bool dispatch_one(StateMachine& sm, envelope const& env) {
+        return static_cast<bool>(sm.dispatch(env.template get<Ev>()));
+    }
+
+    template<class Ev>
+    static void destroy_one(envelope& env) noexcept {
+        if constexpr (fits<Ev>) {
+            env.template pointer<Ev>()->~Ev();
+        } else {
+            auto& r = env.remote_ref();
+            static_cast<Ev*>(r.ptr)->~Ev();
+            r.arena->deallocate(r.ptr);
+        }
+    }
+
+    template<class Ev>
+    static void move_one(envelope& dst, envelope& src) noexcept {
+        if constexpr (fits<Ev>) {
+            new (dst.storage_) Ev(std::move(*src.template pointer<Ev>()));
+            src.template pointer<Ev>()->~Ev();
+        } else {
+            // the block changes its owner
+            new (dst.storage_) remote {src.remote_ref()};
+        }
+    }
+
+    template<class Ev>
+    static void copy_one(envelope& dst, envelope const& src) {
+        auto& s = const_cast<envelope&>(src);
+
+        if constexpr (fits<Ev>) {
+            new (dst.storage_) Ev(*s.template pointer<Ev>());
+        } else {
+            auto* arena = s.remote_ref().arena;
+            auto* block = arena->allocate();
+            new (block) Ev(*s.template pointer<Ev>());
+            new (dst.storage_) remote {block, arena};
+        }
+    }
+
+    static constexpr void (*destroy_table[])(envelope&) noexcept = {&destroy_one<E>...};
+    static constexpr void (*move_table[])(envelope&, envelope&) noexcept = {&move_one<E>...};
+    static constexpr void (*copy_table[])(envelope&, envelope const&) = {&copy_one<E>...};
+
+    std::uint32_t                           id_ = 0;
+    alignas(storage_align) unsigned char    storage_[storage_size];
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_ENVELOPE_HPP
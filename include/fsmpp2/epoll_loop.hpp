@@ -0,0 +1,267 @@
+#ifndef FSMPP2_EPOLL_LOOP_HPP
+#define FSMPP2_EPOLL_LOOP_HPP
+
+#include "fsmpp2/states.hpp"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace fsmpp2
+{
+
+/**
+ * Base class for events carrying readiness of a file descriptor. If an event
+ * registered in epoll_loop derives from it, fd and the epoll mask are filled in.
+ **/
+struct fd_event : event {
+    int             fd = -1;
+    std::uint32_t   mask = 0;
+};
+
+/**
+ * Events dispatched on readiness of a file descriptor, void if not interested:
+ * Readable on EPOLLIN, Writable on EPOLLOUT and Closed on hang up or error.
+ **/
+template<class Readable, class Writable = void, class Closed = void>
+struct fd_events {};
+
+/**
+ * Event loop translating readiness of file descriptors into typed events dispatched
+ * to state machines.
+ *
+ * All the descriptors are registered edge-triggered in a single epoll instance, one
+ * epoll_wait() per iteration collects readiness of all the state machines in the loop.
+ * As with any edge-triggered loop, handlers must read (or write) until EAGAIN,
+ * otherwise they will not be notified again.
+ *
+ *      fsmpp2::epoll_loop loop;
+ *      loop.add(socket_fd, session_sm, fsmpp2::fd_events<SocketReadable, SocketWritable, SocketClosed>{});
+ *      loop.add(timer_fd, session_sm, fsmpp2::fd_events<TimerExpired>{});
+ *      loop.run();
+ *
+ * The loop is single threaded, only stop() may be called from other threads.
+ **/
+class epoll_loop {
+public:
+    explicit epoll_loop(std::size_t batch = 256)
+        : epoll_fd_ {::epoll_create1(EPOLL_CLOEXEC)}
+        , wake_fd_ {::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)}
+        , events_(batch > 0 ? batch : 1)
+    {
+        if (epoll_fd_ >= 0 && wake_fd_ >= 0) {
+            ::epoll_event ev {};
+            ev.events = EPOLLIN | EPOLLET;
+            ev.data.ptr = nullptr;
+            ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+        }
+    }
+
+    epoll_loop(epoll_loop const&) = delete;
+    epoll_loop& operator=(epoll_loop const&) = delete;
+
+    ~epoll_loop() {
+        if (wake_fd_ >= 0) {
+            ::close(wake_fd_);
+        }
+
+        if (epoll_fd_ >= 0) {
+            ::close(epoll_fd_);
+        }
+    }
+
+    /**
+     * False if epoll could not be initialized.
+     **/
+    bool valid() const noexcept {
+        return epoll_fd_ >= 0 && wake_fd_ >= 0;
+    }
+
+    /**
+     * Registers a file descriptor, its readiness is dispatched to a state machine as
+     * given events. Returns false if the descriptor could not be registered (eg. it
+     * is already in the loop). The descriptor is not owned by the loop.
+     **/
+    template<class StateMachine, class Readable, class Writable, class Closed>
+    bool add(int fd, StateMachine& sm, fd_events<Readable, Writable, Closed>) {
+        if (!valid() || watches_.count(fd) != 0) {
+            return false;
+        }
+
+        auto w = std::make_unique<watch>();
+        w->fd = fd;
+        w->machine = &sm;
+        w->notify = &notify<StateMachine, Readable, Writable, Closed>;
+
+        ::epoll_event ev {};
+        ev.events = interest<Readable, Writable, Closed>();
+        ev.data.ptr = w.get();
+
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            return false;
+        }
+
+        watches_.emplace(fd, std::move(w));
+        return true;
+    }
+
+    /**
+     * Unregisters a file descriptor, may be called from handlers.
+     **/
+    bool remove(int fd) {
+        auto it = watches_.find(fd);
+
+        if (it == watches_.end()) {
+            return false;
+        }
+
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        it->second->machine = nullptr;
+
+        // events of the current batch may still point to it
+        retired_.push_back(std::move(it->second));
+        watches_.erase(it);
+        return true;
+    }
+
+    /**
+     * Number of registered file descriptors.
+     **/
+    std::size_t size() const noexcept {
+        return watches_.size();
+    }
+
+    /**
+     * Waits up to timeout_ms (-1 waits indefinitely) and dispatches events for all
+     * the ready descriptors. Returns the number of ready descriptors or -1 on error.
+     **/
+    int run_once(int timeout_ms = -1) {
+        if (!valid()) {
+            return -1;
+        }
+
+        auto const count = ::epoll_wait(epoll_fd_, events_.data(), static_cast<int>(events_.size()), timeout_ms);
+
+        if (count < 0) {
+            return errno == EINTR ? 0 : -1;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            auto* w = static_cast<watch*>(events_[i].data.ptr);
+
+            if (w == nullptr) {
+                std::uint64_t value;
+                [[maybe_unused]] auto r = ::read(wake_fd_, &value, sizeof(value));
+                continue;
+            }
+
+            if (w->machine != nullptr) {
+                w->notify(*w, events_[i].events);
+            }
+        }
+
+        retired_.clear();
+        return count;
+    }
+
+    /**
+     * Runs the loop until stop() is called.
+     **/
+    void run() {
+        while (!stopped_.load(std::memory_order_acquire)) {
+            if (run_once() < 0) {
+                break;
+            }
+        }
+
+        stopped_.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * Stops run(), may be called from a handler or any other thread.
+     **/
+    void stop() noexcept {
+        stopped_.store(true, std::memory_order_release);
+
+        std::uint64_t one = 1;
+        [[maybe_unused]] auto r = ::write(wake_fd_, &one, sizeof(one));
+    }
+
+private:
+    struct watch {
+        int     fd = -1;
+        void*   machine = nullptr;
+        void    (*notify)(watch&, std::uint32_t) = nullptr;
+    };
+
+    template<class Readable, class Writable, class Closed>
+    static constexpr std::uint32_t interest() noexcept {
+        std::uint32_t mask = EPOLLET;
+
+        if constexpr (!std::is_void_v<Readable>) {
+            mask |= EPOLLIN;
+        }
+
+        if constexpr (!std::is_void_v<Writable>) {
+            mask |= EPOLLOUT;
+        }
+
+        if constexpr (!std::is_void_v<Closed>) {
+            mask |= EPOLLRDHUP;
+        }
+
+        // EPOLLHUP and EPOLLERR are always reported
+        return mask;
+    }
+
+    template<class E, class StateMachine>
+    static void dispatch(watch& w, std::uint32_t mask) {
+        E e {};
+
+        if constexpr (std::is_base_of_v<fd_event, E>) {
+            e.fd = w.fd;
+            e.mask = mask;
+        }
+
+        static_cast<StateMachine*>(w.machine)->dispatch(e);
+    }
+
+    template<class StateMachine, class Readable, class Writable, class Closed>
+    static void notify(watch& w, std::uint32_t mask) {
+        // pending data is delivered before the hang up, handlers may remove the descriptor
+        if constexpr (!std::is_void_v<Readable>) {
+            if (mask & (EPOLLIN | EPOLLPRI)) {
+                dispatch<Readable, StateMachine>(w, mask);
+            }
+        }
+
+        if constexpr (!std::is_void_v<Writable>) {
+            if ((mask & EPOLLOUT) && w.machine != nullptr) {
+                dispatch<Writable, StateMachine>(w, mask);
+            }
+        }
+
+        if constexpr (!std::is_void_v<Closed>) {
+            if ((mask & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) && w.machine != nullptr) {
+                dispatch<Closed, StateMachine>(w, mask);
+            }
+        }
+    }
+
+    int                                             epoll_fd_;
+    int                                             wake_fd_;
+    std::vector<::epoll_event>                      events_;
+    std::unordered_map<int, std::unique_ptr<watch>> watches_;
+    std::vector<std::unique_ptr<watch>>             retired_;
+    std::atomic<bool>                               stopped_ {false};
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_EPOLL_LOOP_HPP
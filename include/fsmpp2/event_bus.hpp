@@ -0,0 +1,127 @@
+#ifndef FSMPP2_EVENT_BUS_HPP
+#define FSMPP2_EVENT_BUS_HPP
+
+#include "fsmpp2/meta.hpp"
+#include "fsmpp2/detail/state_tree.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace fsmpp2
+{
+
+namespace detail
+{
+
+template<class E, class L> struct event_in_list;
+template<class E, class... X> struct event_in_list<E, meta::type_list<X...>>
+    : meta::type_pack_contains<E, X...> {};
+
+/**
+ * Checks if a state machine type declares event E and any of its states handles it.
+ **/
+template<class StateMachine, class E>
+struct machine_routes_event : std::bool_constant<
+    event_in_list<E, typename StateMachine::events_type>::value &&
+    any_state_handles<
+        typename StateMachine::states_type,
+        E,
+        std::remove_reference_t<typename StateMachine::context_type>>::value> {};
+
+} // namespace detail
+
+/**
+ * Routes events to subscribed state machines of the given types.
+ *
+ * Routing is resolved at compile time: an event is delivered only to machines of
+ * types which list it in their Events and have at least one state handling or
+ * deferring it, other machine types are not even iterated over. The event is passed to every
+ * machine by a const reference, no copies are made.
+ *
+ *      fsmpp2::event_bus<Door, Alarm, Light> bus;
+ *      bus.subscribe(front_door);
+ *      bus.subscribe(alarm);
+ *      bus.publish(PowerLost{}); // Light does not handle it and is skipped
+ *
+ * The bus only keeps pointers, subscribed machines must outlive it or be unsubscribed.
+ **/
+template<class... Machines>
+class event_bus {
+public:
+    /**
+     * Type list of machine types an event E is routed to.
+     **/
+    template<class E>
+    using receivers = typename meta::type_list_concat<
+        std::conditional_t<
+            detail::machine_routes_event<Machines, E>::value,
+            meta::type_list<Machines>,
+            meta::type_list<>>...
+    >::result;
+
+    /**
+     * Checks if an event E is routed to any machine type.
+     **/
+    template<class E>
+    static constexpr bool routes() noexcept {
+        return (detail::machine_routes_event<Machines, E>::value || ...);
+    }
+
+    template<class M>
+    void subscribe(M& machine) {
+        subscribers<M>().push_back(&machine);
+    }
+
+    template<class M>
+    void unsubscribe(M& machine) {
+        auto& list = subscribers<M>();
+        list.erase(std::remove(list.begin(), list.end(), &machine), list.end());
+    }
+
+    /**
+     * Dispatches an event to all subscribed machines which can handle it.
+     *
+     * Returns the number of machines which handled the event.
+     **/
+    template<class E>
+    std::size_t publish(E const& e) {
+        std::size_t handled = 0;
+        (publish_to<Machines>(e, handled), ...);
+        return handled;
+    }
+
+    /**
+     * Number of subscribed machines of type M.
+     **/
+    template<class M>
+    std::size_t count() const noexcept {
+        return std::get<list_type<M>>(subscribers_).size();
+    }
+
+private:
+    template<class M>
+    using list_type = std::vector<M*>;
+
+    template<class M>
+    auto& subscribers() {
+        static_assert(meta::type_pack_contains<M, Machines...>::value, "machine type is not handled by this bus");
+        return std::get<list_type<M>>(subscribers_);
+    }
+
+    template<class M, class E>
+    void publish_to(E const& e, std::size_t& handled) {
+        if constexpr (detail::machine_routes_event<M, E>::value) {
+            for (auto* machine : std::get<list_type<M>>(subscribers_)) {
+                handled += machine->dispatch(e) ? 1 : 0;
+            }
+        }
+    }
+
+    std::tuple<list_type<Machines>...> subscribers_;
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_EVENT_BUS_HPP
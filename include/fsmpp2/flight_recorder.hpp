@@ -0,0 +1,488 @@
+#ifndef FSMPP2_FLIGHT_RECORDER_HPP
+#define FSMPP2_FLIGHT_RECORDER_HPP
+
+#include "fsmpp2/reflection.hpp"
+#include "fsmpp2/detail/state_tree.hpp"
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace fsmpp2::flight
+{
+
+enum class record_kind : std::uint8_t {
+    begin,          // event passed to a state handler
+    handled,        // handler consumed the event
+    not_handled,    // handler did not consume the event
+    transition,     // handler requested a transition
+    enter,          // state entered
+    exit            // state exited
+};
+
+/**
+ * Single entry of the flight recorder, states and events are stored as compact
+ * ids (position in the flattened states hierarchy and in the events list).
+ **/
+struct record {
+    std::uint32_t   seq;
+    record_kind     kind;
+    std::uint8_t    level;
+    std::uint16_t   state;
+    std::uint16_t   event;
+    std::uint16_t   target;
+};
+
+/**
+ * Header of a single recorder within a dump file, followed by names_size bytes
+ * of NUL separated state and event names and capacity records.
+ **/
+struct dump_header {
+    char            magic[8];
+    std::uint32_t   version;
+    std::uint32_t   record_size;
+    std::uint32_t   capacity;
+    std::uint32_t   written;
+    std::uint32_t   names_size;
+    std::uint16_t   state_count;
+    std::uint16_t   event_count;
+};
+
+constexpr char magic[8] = {'F', 'S', 'M', 'P', 'P', '2', 'F', 'R'};
+constexpr std::uint32_t version = 1;
+constexpr std::uint16_t unknown_id = 0xffff;
+
+namespace detail
+{
+
+// async-signal-safe, retries partial writes
+inline bool write_all(int fd, void const* data, std::size_t size) noexcept {
+    auto ptr = static_cast<char const*>(data);
+
+    while (size > 0) {
+        auto const res = ::write(fd, ptr, size);
+
+        if (res <= 0) {
+            return false;
+        }
+
+        ptr += res;
+        size -= static_cast<std::size_t>(res);
+    }
+
+    return true;
+}
+
+template<class... S>
+void append_names(std::string& blob, fsmpp2::meta::type_list<S...>) {
+    ((blob += reflection::get_type_name<S>(), blob.push_back('\0')), ...);
+}
+
+using dump_function = void (*)(void const*, int) noexcept;
+
+struct registry_slot {
+    std::atomic<bool>           used {false};
+    std::atomic<dump_function>  dump {nullptr};
+    std::atomic<void const*>    recorder {nullptr};
+};
+
+constexpr std::size_t registry_capacity = 256;
+
+inline registry_slot registry[registry_capacity];
+inline char dump_path[256] = {};
+
+} // namespace detail
+
+/**
+ * Dumps all registered recorders to a file descriptor.
+ *
+ * It is async-signal-safe, it can be called from a signal handler.
+ **/
+inline void dump_all(int fd) noexcept {
+    for (auto& slot : detail::registry) {
+        auto const rec = slot.recorder.load(std::memory_order_acquire);
+
+        if (rec) {
+            slot.dump.load(std::memory_order_relaxed)(rec, fd);
+        }
+    }
+}
+
+namespace detail
+{
+
+constexpr std::array<int, 3> dump_signals {SIGSEGV, SIGABRT, SIGUSR1};
+
+// actions replaced by install_signal_handlers(), in dump_signals order
+inline struct sigaction previous_actions[dump_signals.size()] = {};
+inline bool handlers_installed = false;
+
+inline struct sigaction const& previous_action(int sig) noexcept {
+    std::size_t idx = 0;
+
+    while (idx + 1 < dump_signals.size() && dump_signals[idx] != sig) {
+        idx ++;
+    }
+
+    return previous_actions[idx];
+}
+
+inline void flight_signal_handler(int sig, siginfo_t* info, void* ucontext) {
+    // the interrupted code must not see errno of open() or close()
+    auto const saved_errno = errno;
+    auto const fd = ::open(dump_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd >= 0) {
+        dump_all(fd);
+        ::close(fd);
+    }
+
+    auto const& previous = previous_action(sig);
+
+    if (sig == SIGUSR1) {
+        // chain to the previous handler, if any, the default action (termination) is skipped
+        if (previous.sa_flags & SA_SIGINFO) {
+            previous.sa_sigaction(sig, info, ucontext);
+        } else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN) {
+            previous.sa_handler(sig);
+        }
+    } else {
+        // let the previous handler (or the default action) handle the crash once this one returns
+        ::sigaction(sig, &previous, nullptr);
+        ::raise(sig);
+    }
+
+    errno = saved_errno;
+}
+
+} // namespace detail
+
+/**
+ * Installs SIGSEGV, SIGABRT and SIGUSR1 handlers dumping all registered
+ * recorders into a file at given path (truncated on every dump).
+ *
+ * Handlers installed before are kept and chained to: on SIGUSR1 the previous
+ * handler is called after the dump and the program continues, crash signals
+ * are re-raised with the previous action restored. Installing again only
+ * changes the path.
+ **/
+inline bool install_signal_handlers(char const* path) {
+    if (std::strlen(path) >= sizeof(detail::dump_path)) {
+        return false;
+    }
+
+    std::strcpy(detail::dump_path, path);
+
+    if (detail::handlers_installed) {
+        return true;
+    }
+
+    struct sigaction action {};
+    action.sa_sigaction = detail::flight_signal_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    for (std::size_t i = 0; i < detail::dump_signals.size(); ++i) {
+        if (::sigaction(detail::dump_signals[i], &action, &detail::previous_actions[i]) != 0) {
+            // put back the ones already replaced
+            while (i-- > 0) {
+                ::sigaction(detail::dump_signals[i], &detail::previous_actions[i], nullptr);
+            }
+
+            return false;
+        }
+    }
+
+    detail::handlers_installed = true;
+    return true;
+}
+
+/**
+ * Restores signal actions replaced by install_signal_handlers().
+ **/
+inline void uninstall_signal_handlers() noexcept {
+    if (!detail::handlers_installed) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < detail::dump_signals.size(); ++i) {
+        ::sigaction(detail::dump_signals[i], &detail::previous_actions[i], nullptr);
+    }
+
+    detail::handlers_installed = false;
+}
+
+/**
+ * Always-on, fixed-size tracer keeping last N records of a state machine history.
+ *
+ * Records are kept in a ring in compact form. Once registered (see register_for_dump())
+ * the recorder is dumped by signal handlers (see install_signal_handlers()) or
+ * on demand by dump_all(). Dumps are decoded by decode().
+ *
+ * A recorder may be shared by multiple state machines of the same type running on
+ * the same thread by passing it to the state machines as an lvalue reference.
+ **/
+template<class States, class Events, std::size_t N = 256>
+class flight_recorder {
+    using all_states = typename fsmpp2::detail::all_states<States>::type;
+
+    static_assert(fsmpp2::detail::states_count<States>() < unknown_id, "too many states");
+    static_assert(meta::type_list_size(Events{}) < unknown_id, "too many events");
+
+public:
+    static constexpr auto capacity = N;
+
+    flight_recorder() {
+        // build names table now, not in a signal handler
+        names();
+    }
+
+    flight_recorder(flight_recorder&& other) noexcept
+        : records_ {other.records_}
+        , seq_ {other.seq_}
+    {}
+
+    flight_recorder(flight_recorder const&) = delete;
+    flight_recorder& operator=(flight_recorder const&) = delete;
+
+    ~flight_recorder() {
+        unregister();
+    }
+
+    template<class S, class E>
+    void begin_event_handling() {
+        push(record_kind::begin, state<S>(), event<E>(), unknown_id, level<S>());
+    }
+
+    template<class S, class E>
+    void end_event_handling(bool result) {
+        push(result ? record_kind::handled : record_kind::not_handled, state<S>(), event<E>(), unknown_id, level<S>());
+    }
+
+    template<class From, class E, class To>
+    void transition() {
+        push(record_kind::transition, state<From>(), event<E>(), state<To>(), level<From>());
+    }
+
+    template<class S>
+    void enter_state(S const&) {
+        push(record_kind::enter, state<S>(), unknown_id, unknown_id, level<S>());
+    }
+
+    template<class S>
+    void exit_state(S const&) {
+        push(record_kind::exit, state<S>(), unknown_id, unknown_id, level<S>());
+    }
+
+    /**
+     * Writes the recorder content to a file descriptor, async-signal-safe.
+     **/
+    void dump(int fd) const noexcept {
+        auto const& n = names();
+
+        dump_header header {};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.record_size = sizeof(record);
+        header.capacity = N;
+        header.written = seq_;
+        header.names_size = static_cast<std::uint32_t>(n.size());
+        header.state_count = static_cast<std::uint16_t>(fsmpp2::detail::states_count<States>());
+        header.event_count = static_cast<std::uint16_t>(meta::type_list_size(Events{}));
+
+        detail::write_all(fd, &header, sizeof(header))
+            && detail::write_all(fd, n.data(), n.size())
+            && detail::write_all(fd, records_.data(), sizeof(records_));
+    }
+
+    /**
+     * Total number of records written so far.
+     **/
+    std::uint32_t written() const noexcept {
+        return seq_;
+    }
+
+    /**
+     * Registers the recorder for dump_all() and signal handlers.
+     *
+     * The recorder must not be moved afterwards, it is unregistered on destruction.
+     **/
+    bool register_for_dump() noexcept {
+        if (slot_) {
+            return true;
+        }
+
+        for (auto& slot : detail::registry) {
+            auto expected = false;
+
+            if (slot.used.compare_exchange_strong(expected, true)) {
+                slot.dump.store(&dump_thunk, std::memory_order_relaxed);
+                slot.recorder.store(this, std::memory_order_release);
+                slot_ = &slot;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void unregister() noexcept {
+        if (slot_) {
+            slot_->recorder.store(nullptr, std::memory_order_release);
+            slot_->used.store(false, std::memory_order_release);
+            slot_ = nullptr;
+        }
+    }
+
+private:
+    static void dump_thunk(void const* self, int fd) noexcept {
+        static_cast<flight_recorder const*>(self)->dump(fd);
+    }
+
+    static std::string const& names() {
+        static std::string const blob = [] {
+            std::string result;
+            detail::append_names(result, all_states{});
+            detail::append_names(result, Events{});
+            return result;
+        }();
+
+        return blob;
+    }
+
+    template<class S>
+    static constexpr std::uint16_t state() {
+        return static_cast<std::uint16_t>(meta::type_list_index<S>(all_states{}));
+    }
+
+    template<class S>
+    static constexpr std::uint8_t level() {
+        constexpr auto id = meta::type_list_index<S>(all_states{});
+
+        if constexpr (id < fsmpp2::detail::states_count<States>()) {
+            return static_cast<std::uint8_t>(fsmpp2::detail::state_depths<States>()[id]);
+        } else {
+            return 0;
+        }
+    }
+
+    template<class E>
+    static constexpr std::uint16_t event() {
+        return static_cast<std::uint16_t>(meta::type_list_index<E>(Events{}));
+    }
+
+    void push(record_kind kind, std::uint16_t s, std::uint16_t e, std::uint16_t target, std::uint8_t lvl) noexcept {
+        records_[seq_ % N] = record{seq_, kind, lvl, s, e, target};
+        seq_ ++;
+    }
+
+    std::array<record, N>   records_ {};
+    std::uint32_t           seq_ = 0;
+    detail::registry_slot*  slot_ = nullptr;
+};
+
+namespace detail
+{
+
+inline std::string name_of(std::vector<std::string> const& names, std::size_t offset, std::size_t count, std::uint16_t id) {
+    if (id < count && offset + id < names.size()) {
+        return names[offset + id];
+    }
+
+    return "?";
+}
+
+} // namespace detail
+
+/**
+ * Decodes a dump file (one or more recorders) into human readable text.
+ *
+ * Returns false if the input is malformed.
+ **/
+inline bool decode(std::istream& is, std::ostream& os) {
+    for (std::size_t idx = 0; is.peek() != std::istream::traits_type::eof(); ++idx) {
+        dump_header header {};
+
+        if (!is.read(reinterpret_cast<char *>(&header), sizeof(header))
+            || std::memcmp(header.magic, magic, sizeof(magic)) != 0
+            || header.version != version
+            || header.record_size != sizeof(record)) {
+            return false;
+        }
+
+        std::string blob(header.names_size, '\0');
+        std::vector<record> records(header.capacity);
+
+        if (!is.read(blob.data(), blob.size())
+            || !is.read(reinterpret_cast<char *>(records.data()), records.size() * sizeof(record))) {
+            return false;
+        }
+
+        std::vector<std::string> names;
+        for (std::size_t pos = 0; pos < blob.size(); ) {
+            auto const end = blob.find('\0', pos);
+            names.push_back(blob.substr(pos, end - pos));
+            pos = end == std::string::npos ? blob.size() : end + 1;
+        }
+
+        auto const state_name = [&](std::uint16_t id) { return detail::name_of(names, 0, header.state_count, id); };
+        auto const event_name = [&](std::uint16_t id) { return detail::name_of(names, header.state_count, header.event_count, id); };
+
+        auto const count = header.written < header.capacity ? header.written : header.capacity;
+        auto const first = header.written - count;
+
+        os << "recorder " << idx << ": last " << count << " of " << header.written << " records\n";
+
+        for (auto seq = first; seq != header.written; ++seq) {
+            auto const& r = records[seq % header.capacity];
+
+            os << "#" << r.seq << " L" << unsigned{r.level} << " ";
+
+            switch (r.kind) {
+            case record_kind::begin:
+                os << "dispatch " << event_name(r.event) << " to " << state_name(r.state);
+                break;
+            case record_kind::handled:
+                os << "handled " << event_name(r.event) << " in " << state_name(r.state);
+                break;
+            case record_kind::not_handled:
+                os << "not handled " << event_name(r.event) << " in " << state_name(r.state);
+                break;
+            case record_kind::transition:
+                os << "transition " << state_name(r.state) << " -> " << state_name(r.target) << " on " << event_name(r.event);
+                break;
+            case record_kind::enter:
+                os << "enter " << state_name(r.state);
+                break;
+            case record_kind::exit:
+                os << "exit " << state_name(r.state);
+                break;
+            default:
+                os << "unknown record";
+            }
+
+            os << "\n";
+        }
+    }
+
+    return true;
+}
+
+} // namespace fsmpp2::flight
+
+namespace fsmpp2
+{
+
+using flight::flight_recorder;
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_FLIGHT_RECORDER_HPP
@@ -0,0 +1,297 @@
+#ifndef FSMPP2_LOCKSTEP_HPP
+#define FSMPP2_LOCKSTEP_HPP
+
+#include "fsmpp2/meta.hpp"
+#include "fsmpp2/states.hpp"
+#include "fsmpp2/transition_table.hpp"
+#include "fsmpp2/detail/traits.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FSMPP2_LOCKSTEP_X86
+#include <immintrin.h>
+#endif
+
+namespace fsmpp2
+{
+
+/**
+ * Instruction sets used to step machines, in order of preference.
+ **/
+enum class lockstep_isa {
+    scalar,
+    avx2,
+    avx512
+};
+
+/**
+ * The best instruction set supported by the CPU, checked once.
+ **/
+inline lockstep_isa lockstep_best_isa() noexcept {
+#ifdef FSMPP2_LOCKSTEP_X86
+    static auto const isa =
+        __builtin_cpu_supports("avx512f") ? lockstep_isa::avx512 :
+        __builtin_cpu_supports("avx2") ? lockstep_isa::avx2 :
+        lockstep_isa::scalar;
+    return isa;
+#else
+    return lockstep_isa::scalar;
+#endif
+}
+
+namespace detail
+{
+
+template<class Index>
+void lockstep_scalar(std::int32_t const* table, std::size_t states, Index* s, Index const* e, std::size_t count) noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+        s[i] = static_cast<Index>(table[e[i] * states + s[i]]);
+    }
+}
+
+#ifdef FSMPP2_LOCKSTEP_X86
+
+template<class Index>
+__attribute__((target("avx2"))) inline __m256i lockstep_load8(Index const* p) noexcept {
+    if constexpr (sizeof(Index) == 1) {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p)));
+    } else if constexpr (sizeof(Index) == 2) {
+        return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p)));
+    } else {
+        return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+    }
+}
+
+template<class Index>
+__attribute__((target("avx2"))) inline void lockstep_store8(Index* p, __m256i v) noexcept {
+    if constexpr (sizeof(Index) == 4) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    } else {
+        // 32 to 16 bits packs within 128-bit lanes, gather both halves in the low lane
+        auto const words = _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0x08));
+
+        if constexpr (sizeof(Index) == 2) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), words);
+        } else {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(words, words));
+        }
+    }
+}
+
+template<class Index>
+__attribute__((target("avx2"))) void lockstep_avx2(std::int32_t const* table, std::size_t states, Index* s, Index const* e, std::size_t count) noexcept {
+    auto const stride = _mm256_set1_epi32(static_cast<int>(states));
+    std::size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        auto const key = _mm256_add_epi32(_mm256_mullo_epi32(lockstep_load8(e + i), stride), lockstep_load8(s + i));
+        lockstep_store8(s + i, _mm256_i32gather_epi32(reinterpret_cast<int const*>(table), key, 4));
+    }
+
+    lockstep_scalar(table, states, s + i, e + i, count - i);
+}
+
+template<class Index>
+__attribute__((target("avx512f"))) inline __m512i lockstep_load16(Index const* p) noexcept {
+    if constexpr (sizeof(Index) == 1) {
+        return _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p)));
+    } else if constexpr (sizeof(Index) == 2) {
+        return _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)));
+    } else {
+        return _mm512_loadu_si512(p);
+    }
+}
+
+template<class Index>
+__attribute__((target("avx512f"))) inline void lockstep_store16(Index* p, __m512i v) noexcept {
+    if constexpr (sizeof(Index) == 1) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm512_cvtepi32_epi8(v));
+    } else if constexpr (sizeof(Index) == 2) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_cvtepi32_epi16(v));
+    } else {
+        _mm512_storeu_si512(p, v);
+    }
+}
+
+template<class Index>
+__attribute__((target("avx512f"))) void lockstep_avx512(std::int32_t const* table, std::size_t states, Index* s, Index const* e, std::size_t count) noexcept {
+    auto const stride = _mm512_set1_epi32(static_cast<int>(states));
+    std::size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        auto const key = _mm512_add_epi32(_mm512_mullo_epi32(lockstep_load16(e + i), stride), lockstep_load16(s + i));
+        lockstep_store16(s + i, _mm512_i32gather_epi32(key, table, 4));
+    }
+
+    lockstep_scalar(table, states, s + i, e + i, count - i);
+}
+
+#endif // FSMPP2_LOCKSTEP_X86
+
+template<std::size_t N>
+using lockstep_index_t = std::conditional_t<(N <= 0x100), std::uint8_t,
+                         std::conditional_t<(N <= 0x10000), std::uint16_t, std::uint32_t>>;
+
+template<class State, class Event, class... S>
+constexpr std::int32_t lockstep_target() noexcept {
+    constexpr auto self = static_cast<std::int32_t>(index_of<State>(meta::type_list<S...>{}));
+
+    static_assert(!can_handle_event<State, Event>::value, "lockstep states can't have event handlers, use transition_table edges");
+
+    if constexpr (has_transition_table<State>::value) {
+        using table = typename State::transition_table;
+        constexpr auto r = table::template first_row<State, Event>();
+
+        if constexpr (r == table::npos) {
+            return self;
+        } else {
+            using row = typename meta::type_list_type<r, typename table::rows>::type;
+
+            static_assert(std::is_same_v<typename row::guard, none> && std::is_same_v<typename row::action, none>,
+                "lockstep rows can't have guards nor actions");
+            static_assert(table::next_row(r) == table::npos, "lockstep allows one row per state and event");
+
+            if constexpr (std::is_same_v<typename row::target, none>) {
+                return self;
+            } else {
+                static_assert(meta::type_pack_contains<typename row::target, S...>::value, "lockstep transition target is not a state of this machine");
+                return static_cast<std::int32_t>(index_of<typename row::target>(meta::type_list<S...>{}));
+            }
+        }
+    } else {
+        return self;
+    }
+}
+
+template<class Event, class... S>
+constexpr std::array<std::int32_t, sizeof...(S)> lockstep_targets() noexcept {
+    return {lockstep_target<S, Event, S...>()...};
+}
+
+/**
+ * Next state of every state on every event, event-major, with an extra last
+ * row for no event which keeps every state.
+ **/
+template<class... S, class... E>
+constexpr auto lockstep_table(meta::type_list<E...>) noexcept {
+    constexpr auto states = sizeof...(S);
+    constexpr auto events = sizeof...(E);
+
+    std::array<std::int32_t, (events + 1) * states> result {};
+    std::array<std::array<std::int32_t, states>, events> rows {lockstep_targets<E, S...>()...};
+
+    for (std::size_t e = 0; e < events; ++e) {
+        for (std::size_t s = 0; s < states; ++s) {
+            result[e * states + s] = rows[e][s];
+        }
+    }
+
+    for (std::size_t s = 0; s < states; ++s) {
+        result[events * states + s] = static_cast<std::int32_t>(s);
+    }
+
+    return result;
+}
+
+} // namespace detail
+
+/**
+ * Steps many instances of a simple state machine at once, each instance is just
+ * an index of its current state.
+ *
+ * States must be flat (no substates) and empty, their transitions are declared as
+ * edges of a transition_table (see transition_table.hpp): unconditional rows
+ * without an action, at most one per state and event. The state machine then is
+ * a (state, event) -> state table, built at compile time, and a step of many
+ * instances is a gather from it (AVX2 or AVX-512 when the CPU supports them).
+ *
+ * States without a row for an event stay where they are, as do all the instances
+ * getting no_event. The same States and Events can drive a regular state_machine.
+ **/
+template<class States, class Events>
+class lockstep;
+
+template<class... S, class... E>
+class lockstep<fsmpp2::states<S...>, fsmpp2::meta::type_list<E...>> {
+    using states_list = meta::type_list<S...>;
+    using events_list = meta::type_list<E...>;
+
+public:
+    static constexpr std::size_t states_count = sizeof...(S);
+    static constexpr std::size_t events_count = sizeof...(E);
+
+    // no_event is a valid event id as well
+    using index_type = detail::lockstep_index_t<std::max(states_count, events_count + 1)>;
+
+    static constexpr index_type no_event = static_cast<index_type>(events_count);
+
+    static_assert(states_count > 0, "lockstep machine needs at least one state");
+    static_assert(((std::is_same_v<typename S::substates_type, fsmpp2::states<>> && std::is_empty_v<S>) && ...),
+        "lockstep states must be empty and have no substates");
+
+    template<class State>
+    static constexpr index_type state_index() noexcept {
+        static_assert(meta::type_pack_contains<State, S...>::value, "not a state of this lockstep machine");
+        return static_cast<index_type>(detail::index_of<State>(states_list{}));
+    }
+
+    template<class Event>
+    static constexpr index_type event_index() noexcept {
+        static_assert(meta::type_pack_contains<Event, E...>::value, "not an event of this lockstep machine");
+        return static_cast<index_type>(detail::index_of<Event>(events_list{}));
+    }
+
+    /**
+     * State an instance in a given state moves to on a given event.
+     **/
+    static constexpr index_type next(index_type state, index_type event) noexcept {
+        return static_cast<index_type>(table_[event * states_count + state]);
+    }
+
+    /**
+     * Every instance i (i < count) handles event events[i], all event ids must be valid.
+     * An instruction set not supported by the CPU is replaced by the best supported one.
+     **/
+    static void step(index_type* states, index_type const* events, std::size_t count, lockstep_isa isa = lockstep_best_isa()) noexcept {
+        switch (std::min(isa, lockstep_best_isa())) {
+#ifdef FSMPP2_LOCKSTEP_X86
+        case lockstep_isa::avx512:
+            detail::lockstep_avx512(table_.data(), states_count, states, events, count);
+            break;
+        case lockstep_isa::avx2:
+            detail::lockstep_avx2(table_.data(), states_count, states, events, count);
+            break;
+#endif
+        default:
+            detail::lockstep_scalar(table_.data(), states_count, states, events, count);
+            break;
+        }
+    }
+
+    /**
+     * Replays steps rows of events, row t (events + t * count) is handled in step t.
+     * Instances are processed in blocks small enough to stay in the cache for all the steps.
+     **/
+    static void run(index_type* states, index_type const* events, std::size_t count, std::size_t steps, lockstep_isa isa = lockstep_best_isa()) noexcept {
+        constexpr std::size_t block = 4096;
+
+        for (std::size_t first = 0; first < count; first += block) {
+            auto const size = std::min(block, count - first);
+
+            for (std::size_t t = 0; t < steps; ++t) {
+                step(states + first, events + t * count + first, size, isa);
+            }
+        }
+    }
+
+private:
+    static constexpr auto table_ = detail::lockstep_table<S...>(events_list{});
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_LOCKSTEP_HPP
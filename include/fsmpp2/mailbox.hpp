@@ -0,0 +1,198 @@
+#ifndef FSMPP2_MAILBOX_HPP
+#define FSMPP2_MAILBOX_HPP
+
+#include "fsmpp2/coalescing.hpp"
+#include "fsmpp2/envelope.hpp"
+#include "fsmpp2/detail/mpsc_ring.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace fsmpp2
+{
+
+/**
+ * Queue of events for a state machine.
+ *
+ * Events may be posted from any thread, they are dispatched by process() called
+ * by the thread owning the state machine. Coalescing policies of events are
+ * applied when an event is posted, so a burst of eg. timer ticks is dispatched
+ * as a single event.
+ *
+ * Events are kept in envelopes with InlineSize bytes of inline storage, larger
+ * events are placed in the arena passed to the constructor.
+ *
+ *      fsmpp2::mailbox<decltype(sm)> mbox{sm};
+ *      mbox.post(TimeElapsed{1s}); // from any thread
+ *      mbox.process();             // in the state machine thread
+ **/
+template<
+    class StateMachine,
+    std::size_t InlineSize = detail::max_event_size<typename StateMachine::events_type>::value>
+class mailbox {
+public:
+    using events_type = typename StateMachine::events_type;
+    using envelope_type = envelope<events_type, InlineSize>;
+
+    explicit mailbox(StateMachine& sm, envelope_arena* arena = nullptr) noexcept
+        : sm_ {sm}
+        , arena_ {arena}
+    {}
+
+    /**
+     * Enqueues an event, returns false if it was coalesced with a pending one.
+     * Throws std::bad_alloc if the event does not fit inline and there's no
+     * free arena block.
+     **/
+    template<class E>
+    bool post(E const& e) {
+        std::lock_guard<std::mutex> lock {mutex_};
+        return pending_.push(e, arena_);
+    }
+
+    /**
+     * Dispatches all the pending events, returns the number of events dispatched.
+     *
+     * Events posted by handlers are dispatched by the next call.
+     **/
+    std::size_t process() {
+        {
+            std::lock_guard<std::mutex> lock {mutex_};
+            pending_.take(processing_);
+        }
+
+        for (auto const& env : processing_) {
+            env.dispatch(sm_);
+        }
+
+        auto const count = processing_.size();
+        // release arena blocks now rather than on the next call
+        processing_.clear();
+        return count;
+    }
+
+    /**
+     * Number of pending events.
+     **/
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock {mutex_};
+        return pending_.size();
+    }
+
+private:
+    using buffer_type = detail::coalescing_buffer<envelope_type>;
+
+    StateMachine&               sm_;
+    envelope_arena*             arena_;
+    mutable std::mutex          mutex_;
+    buffer_type                 pending_;
+    std::vector<envelope_type>  processing_;
+};
+
+namespace detail
+{
+
+template<class E, class = void>
+struct nested_priority : std::integral_constant<std::size_t, 0> {};
+
+template<class E>
+struct nested_priority<E, std::void_t<decltype(E::priority)>>
+    : std::integral_constant<std::size_t, E::priority> {};
+
+} // namespace detail
+
+/**
+ * Priority lane of an event type, higher lanes are served first. It is taken from
+ * a static constexpr E::priority member if declared (0 otherwise), may also be
+ * specialized for an event type:
+ *
+ *      template<> struct fsmpp2::priority<Shutdown> : std::integral_constant<std::size_t, 2> {};
+ **/
+template<class E>
+struct priority : detail::nested_priority<E> {};
+
+/**
+ * Queue of events for a state machine with a fixed number of priority lanes.
+ *
+ * Every lane is a bounded lock-free ring with Capacity slots allocated with the
+ * mailbox, so posting an event from any thread neither locks nor allocates.
+ * process() serves lanes from the highest one, taking at most lane_batch events
+ * from a lane before moving to a lower one, so control events are dispatched
+ * ahead of queued data events without starving them.
+ *
+ * Events are not coalesced, see mailbox.
+ *
+ *      fsmpp2::priority_mailbox<decltype(sm), 1024, 3> mbox{sm};
+ *      mbox.post(Shutdown{}); // from any thread, jumps the data events
+ *      mbox.process();        // in the state machine thread
+ **/
+template<class StateMachine, std::size_t Capacity, std::size_t Lanes = 2>
+class priority_mailbox {
+public:
+    using events_type = typename StateMachine::events_type;
+
+    static constexpr auto lanes = Lanes;
+
+    explicit priority_mailbox(StateMachine& sm, std::size_t lane_batch = 32) noexcept
+        : sm_ {sm}
+        , lane_batch_ {lane_batch > 0 ? lane_batch : 1}
+    {}
+
+    /**
+     * Enqueues an event in its priority lane, returns false if the lane is full.
+     **/
+    template<class E>
+    bool post(E const& e) noexcept {
+        static_assert(priority<E>::value < Lanes, "event priority out of lanes range");
+        return lanes_[priority<E>::value].try_push(envelope_type {e});
+    }
+
+    /**
+     * Dispatches pending events, highest lanes first, until all the lanes are empty
+     * or max events were dispatched. Returns the number of events dispatched.
+     **/
+    std::size_t process(std::size_t max = std::numeric_limits<std::size_t>::max()) {
+        std::size_t total = 0;
+
+        while (total < max) {
+            auto const round = total;
+
+            for (auto lane = Lanes; lane-- > 0 && total < max; ) {
+                total += process_lane(lane, std::min(lane_batch_, max - total));
+            }
+
+            if (total == round) {
+                break;
+            }
+        }
+
+        return total;
+    }
+
+private:
+    using envelope_type = envelope<events_type>;
+
+    std::size_t process_lane(std::size_t lane, std::size_t count) {
+        envelope_type env;
+        std::size_t done = 0;
+
+        while (done < count && lanes_[lane].try_pop(env)) {
+            env.dispatch(sm_);
+            done ++;
+        }
+
+        return done;
+    }
+
+    StateMachine&                                                   sm_;
+    std::size_t                                                     lane_batch_;
+    std::array<detail::mpsc_ring<envelope_type, Capacity>, Lanes>   lanes_;
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_MAILBOX_HPP
@@ -116,6 +116,58 @@ template<class... E, class T> struct type_list_push_front<type_list<E...>, T> {
     using result = type_list<T, E...>;
 };
 
+/**
+ * @brief Concatenate any number of type_lists into a single one.
+ */
+template<class... L> struct type_list_concat;
+template<> struct type_list_concat<> {
+    using result = type_list<>;
+};
+template<class... A> struct type_list_concat<type_list<A...>> {
+    using result = type_list<A...>;
+};
+template<class... A, class... B, class... L>
+struct type_list_concat<type_list<A...>, type_list<B...>, L...> {
+    using result = typename type_list_concat<type_list<A..., B...>, L...>::result;
+};
+
+/**
+ * @brief Remove all occurrences of type X from the type_list.
+ */
+template<class X, class L> struct type_list_remove;
+template<class X, class... T> struct type_list_remove<X, type_list<T...>> {
+    using result = typename type_list_concat<
+        std::conditional_t<std::is_same_v<X, T>, type_list<>, type_list<T>>...
+    >::result;
+};
+
+/**
+ * @brief Check whether type X is one of types L.
+ */
+template<class X, class... L>
+struct type_pack_contains : std::bool_constant<(std::is_same_v<X, L> || ...)> {};
+
+/**
+ * @brief Set union of any number of type_lists, types are kept in order of first appearance.
+ */
+template<class... L> struct type_list_union;
+template<> struct type_list_union<> {
+    using result = type_list<>;
+};
+template<class... A> struct type_list_union<type_list<A...>> {
+    using result = type_list<A...>;
+};
+template<class... A, class... B, class... L>
+struct type_list_union<type_list<A...>, type_list<B...>, L...> {
+    using result = typename type_list_union<
+        typename type_list_concat<
+            type_list<A...>,
+            std::conditional_t<type_pack_contains<B, A...>::value, type_list<>, type_list<B>>...
+        >::result,
+        L...
+    >::result;
+};
+
 } // namespace fsmpp2::meta
 
 #endif // FSMPP2_META_HPP
\ No newline at end of file
@@ -0,0 +1,231 @@
+#ifndef FSMPP2_PIPELINE_HPP
+#define FSMPP2_PIPELINE_HPP
+
+#include "fsmpp2/meta.hpp"
+#include "fsmpp2/coalescing.hpp"
+#include "fsmpp2/envelope.hpp"
+#include "fsmpp2/detail/spsc_ring.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fsmpp2
+{
+
+template<std::size_t Capacity, class... Machines> class pipeline;
+
+/**
+ * Events emitted by a pipeline stage to the next one.
+ *
+ * An outbox is a context of a stage state machine (directly, as a base class of the
+ * context or within fsmpp2::contexts), handlers emit events without knowing where and
+ * when they are processed. Emitted events are buffered and handed off to the next
+ * stage after the current batch of events is dispatched, events emitted within
+ * a batch are coalesced according to their coalescing policies.
+ **/
+template<class Events> class outbox;
+template<class... E>
+class outbox<meta::type_list<E...>> {
+public:
+    using events_type = meta::type_list<E...>;
+    using envelope_type = envelope<events_type>;
+
+    template<class Ev>
+    void emit(Ev const& e) {
+        static_assert(meta::type_pack_contains<Ev, E...>::value, "event is not handled by the next stage");
+        pending_.push(e);
+    }
+
+    /**
+     * Number of events emitted and not yet handed off.
+     **/
+    std::size_t size() const noexcept {
+        return pending_.size();
+    }
+
+private:
+    template<std::size_t, class...> friend class pipeline;
+
+    detail::coalescing_buffer<envelope_type> pending_;
+};
+
+namespace detail
+{
+
+template<class Outbox, class Context>
+Outbox& find_outbox(Context& ctx) {
+    if constexpr (std::is_base_of_v<Outbox, Context>) {
+        return ctx;
+    } else {
+        return ctx.template get<Outbox>();
+    }
+}
+
+} // namespace detail
+
+/**
+ * Chain of state machines, each running on its own thread.
+ *
+ * Stages are linked with bounded single-producer single-consumer rings of events
+ * of the next stage. A stage takes events from its input ring in batches, dispatches
+ * them and hands off everything its handlers emitted to the next stage outbox ring
+ * at once. If the next ring is full the stage waits (backpressure propagates up to
+ * push()).
+ *
+ * Every stage but the last needs an outbox<next stage events> in its context.
+ * Machines must not be accessed by other threads while the pipeline is running.
+ *
+ *      fsmpp2::pipeline<1024, Decoder, Session, Egress> chain{decoder, session, egress};
+ *      chain.push(Bytes{...});
+ *      chain.stop(); // drains all the stages
+ **/
+template<std::size_t Capacity, class... Machines>
+class pipeline {
+    static_assert(sizeof...(Machines) > 0, "empty pipeline");
+
+    static constexpr auto stages = sizeof...(Machines);
+    static constexpr std::size_t batch_size = Capacity < 64 ? Capacity : 64;
+
+    template<std::size_t I>
+    using machine_type = std::tuple_element_t<I, std::tuple<Machines...>>;
+
+    template<class M>
+    using envelope_type = envelope<typename M::events_type>;
+
+    template<class M>
+    using ring_type = detail::spsc_ring<envelope_type<M>, Capacity>;
+
+public:
+    /**
+     * Starts a thread for every stage.
+     **/
+    explicit pipeline(Machines&... machines)
+        : machines_ {machines...}
+        , rings_ {std::make_unique<ring_type<Machines>>()...}
+    {
+        start(std::index_sequence_for<Machines...>{});
+    }
+
+    pipeline(pipeline const&) = delete;
+    pipeline& operator=(pipeline const&) = delete;
+
+    ~pipeline() {
+        stop();
+    }
+
+    /**
+     * Tries to pass an event to the first stage, returns false if its input ring is full.
+     **/
+    template<class E>
+    bool try_push(E const& e) {
+        envelope_type<machine_type<0>> env {e};
+        return std::get<0>(rings_)->try_push(env);
+    }
+
+    /**
+     * Passes an event to the first stage, waits while its input ring is full.
+     * Must be called from a single thread.
+     **/
+    template<class E>
+    void push(E const& e) {
+        envelope_type<machine_type<0>> env {e};
+        auto& ring = *std::get<0>(rings_);
+
+        while (!ring.try_push(env)) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * Waits until all the events pushed so far are processed by all the stages
+     * and stops the threads. Must be called from the same thread as push().
+     **/
+    void stop() {
+        if (threads_.empty()) {
+            return;
+        }
+
+        closed_[0].store(true, std::memory_order_release);
+
+        for (auto& t : threads_) {
+            t.join();
+        }
+
+        threads_.clear();
+    }
+
+private:
+    template<std::size_t... I>
+    void start(std::index_sequence<I...>) {
+        threads_.reserve(stages);
+        (threads_.emplace_back([this] { run<I>(); }), ...);
+    }
+
+    template<std::size_t I>
+    void run() {
+        auto& machine = std::get<I>(machines_);
+        auto& input = *std::get<I>(rings_);
+        std::vector<envelope_type<machine_type<I>>> batch(batch_size);
+
+        while (true) {
+            // upstream publishes all its events before closing
+            auto const closed = closed_[I].load(std::memory_order_acquire);
+            auto const count = input.try_pop(batch.data(), batch.size());
+
+            for (std::size_t i = 0; i < count; ++i) {
+                batch[i].dispatch(machine);
+            }
+
+            if constexpr (I + 1 < stages) {
+                hand_off<I>();
+            }
+
+            if (count == 0) {
+                if (closed) {
+                    break;
+                }
+
+                std::this_thread::yield();
+            }
+        }
+
+        if constexpr (I + 1 < stages) {
+            closed_[I + 1].store(true, std::memory_order_release);
+        }
+    }
+
+    template<std::size_t I>
+    void hand_off() {
+        using next = machine_type<I + 1>;
+        auto& out = detail::find_outbox<outbox<typename next::events_type>>(std::get<I>(machines_).context());
+        auto& ring = *std::get<I + 1>(rings_);
+        auto& pending = out.pending_.items();
+
+        for (std::size_t done = 0; done < pending.size(); ) {
+            auto const n = ring.try_push(pending.data() + done, pending.size() - done);
+
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+
+            done += n;
+        }
+
+        out.pending_.clear();
+    }
+
+    std::tuple<Machines&...>                            machines_;
+    std::tuple<std::unique_ptr<ring_type<Machines>>...> rings_;
+    std::array<std::atomic<bool>, stages>               closed_ {};
+    std::vector<std::thread>                            threads_;
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_PIPELINE_HPP
@@ -18,6 +18,10 @@ inline auto sanitize_name(std::string str)
 
 inline void print_one_level(std::ostream &os, std::vector<fsmpp2::reflection::state_description> const& level)
 {
+    if (level.empty()) {
+        return;
+    }
+
     os << "[*] --> " << sanitize_name(level[0].name) << std::endl;
     for (auto &s : level) {
         for (auto &t : s.event_transitions) {
@@ -31,6 +35,20 @@ inline void print_one_level(std::ostream &os, std::vector<fsmpp2::reflection::st
             print_one_level(os, s.substates);
             os << "}" << std::endl;
         }
+
+        if (s.regions.size()) {
+            os << "state " << sanitize_name(s.name) << " {" << std::endl;
+
+            for (std::size_t i = 0; i < s.regions.size(); ++i) {
+                if (i > 0) {
+                    os << "--" << std::endl;
+                }
+
+                print_one_level(os, s.regions[i]);
+            }
+
+            os << "}" << std::endl;
+        }
     }
 }
 
@@ -8,6 +8,7 @@
 
 #include "fsmpp2/detail/traits.hpp"
 #include "fsmpp2/states.hpp"
+#include "fsmpp2/transition_table.hpp"
 #include <cxxabi.h>
 #include <string>
 #include <utility>
@@ -37,6 +38,8 @@ auto state_handle_result_type()
 {
     if constexpr (fsmpp2::detail::can_handle_event<StateType, Event>::value) {
         return get_type_name<decltype(std::declval<StateType>().handle(std::declval<Event>()))>();
+    } else if constexpr (fsmpp2::detail::can_handle_event_in_table<StateType, Event, fsmpp2::none>::value) {
+        return get_type_name<typename fsmpp2::detail::table_result<StateType, Event>::type>();
     } else {
         return std::string{"fsmpp2::transitions<>"};
     }
@@ -100,6 +103,8 @@ struct state_description
     std::string name;
     std::vector<transition> event_transitions;
     std::vector<state_description> substates;
+    // orthogonal regions of a parallel_state, substates is empty then
+    std::vector<std::vector<state_description>> regions;
 };
 
 template<class StateMachine, class EventList>
@@ -127,11 +132,20 @@ private:
         fill_events_information<T, Events...>(desc);
 
         // check for substates
-        using substate_description = state_machine_description<typename T::substates_type, fsmpp2::meta::type_list<Events...>>;
-        desc.substates = substate_description::get();
+        fill_substates(desc, typename T::substates_type{});
         res.push_back(desc);
     }
 
+    template<class... S>
+    static void fill_substates(state_description &desc, fsmpp2::states<S...>) {
+        desc.substates = state_machine_description<fsmpp2::states<S...>, fsmpp2::meta::type_list<Events...>>::get();
+    }
+
+    template<class... R>
+    static void fill_substates(state_description &desc, fsmpp2::regions<R...>) {
+        (desc.regions.push_back(state_machine_description<R, fsmpp2::meta::type_list<Events...>>::get()), ...);
+    }
+
     template<class S, class... E>
     static void fill_events_information(state_description &desc) {
         (fill_single_event_information<S, E>(desc), ...);
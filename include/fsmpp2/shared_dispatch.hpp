@@ -0,0 +1,67 @@
+#ifndef FSMPP2_SHARED_DISPATCH_HPP
+#define FSMPP2_SHARED_DISPATCH_HPP
+
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+namespace fsmpp2
+{
+
+/**
+ * State machine guarded by a reader-writer lock.
+ *
+ * Events handled in a read-only manner by all the states (see state_machine::is_read_only())
+ * are dispatched under a shared lock, so they run concurrently, all other
+ * events take an exclusive lock. The choice is made at compile time.
+ *
+ *      fsmpp2::shared_dispatch<fsmpp2::state_machine<States, Events, Context&>> sm{ctx};
+ *      sm.dispatch(GetStatus{});   // shared lock
+ *      sm.dispatch(Start{});       // exclusive lock
+ *
+ * As the const dispatch does not notify the tracer, query events are not traced.
+ **/
+template<class StateMachine, class SharedMutex = std::shared_mutex>
+class shared_dispatch {
+public:
+    /**
+     * Creates a state machine in place, all arguments are forwarded to its constructor.
+     **/
+    template<class... Args>
+    explicit shared_dispatch(Args&&... args)
+        : machine_ {std::forward<Args>(args)...}
+    {}
+
+    template<class E>
+    auto dispatch(E const& e) {
+        if constexpr (StateMachine::template is_read_only<E>()) {
+            std::shared_lock<SharedMutex> lock {mutex_};
+            return std::as_const(machine_).dispatch(e);
+        } else {
+            std::unique_lock<SharedMutex> lock {mutex_};
+            return machine_.dispatch(e);
+        }
+    }
+
+    /**
+     * Gets the state machine, access is not synchronized.
+     **/
+    StateMachine& machine() noexcept {
+        return machine_;
+    }
+
+    /**
+     * Gets the state machine, access is not synchronized.
+     **/
+    StateMachine const& machine() const noexcept {
+        return machine_;
+    }
+
+private:
+    SharedMutex     mutex_;
+    StateMachine    machine_;
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_SHARED_DISPATCH_HPP
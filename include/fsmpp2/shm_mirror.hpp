@@ -0,0 +1,478 @@
+#ifndef FSMPP2_SHM_MIRROR_HPP
+#define FSMPP2_SHM_MIRROR_HPP
+
+#include "fsmpp2/reflection.hpp"
+#include "fsmpp2/detail/state_tree.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fsmpp2::mirror
+{
+
+constexpr char magic[8] = {'F', 'S', 'M', 'P', 'P', '2', 'M', 'R'};
+constexpr std::uint32_t version = 1;
+
+// fixed layout limits, a reader compiled with different values refuses the segment
+constexpr std::size_t max_states = 64;
+constexpr std::size_t max_depth = 16;
+constexpr std::size_t label_size = 32;
+constexpr std::size_t names_size = 2048;
+
+/**
+ * Segment header, followed by slot_count slots.
+ **/
+struct segment_header {
+    char            magic[8];
+    std::uint32_t   version;
+    std::uint32_t   slot_size;
+    std::uint32_t   slot_count;
+    std::uint32_t   max_states;
+    std::uint32_t   max_depth;
+    std::uint32_t   names_size;
+};
+
+/**
+ * Shared memory image of a single state machine.
+ *
+ * Everything below seq is protected by a seqlock: the (only) writer makes
+ * seq odd, updates the data and makes it even again, a reader retries if
+ * seq was odd or has changed while it was copying the data.
+ **/
+struct slot {
+    std::atomic<std::uint32_t>  used;           // claimed by a tracer
+    std::atomic<std::uint32_t>  seq;
+    std::atomic<std::uint32_t>  state_count;
+    std::atomic<std::uint32_t>  depth;          // number of valid path entries
+    std::atomic<std::uint16_t>  path[max_depth];
+    std::atomic<std::uint64_t>  entered[max_states];
+    std::atomic<std::uint64_t>  handled[max_states];
+    char                        label[label_size];
+    char                        names[names_size]; // NUL separated state names, by id
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "lock-free 64 bit atomics required");
+static_assert(std::atomic<std::uint16_t>::is_always_lock_free, "lock-free 16 bit atomics required");
+
+/**
+ * Copy of a slot taken by a reader.
+ **/
+struct machine_snapshot {
+    std::string                 label;
+    std::vector<std::string>    states;     // state names, by id
+    std::vector<std::uint16_t>  path;       // active states, outermost first
+    std::vector<std::uint64_t>  entered;    // number of times a state was entered, by id
+    std::vector<std::uint64_t>  handled;    // number of events handled by a state, by id
+};
+
+namespace detail
+{
+
+inline std::size_t segment_size(std::size_t slots) noexcept {
+    return sizeof(segment_header) + slots * sizeof(slot);
+}
+
+inline slot* slot_at(void* base, std::size_t idx) noexcept {
+    return reinterpret_cast<slot*>(static_cast<char*>(base) + sizeof(segment_header)) + idx;
+}
+
+inline slot const* slot_at(void const* base, std::size_t idx) noexcept {
+    return reinterpret_cast<slot const*>(static_cast<char const*>(base) + sizeof(segment_header)) + idx;
+}
+
+template<class... S>
+void write_names(char (&out)[names_size], fsmpp2::meta::type_list<S...>) {
+    std::size_t pos = 0;
+
+    auto const append = [&](std::string const& name) {
+        auto const len = std::min(name.size(), names_size - pos - 1);
+        std::memcpy(out + pos, name.data(), len);
+        pos += len;
+        out[pos ++] = '\0';
+    };
+
+    // names not fitting into the table are left empty
+    ((pos < names_size ? append(reflection::get_type_name<S>()) : void()), ...);
+}
+
+} // namespace detail
+
+/**
+ * Tracer publishing current state path and per state counters of a state machine
+ * into a slot of a shared memory segment.
+ *
+ * Every update (a state entered or exited, a handled event) is a handful of
+ * relaxed stores bracketed by the seqlock, the dispatching thread never waits
+ * for readers and the seqlock is never held while user code runs. A transition
+ * is published step by step, a reader may see the path between leaving the
+ * source and entering the target. A default constructed tracer
+ * (or one for which the segment had no free slot) publishes nothing.
+ **/
+template<class States>
+class tracer {
+    using all_states = typename fsmpp2::detail::all_states<States>::type;
+
+    static_assert(fsmpp2::detail::states_count<States>() <= max_states, "too many states for shm mirror");
+
+public:
+    tracer() = default;
+
+    tracer(slot* s, std::string_view label) noexcept
+        : slot_ {s}
+        // continue the sequence of the previous owner so readers notice the change
+        , seq_ {(s->seq.load(std::memory_order_relaxed) + 1) & ~std::uint32_t{1}}
+    {
+        begin_write();
+
+        auto const len = std::min(label.size(), label_size - 1);
+        std::memcpy(slot_->label, label.data(), len);
+        slot_->label[len] = '\0';
+        detail::write_names(slot_->names, all_states{});
+
+        slot_->state_count.store(fsmpp2::detail::states_count<States>(), std::memory_order_relaxed);
+        slot_->depth.store(0, std::memory_order_relaxed);
+
+        for (std::size_t i = 0; i < max_states; ++i) {
+            slot_->entered[i].store(0, std::memory_order_relaxed);
+            slot_->handled[i].store(0, std::memory_order_relaxed);
+        }
+
+        end_write();
+    }
+
+    tracer(tracer&& other) noexcept
+        : slot_ {other.slot_}
+        , seq_ {other.seq_}
+    {
+        other.slot_ = nullptr;
+    }
+
+    tracer(tracer const&) = delete;
+    tracer& operator=(tracer const&) = delete;
+
+    ~tracer() {
+        if (slot_) {
+            slot_->used.store(0, std::memory_order_release);
+        }
+    }
+
+    /**
+     * True if the tracer has a slot to publish to.
+     **/
+    bool attached() const noexcept {
+        return slot_ != nullptr;
+    }
+
+    template<class S, class E>
+    void begin_event_handling() {}
+
+    template<class S, class E>
+    void end_event_handling(bool result) {
+        if (slot_ && result) {
+            update([this] {
+                increment(slot_->handled[id<S>()]);
+            });
+        }
+    }
+
+    template<class From, class E, class To>
+    void transition() {}
+
+    template<class S>
+    void enter_state(S const&) {
+        if (slot_) {
+            update([this] {
+                if constexpr (level<S>() < max_depth) {
+                    slot_->path[level<S>()].store(id<S>(), std::memory_order_relaxed);
+                }
+
+                slot_->depth.store(level<S>() + 1, std::memory_order_relaxed);
+                increment(slot_->entered[id<S>()]);
+            });
+        }
+    }
+
+    template<class S>
+    void exit_state(S const&) {
+        if (slot_) {
+            update([this] {
+                slot_->depth.store(level<S>(), std::memory_order_relaxed);
+            });
+        }
+    }
+
+private:
+    template<class S>
+    static constexpr std::uint16_t id() {
+        return static_cast<std::uint16_t>(fsmpp2::detail::state_id<S, States>());
+    }
+
+    template<class S>
+    static constexpr std::uint32_t level() {
+        return static_cast<std::uint32_t>(fsmpp2::detail::state_depths<States>()[id<S>()]);
+    }
+
+    // single writer, no read-modify-write needed
+    static void increment(std::atomic<std::uint64_t>& counter) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    template<class F>
+    void update(F&& f) noexcept {
+        begin_write();
+        f();
+        end_write();
+    }
+
+    void begin_write() noexcept {
+        slot_->seq.store(++ seq_, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void end_write() noexcept {
+        slot_->seq.store(++ seq_, std::memory_order_release);
+    }
+
+    slot*           slot_ = nullptr;
+    std::uint32_t   seq_ = 0;
+};
+
+/**
+ * Publisher side of the mirror, creates a named POSIX shared memory segment
+ * with a fixed number of slots and hands out tracers bound to free slots.
+ *
+ *      fsmpp2::mirror::segment shm{"/my-service", 1024};
+ *      fsmpp2::state_machine sm{States{}, Events{}, ctx, shm.make_tracer<States>("connection-1")};
+ *
+ * The segment is unlinked on destruction, tracers must not outlive it.
+ **/
+class segment {
+public:
+    segment(std::string name, std::size_t slots)
+        : name_ {std::move(name)}
+        , slots_ {slots}
+    {
+        auto const fd = ::shm_open(name_.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+
+        if (fd < 0) {
+            return;
+        }
+
+        auto const size = detail::segment_size(slots_);
+
+        if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            auto const ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+            if (ptr != MAP_FAILED) {
+                base_ = ptr;
+            }
+        }
+
+        ::close(fd);
+
+        if (!base_) {
+            ::shm_unlink(name_.c_str());
+            return;
+        }
+
+        for (std::size_t i = 0; i < slots_; ++i) {
+            new (detail::slot_at(base_, i)) slot{};
+        }
+
+        auto header = new (base_) segment_header{};
+        std::memcpy(header->magic, magic, sizeof(magic));
+        header->version = version;
+        header->slot_size = sizeof(slot);
+        header->slot_count = static_cast<std::uint32_t>(slots_);
+        header->max_states = max_states;
+        header->max_depth = max_depth;
+        header->names_size = names_size;
+    }
+
+    segment(segment const&) = delete;
+    segment& operator=(segment const&) = delete;
+
+    ~segment() {
+        if (base_) {
+            ::munmap(base_, detail::segment_size(slots_));
+            ::shm_unlink(name_.c_str());
+        }
+    }
+
+    /**
+     * False if the segment could not be created.
+     **/
+    bool valid() const noexcept {
+        return base_ != nullptr;
+    }
+
+    std::size_t slot_count() const noexcept {
+        return slots_;
+    }
+
+    /**
+     * Creates a tracer bound to a free slot, the slot is released when the tracer
+     * is destroyed. If there is no free slot the tracer publishes nothing.
+     **/
+    template<class States>
+    tracer<States> make_tracer(std::string_view label = {}) noexcept {
+        for (std::size_t i = 0; base_ && i < slots_; ++i) {
+            auto s = detail::slot_at(base_, i);
+            auto expected = std::uint32_t{0};
+
+            if (s->used.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+                return tracer<States>{s, label};
+            }
+        }
+
+        return tracer<States>{};
+    }
+
+private:
+    std::string     name_;
+    std::size_t     slots_;
+    void*           base_ = nullptr;
+};
+
+/**
+ * Read-only view of a segment created by another (or the same) process.
+ *
+ * Reading never blocks the publishers, a snapshot is retried if it was
+ * taken while the slot was being updated.
+ **/
+class reader {
+public:
+    explicit reader(std::string const& name) {
+        auto const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+
+        if (fd < 0) {
+            return;
+        }
+
+        segment_header header {};
+        struct stat st {};
+
+        // a truncated segment or a bogus slot_count would fault on reading past its end
+        if (::fstat(fd, &st) == 0
+            && ::pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))
+            && std::memcmp(header.magic, magic, sizeof(magic)) == 0
+            && header.version == version
+            && header.slot_size == sizeof(slot)
+            && header.max_states == max_states
+            && header.max_depth == max_depth
+            && header.names_size == names_size
+            && static_cast<std::uint64_t>(st.st_size) >= detail::segment_size(header.slot_count)) {
+            auto const size = detail::segment_size(header.slot_count);
+            auto const ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+            if (ptr != MAP_FAILED) {
+                base_ = ptr;
+                slots_ = header.slot_count;
+            }
+        }
+
+        ::close(fd);
+    }
+
+    reader(reader const&) = delete;
+    reader& operator=(reader const&) = delete;
+
+    ~reader() {
+        if (base_) {
+            ::munmap(base_, detail::segment_size(slots_));
+        }
+    }
+
+    /**
+     * False if the segment does not exist or has incompatible layout.
+     **/
+    bool valid() const noexcept {
+        return base_ != nullptr;
+    }
+
+    std::size_t slot_count() const noexcept {
+        return slots_;
+    }
+
+    /**
+     * Takes a consistent snapshot of idx-th slot.
+     *
+     * Returns false if the slot is not used or no consistent snapshot could be
+     * taken within max_retries attempts.
+     **/
+    bool read(std::size_t idx, machine_snapshot& out, std::size_t max_retries = 1000) const {
+        if (!base_ || idx >= slots_) {
+            return false;
+        }
+
+        auto const s = detail::slot_at(base_, idx);
+
+        for (std::size_t attempt = 0; attempt < max_retries; ++attempt) {
+            if (s->used.load(std::memory_order_acquire) == 0) {
+                return false;
+            }
+
+            auto const before = s->seq.load(std::memory_order_acquire);
+
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            copy(*s, out);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (s->seq.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    static void copy(slot const& s, machine_snapshot& out) {
+        auto const count = std::min<std::size_t>(s.state_count.load(std::memory_order_relaxed), max_states);
+        auto const depth = std::min<std::size_t>(s.depth.load(std::memory_order_relaxed), max_depth);
+
+        out.label.assign(s.label, ::strnlen(s.label, label_size));
+
+        out.states.clear();
+        for (std::size_t pos = 0; out.states.size() < count && pos < names_size; ) {
+            auto const len = ::strnlen(s.names + pos, names_size - pos);
+            out.states.emplace_back(s.names + pos, len);
+            pos += len + 1;
+        }
+        out.states.resize(count);
+
+        out.path.resize(depth);
+        for (std::size_t i = 0; i < depth; ++i) {
+            out.path[i] = s.path[i].load(std::memory_order_relaxed);
+        }
+
+        out.entered.resize(count);
+        out.handled.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            out.entered[i] = s.entered[i].load(std::memory_order_relaxed);
+            out.handled[i] = s.handled[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void*           base_ = nullptr;
+    std::size_t     slots_ = 0;
+};
+
+} // namespace fsmpp2::mirror
+
+#endif // FSMPP2_SHM_MIRROR_HPP
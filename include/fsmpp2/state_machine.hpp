@@ -2,12 +2,17 @@
 #define FSMPP2_STATE_MACHINE_HPP
 
 #include "fsmpp2/detail/state_manager.hpp"
+#include "fsmpp2/detail/path_publisher.hpp"
+#include "fsmpp2/context_access.hpp"
 #include "fsmpp2/contexts.hpp"
+#ifdef FSMPP2_USE_CPP20
+#include "fsmpp2/task.hpp"
+#endif
 
 namespace fsmpp2
 {
 #ifdef FSMPP2_USE_CPP20
-template<StatesList States, EventsList Events, class Context, class Tracer = detail::NullTracer>
+template<StatesList States, EventsList Events, class Context, class Tracer = detail::NullTracer, class Async = async_options<>>
 #else
 template<class States, class Events, class Context, class Tracer = detail::NullTracer>
 #endif
@@ -17,6 +22,7 @@ public:
     using states_type = States;
     using events_type = Events;
     using tracer_type = Tracer;
+    using path_id_type = detail::path_id_type;
 
     /**
      * Creates a state machine.
@@ -29,7 +35,7 @@ public:
         std::enable_if_t<std::is_constructible_v<T>, bool> = true>
     state_machine()
         : context_ {}
-        , manager_ {context_, tracer_}
+        , manager_ {context_, publisher_}
     {
     }
 
@@ -45,7 +51,7 @@ public:
         std::enable_if_t<std::is_lvalue_reference_v<T>, bool> = true>
     state_machine(Context& ctx)
         : context_ {ctx}
-        , manager_ {context_, tracer_}
+        , manager_ {context_, publisher_}
     {
     }
 
@@ -55,7 +61,7 @@ public:
         std::enable_if_t<!std::is_lvalue_reference_v<T>, bool> = true>
     state_machine(Context&& ctx)
         : context_ {std::move(ctx)}
-        , manager_ {context_, tracer_}
+        , manager_ {context_, publisher_}
     {
     }
 
@@ -71,17 +77,20 @@ public:
     #endif
     state_machine(S, E, C&& ctx)
         : context_ {std::forward<C>(ctx)}
-        , manager_ {context_, tracer_}
+        , manager_ {context_, publisher_}
     {
     }
 
     /**
      * Creates a state machine with a context and a tracer.
+     *
+     * If the tracer is passed as an lvalue the state machine refers to it
+     * instead of holding its own copy.
      **/
     state_machine(States, Events, Context& ctx, Tracer&& tracer)
         : context_ {ctx}
-        , tracer_ {std::move(tracer)}
-        , manager_ {context_, tracer}
+        , tracer_ {std::forward<Tracer>(tracer)}
+        , manager_ {context_, publisher_}
     {
     }
 
@@ -94,11 +103,27 @@ public:
     template<class E>
     #endif
     auto dispatch(E const& e) {
-        return manager_.dispatch(e);
+#ifdef FSMPP2_USE_CPP20
+        if constexpr (has_async_handlers) {
+            if (async_.busy()) {
+                return async_.queue(e);
+            }
+
+            // handler coroutine frames are allocated from the arena of this state machine
+            detail::frame_pool_scope scope {async_.pool()};
+            return handle_event(e);
+        }
+#endif
+        return handle_event(e);
     }
 
     /**
-     * Dispatch an event to a current state.
+     * Dispatch an event to a current state without modifying the state machine.
+     *
+     * Only events handled by const, non-transitioning handlers in all the states
+     * (see is_read_only()) can be dispatched this way. It may be called from many
+     * threads at once as long as no other thread calls the non-const dispatch,
+     * tracer is not notified.
      **/
     #ifdef FSMPP2_USE_CPP20
     template<Event E>
@@ -106,9 +131,98 @@ public:
     template<class E>
     #endif
     auto dispatch(E const& e) const {
+        static_assert(is_read_only<E>(), "event may modify a state or cause a transition, it can't be dispatched to a const state machine");
         return manager_.dispatch(e);
     }
 
+#ifdef FSMPP2_USE_CPP20
+    /**
+     * Checks if a coroutine handler is suspended. Events dispatched in the meantime
+     * are queued or rejected according to the busy policy of Async options.
+     **/
+    bool busy() const noexcept {
+        return async_.busy();
+    }
+
+    /**
+     * Number of events queued while a coroutine handler is suspended.
+     **/
+    std::size_t queued_events() const noexcept {
+        return async_.queued();
+    }
+#endif
+
+    /**
+     * Number of events deferred by active states, waiting to be replayed.
+     **/
+    std::size_t deferred_events() const noexcept {
+        return deferred_.size();
+    }
+
+    /**
+     * Checks if all the handlers of an event E are const member functions (taking
+     * the context, if any, by a const reference) and do not request a transition.
+     **/
+    template<class E>
+    static constexpr bool is_read_only() noexcept {
+        return detail::is_read_only_event<States, E, std::remove_reference_t<Context>>::value;
+    }
+
+    /**
+     * Id of the innermost active state, it identifies the whole active state path.
+     *
+     * It is published with a release store on every state entry and may be read
+     * from any thread concurrently with dispatch.
+     **/
+    path_id_type current_path_id() const noexcept {
+        static_assert(!detail::has_regions<States>::value, "with orthogonal regions there's no single active path, use is_in()");
+        return active_.leaf();
+    }
+
+    /**
+     * Id of a state path to compare with current_path_id(), eg. path_id<StateA, SubStateA1>().
+     *
+     * Every state in Path must be a direct substate of the preceding one.
+     **/
+    template<class... Path>
+    static constexpr path_id_type path_id() noexcept {
+        static_assert(sizeof...(Path) > 0, "empty state path");
+        static_assert(is_valid_path<Path...>(), "not a path of nested states");
+
+        return static_cast<path_id_type>((detail::state_id<Path, States>(), ...));
+    }
+
+    /**
+     * Checks if a state path is active, eg. is_in<StateA>() is true when in StateA or any
+     * of its substates, is_in<StateA, SubStateA1>() when in SubStateA1 of StateA.
+     *
+     * Can be called from any thread concurrently with dispatch.
+     **/
+    template<class... Path>
+    bool is_in() const noexcept {
+        constexpr auto last = path_id<Path...>();
+        constexpr auto size = detail::state_subtree_sizes<States>()[last];
+
+        return active_.is_active(last, size);
+    }
+
+    /**
+     * Type list of contexts which may be accessed when State handles event E.
+     *
+     * It covers contexts passed to the handler, to the State constructor (the state may
+     * keep them) and, if the handler may request a transition, to constructors of
+     * all states being left or entered. Always empty if State does not handle E.
+     **/
+    template<class State, class E>
+    using context_access = typename detail::state_event_access<State, E, std::remove_reference_t<Context>, States>::type;
+
+    /**
+     * Type list of contexts which may be accessed when E is dispatched, whatever the current state is.
+     * If E may cause a transition it includes contexts of deferred events replayed afterwards.
+     **/
+    template<class E>
+    using event_context_access = typename detail::event_access<States, E, std::remove_reference_t<Context>>::type;
+
     /**
      * Gets a reference to a tracer object.
      **/
@@ -137,17 +251,71 @@ public:
         return context_;
     }
 
+#ifdef FSMPP2_USE_CPP20
+    ~state_machine() {
+        // a suspended coroutine handler refers to its state, drop it before the states are left
+        async_.cancel();
+    }
+#endif
+
 private:
+    template<class... Path>
+    static constexpr bool is_valid_path() {
+        constexpr auto count = detail::states_count<States>();
+        constexpr std::size_t ids[] = {detail::state_id<Path, States>()...};
+        constexpr auto parents = detail::state_parents<States>();
+
+        for (std::size_t i = 0; i < sizeof...(Path); ++i) {
+            if (ids[i] >= count || (i > 0 && parents[ids[i]] != ids[i - 1])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template<class E>
+    bool handle_event(E const& e) {
+        detail::trace_dispatch(tracer_);
+
+        auto const result = manager_.dispatch(e);
+        // no-op unless a state defers events and one was left
+        deferred_.replay(*this);
+        return result;
+    }
+
+    using deferred_type = detail::deferred_queue<Events, detail::deferred_capacity<States>::value>;
+    using publisher_type = detail::path_publisher<States, Tracer, deferred_type>;
+
+#ifdef FSMPP2_USE_CPP20
+    static constexpr bool has_async_handlers = detail::has_async_handlers<States, Events, std::remove_reference_t<Context>>::value;
+
+    static void replay_pending(void* self) {
+        auto& sm = *static_cast<state_machine*>(self);
+        sm.deferred_.replay(sm);
+        sm.async_.replay(sm);
+    }
+#endif
+
     Context                                 context_;
     Tracer                                  tracer_;
+    detail::active_states<States>           active_;
+    deferred_type                           deferred_;
+#ifdef FSMPP2_USE_CPP20
+    detail::async_runtime<Events, Async, has_async_handlers> async_ {this, &replay_pending};
+    publisher_type                          publisher_ {tracer_, active_, deferred_, async_.slot()};
+#else
+    publisher_type                          publisher_ {tracer_, active_, deferred_};
+#endif
     detail::state_manager<
         States,
         std::remove_reference_t<Context>,
-        Tracer>                             manager_;
+        publisher_type>                     manager_;
 };
 
 template<class S, class E, class C> state_machine(S, E, C&) -> state_machine<S, E, C&>;
 template<class S, class E, class C> state_machine(S, E, C&&) -> state_machine<S, E, C>;
+template<class S, class E, class C, class T> state_machine(S, E, C&, T&&) -> state_machine<S, E, C&, T>;
 
 } // namespace fsmpp2
 
@@ -0,0 +1,198 @@
+#ifndef FSMPP2_STATE_TIMEOUTS_HPP
+#define FSMPP2_STATE_TIMEOUTS_HPP
+
+#include "fsmpp2/timer_wheel.hpp"
+#include "fsmpp2/detail/state_tree.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <type_traits>
+
+namespace fsmpp2
+{
+
+/**
+ * Base class for a state with a timeout set at run time (usually in its constructor):
+ *
+ *      struct Heating : fsmpp2::state<>, fsmpp2::state_timeout<HeatingDone> {
+ *          Heating(Context& ctx) { set_timeout(ctx.heating_time); }
+ *      };
+ *
+ * A state with a constant timeout may instead declare:
+ *
+ *      using timeout_event = CookingDone;
+ *      static constexpr auto timeout = std::chrono::seconds{30};
+ **/
+template<class E>
+class state_timeout {
+public:
+    using timeout_event = E;
+
+    template<class Rep, class Period>
+    void set_timeout(std::chrono::duration<Rep, Period> after) noexcept {
+        timeout_ = std::chrono::duration_cast<std::chrono::nanoseconds>(after);
+        enabled_ = true;
+    }
+
+    void clear_timeout() noexcept {
+        enabled_ = false;
+    }
+
+    bool has_timeout() const noexcept {
+        return enabled_;
+    }
+
+    std::chrono::nanoseconds timeout_duration() const noexcept {
+        return timeout_;
+    }
+
+private:
+    std::chrono::nanoseconds    timeout_ {0};
+    bool                        enabled_ = false;
+};
+
+namespace detail
+{
+
+template<class S, class = void>
+struct has_timeout_event : std::false_type {};
+
+template<class S>
+struct has_timeout_event<S, std::void_t<typename S::timeout_event>> : std::true_type {};
+
+template<class S, class = void>
+struct has_dynamic_timeout : std::false_type {};
+
+template<class S>
+struct has_dynamic_timeout<S, std::void_t<decltype(std::declval<S const&>().timeout_duration())>> : std::true_type {};
+
+} // namespace detail
+
+/**
+ * Tracer arming per-state timeouts in a timer_wheel.
+ *
+ * A timer is armed when a state declaring a timeout is entered and cancelled when
+ * the state is left, on expiry a default constructed S::timeout_event is dispatched
+ * to the attached state machine. Every state has its own timer, so nested states
+ * and states in orthogonal regions may time out independently.
+ *
+ *      fsmpp2::timer_wheel wheel;
+ *      fsmpp2::timeout_tracer<States> timeouts {wheel};
+ *      fsmpp2::state_machine sm {States{}, Events{}, ctx, timeouts};
+ *      timeouts.attach(sm);
+ *
+ *      wheel.advance(std::chrono::seconds{1});
+ *
+ * Timeouts of states entered before attach() are armed, but expire without effect
+ * until a state machine is attached.
+ **/
+template<class States>
+class timeout_tracer {
+    static constexpr auto count = detail::states_count<States>();
+
+public:
+    explicit timeout_tracer(timer_wheel& wheel) noexcept
+        : wheel_ {wheel}
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            timers_[i].owner = this;
+            timers_[i].id = i;
+            timers_[i].set_callback(&expired);
+        }
+    }
+
+    timeout_tracer(timeout_tracer const&) = delete;
+    timeout_tracer& operator=(timeout_tracer const&) = delete;
+
+    /**
+     * Sets the state machine receiving timeout events.
+     **/
+    template<class StateMachine>
+    void attach(StateMachine& sm) noexcept {
+        machine_ = &sm;
+        fill_dispatchers<StateMachine>(typename detail::all_states<States>::type{});
+    }
+
+    /**
+     * Checks if the timeout of a State is armed.
+     **/
+    template<class State>
+    bool armed() const noexcept {
+        return timers_[detail::state_id<State, States>()].armed();
+    }
+
+    template<class State, class E>
+    void begin_event_handling() {}
+
+    void end_event_handling(bool) {}
+
+    template<class State>
+    void transition() {}
+
+    template<class State>
+    void enter_state(State const& state) {
+        if constexpr (detail::has_timeout_event<State>::value) {
+            auto& t = timers_[detail::state_id<State, States>()];
+
+            if constexpr (detail::has_dynamic_timeout<State>::value) {
+                if (state.has_timeout()) {
+                    wheel_.arm(t, state.timeout_duration());
+                }
+            } else {
+                wheel_.arm(t, State::timeout);
+            }
+        }
+    }
+
+    template<class State>
+    void exit_state(State const&) {
+        if constexpr (detail::has_timeout_event<State>::value) {
+            timers_[detail::state_id<State, States>()].cancel();
+        }
+    }
+
+private:
+    struct state_timer : timer {
+        timeout_tracer* owner = nullptr;
+        std::size_t     id = 0;
+    };
+
+    using dispatcher = void (*)(void*);
+
+    static void expired(timer& t) {
+        auto& st = static_cast<state_timer&>(t);
+        auto& self = *st.owner;
+
+        if (self.machine_ != nullptr && self.dispatchers_[st.id] != nullptr) {
+            self.dispatchers_[st.id](self.machine_);
+        }
+    }
+
+    template<class StateMachine, class S>
+    static void dispatch_timeout(void* sm) {
+        static_cast<StateMachine*>(sm)->dispatch(typename S::timeout_event{});
+    }
+
+    template<class StateMachine, class... S>
+    void fill_dispatchers(meta::type_list<S...>) noexcept {
+        ((dispatchers_[detail::state_id<S, States>()] = dispatcher_for<StateMachine, S>()), ...);
+    }
+
+    template<class StateMachine, class S>
+    static constexpr dispatcher dispatcher_for() noexcept {
+        if constexpr (detail::has_timeout_event<S>::value) {
+            return &dispatch_timeout<StateMachine, S>;
+        } else {
+            return nullptr;
+        }
+    }
+
+    timer_wheel&                        wheel_;
+    void*                               machine_ = nullptr;
+    std::array<dispatcher, count>       dispatchers_ {};
+    std::array<state_timer, count>      timers_;
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_STATE_TIMEOUTS_HPP
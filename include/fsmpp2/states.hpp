@@ -15,6 +15,12 @@ namespace fsmpp2
  **/
 struct event {};
 
+/**
+ * Pseudo event reported to tracers for transitions requested by a state's
+ * completion check, see state_manager::complete().
+ **/
+struct completion_event : event {};
+
 #ifdef FSMPP2_USE_CPP20
 template<class T>
 concept Event = std::is_base_of_v<event, T>;
@@ -110,6 +116,41 @@ template<class L> concept StatesList = detail::is_states_list<L>::value;
 template<class L> concept EventsList = detail::is_events_list<L>::value;
 #endif
 
+/**
+ * A set of orthogonal regions, each region is a states<> list.
+ *
+ * All the regions are active at the same time, each one has its own current
+ * state. It's used as substates of a parallel_state.
+ **/
+#ifdef FSMPP2_USE_CPP20
+template<StatesList... R>
+#else
+template<class... R>
+#endif
+struct regions {
+    static constexpr auto count = sizeof...(R);
+};
+
+/**
+ * Denotes a state with orthogonal regions.
+ *
+ * When the state is entered, initial states of all the Regions are entered (in order),
+ * an event is passed to every region which can handle it and is considered handled if
+ * any of the regions handled it. Otherwise it is passed to the parallel state itself.
+ *
+ *      struct Online : fsmpp2::parallel_state<
+ *          fsmpp2::states<Disconnected, Connected>,
+ *          fsmpp2::states<Anonymous, Authenticated>> {};
+ **/
+#ifdef FSMPP2_USE_CPP20
+template<StatesList... Regions>
+#else
+template<class... Regions>
+#endif
+struct parallel_state : state<> {
+    using substates_type = regions<Regions...>;
+};
+
 } // namespace fsmpp2
 
 #endif // FSMPP2_STATES_HPP
\ No newline at end of file
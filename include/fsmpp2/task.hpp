@@ -0,0 +1,421 @@
+#ifndef FSMPP2_TASK_HPP
+#define FSMPP2_TASK_HPP
+
+#include "fsmpp2/config.hpp"
+
+#ifdef FSMPP2_USE_CPP20
+
+#include "fsmpp2/meta.hpp"
+#include "fsmpp2/transitions.hpp"
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace fsmpp2
+{
+
+namespace detail
+{
+
+/**
+ * Fixed pool of coroutine frame blocks, the storage is owned by a frame_arena.
+ **/
+class frame_pool {
+    struct node {
+        node* next;
+    };
+
+public:
+    frame_pool(frame_pool const&) = delete;
+    frame_pool& operator=(frame_pool const&) = delete;
+
+    /**
+     * Takes a block, throws std::bad_alloc if the frame does not fit or there are no free blocks.
+     **/
+    void* allocate(std::size_t size) {
+        if (size > block_size_ || free_ == nullptr) {
+            throw std::bad_alloc {};
+        }
+
+        auto* block = free_;
+        free_ = free_->next;
+        available_ --;
+        return block;
+    }
+
+    void deallocate(void* block) noexcept {
+        free_ = new (block) node {free_};
+        available_ ++;
+    }
+
+    std::size_t block_size() const noexcept {
+        return block_size_;
+    }
+
+    /**
+     * Number of free blocks.
+     **/
+    std::size_t available() const noexcept {
+        return available_;
+    }
+
+protected:
+    frame_pool() noexcept = default;
+
+    void init(unsigned char* memory, std::size_t block_size, std::size_t blocks) noexcept {
+        block_size_ = block_size;
+        available_ = blocks;
+
+        for (std::size_t i = blocks; i-- > 0; ) {
+            free_ = new (memory + i * block_size) node {free_};
+        }
+    }
+
+private:
+    node*       free_ = nullptr;
+    std::size_t block_size_ = 0;
+    std::size_t available_ = 0;
+};
+
+/**
+ * Pool new coroutine frames are allocated from on this thread, the heap if null.
+ **/
+inline frame_pool*& current_frame_pool() noexcept {
+    thread_local frame_pool* pool = nullptr;
+    return pool;
+}
+
+struct frame_pool_scope {
+    explicit frame_pool_scope(frame_pool* pool) noexcept
+        : previous {std::exchange(current_frame_pool(), pool)}
+    {}
+
+    frame_pool_scope(frame_pool_scope const&) = delete;
+    frame_pool_scope& operator=(frame_pool_scope const&) = delete;
+
+    ~frame_pool_scope() {
+        current_frame_pool() = previous;
+    }
+
+    frame_pool* previous;
+};
+
+// every frame is preceded by a pointer to its pool, so it can be released anywhere
+constexpr std::size_t frame_header = alignof(std::max_align_t);
+
+inline void* allocate_frame(std::size_t size) {
+    auto* pool = current_frame_pool();
+    auto* block = static_cast<unsigned char*>(
+        pool != nullptr ? pool->allocate(size + frame_header) : ::operator new(size + frame_header));
+
+    new (block) frame_pool* {pool};
+    return block + frame_header;
+}
+
+inline void deallocate_frame(void* frame) noexcept {
+    auto* block = static_cast<unsigned char*>(frame) - frame_header;
+    auto* pool = *std::launder(reinterpret_cast<frame_pool**>(block));
+
+    if (pool != nullptr) {
+        pool->deallocate(block);
+    } else {
+        ::operator delete(block);
+    }
+}
+
+template<class A>
+decltype(auto) get_awaiter(A&& awaitable) {
+    if constexpr (requires { std::forward<A>(awaitable).operator co_await(); }) {
+        return std::forward<A>(awaitable).operator co_await();
+    } else if constexpr (requires { operator co_await(std::forward<A>(awaitable)); }) {
+        return operator co_await(std::forward<A>(awaitable));
+    } else {
+        return std::forward<A>(awaitable);
+    }
+}
+
+/**
+ * Makes the pool of a task current while the task runs, restoring the pool of
+ * whoever resumed it when the task suspends again.
+ **/
+struct frame_pool_binding {
+    void resumed() noexcept {
+        previous = std::exchange(current_frame_pool(), pool);
+    }
+
+    void suspended() noexcept {
+        current_frame_pool() = previous;
+    }
+
+    frame_pool* pool = current_frame_pool();
+    frame_pool* previous = nullptr;
+};
+
+template<class Awaiter>
+struct bound_awaiter {
+    bool await_ready() {
+        return awaiter.await_ready();
+    }
+
+    template<class Promise>
+    auto await_suspend(std::coroutine_handle<Promise> h) {
+        binding.suspended();
+        return awaiter.await_suspend(h);
+    }
+
+    decltype(auto) await_resume() {
+        binding.resumed();
+        return awaiter.await_resume();
+    }
+
+    Awaiter             awaiter;
+    frame_pool_binding& binding;
+};
+
+template<class R> struct task_transitions { using type = meta::type_list<>; };
+template<class... S> struct task_transitions<transitions<S...>> { using type = meta::type_list<S...>; };
+
+} // namespace detail
+
+/**
+ * Pool of BlockSize byte blocks for coroutine frames of asynchronous handlers,
+ * embedded in the object so a state machine with async handlers does not allocate.
+ **/
+template<std::size_t BlockSize, std::size_t Blocks>
+class frame_arena : public detail::frame_pool {
+    static constexpr auto block = (BlockSize + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+public:
+    frame_arena() noexcept {
+        init(memory_, block, Blocks);
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char memory_[block * Blocks];
+};
+
+/**
+ * Lazily started coroutine producing a value of type R.
+ *
+ * A state handler returning task<transitions<...>> is asynchronous, the state machine
+ * starts it on dispatch and applies the transition when it completes:
+ *
+ *      fsmpp2::task<fsmpp2::transitions<Connected, Failed>> handle(Connect const& e, Context& ctx) {
+ *          auto ok = co_await ctx.socket.async_connect(e.address);
+ *          co_return ok ? transition<Connected>() : transition<Failed>();
+ *      }
+ *
+ * A task may await other tasks. Frames are allocated from the frame_arena of the
+ * state machine running the handler, or from the heap outside of state machines.
+ **/
+template<class R>
+class task {
+public:
+    struct promise_type;
+    using handle_type = std::coroutine_handle<promise_type>;
+    using value_type = R;
+
+    // transitions the handler may request, used by context access analysis
+    using list = typename detail::task_transitions<R>::type;
+
+    struct final_awaiter {
+        bool await_ready() noexcept {
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(handle_type h) noexcept {
+            auto& p = h.promise();
+            p.binding.suspended();
+
+            if (p.continuation) {
+                return p.continuation;
+            }
+
+            // may destroy the frame, nothing can be touched afterwards
+            if (p.on_done != nullptr) {
+                p.on_done(p.on_done_arg);
+            }
+
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    struct initial_awaiter {
+        bool await_ready() noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<>) noexcept {}
+
+        void await_resume() noexcept {
+            binding.resumed();
+        }
+
+        detail::frame_pool_binding& binding;
+    };
+
+    struct promise_type {
+        static void* operator new(std::size_t size) {
+            return detail::allocate_frame(size);
+        }
+
+        static void operator delete(void* frame) noexcept {
+            detail::deallocate_frame(frame);
+        }
+
+        task get_return_object() noexcept {
+            return task {handle_type::from_promise(*this)};
+        }
+
+        initial_awaiter initial_suspend() noexcept {
+            return {binding};
+        }
+
+        final_awaiter final_suspend() noexcept {
+            return {};
+        }
+
+        template<class U>
+        void return_value(U&& value) {
+            result.emplace(std::forward<U>(value));
+        }
+
+        void unhandled_exception() noexcept {
+            exception = std::current_exception();
+        }
+
+        template<class A>
+        auto await_transform(A&& awaitable) {
+            using awaiter = decltype(detail::get_awaiter(std::forward<A>(awaitable)));
+            return detail::bound_awaiter<awaiter> {detail::get_awaiter(std::forward<A>(awaitable)), binding};
+        }
+
+        std::optional<R>            result;
+        std::exception_ptr          exception;
+        std::coroutine_handle<>     continuation;
+        void                        (*on_done)(void*) = nullptr;
+        void*                       on_done_arg = nullptr;
+        detail::frame_pool_binding  binding;
+    };
+
+    task(task&& other) noexcept
+        : handle_ {std::exchange(other.handle_, {})}
+    {}
+
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+
+        return *this;
+    }
+
+    ~task() {
+        reset();
+    }
+
+    /**
+     * Takes over a frame released with release().
+     **/
+    static task adopt(std::coroutine_handle<> h) noexcept {
+        return task {handle_type::from_address(h.address())};
+    }
+
+    handle_type release() noexcept {
+        return std::exchange(handle_, {});
+    }
+
+    bool done() const noexcept {
+        return handle_ && handle_.done();
+    }
+
+    /**
+     * Result of a completed task, rethrows an exception which escaped the coroutine.
+     **/
+    R result() {
+        auto& p = handle_.promise();
+
+        if (p.exception) {
+            std::rethrow_exception(p.exception);
+        }
+
+        return std::move(*p.result);
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+
+    R await_resume() {
+        return result();
+    }
+
+private:
+    explicit task(handle_type h) noexcept
+        : handle_ {h}
+    {}
+
+    void reset() noexcept {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    handle_type handle_;
+};
+
+/**
+ * Events dispatched to a state machine while an asynchronous handler is suspended
+ * are queued, up to Capacity events, and dispatched in order when it completes.
+ * Events beyond the capacity are rejected.
+ **/
+template<std::size_t Capacity>
+struct busy_queue {
+    static constexpr std::size_t capacity = Capacity;
+};
+
+/**
+ * Events dispatched to a state machine while an asynchronous handler is suspended are rejected.
+ **/
+struct busy_reject {
+    static constexpr std::size_t capacity = 0;
+};
+
+/**
+ * Asynchronous handlers configuration of a state_machine: size and number of coroutine
+ * frame blocks (a handler awaiting other tasks needs a block for each of them) and
+ * the policy for events dispatched while a handler is suspended.
+ **/
+template<std::size_t FrameSize = 512, std::size_t Frames = 2, class BusyPolicy = busy_queue<16>>
+struct async_options {
+    static constexpr std::size_t frame_size = FrameSize;
+    static constexpr std::size_t frames = Frames;
+    using busy_policy = BusyPolicy;
+};
+
+namespace detail
+{
+
+template<class T> struct is_task : std::false_type {};
+template<class R> struct is_task<task<R>> : std::true_type {};
+
+} // namespace detail
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_USE_CPP20
+
+#endif // FSMPP2_TASK_HPP
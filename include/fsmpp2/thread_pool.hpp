@@ -0,0 +1,177 @@
+#ifndef FSMPP2_THREAD_POOL_HPP
+#define FSMPP2_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fsmpp2
+{
+
+/**
+ * Fixed size pool of threads executing fork-join parallel loops.
+ *
+ * The calling thread takes part in every loop, so a pool created with N
+ * threads runs loops on N + 1 threads. Only one loop may run at a time.
+ **/
+class thread_pool {
+public:
+    /**
+     * Creates a pool with a given number of additional threads, by default one less
+     * than the number of hardware threads.
+     **/
+    explicit thread_pool(std::size_t threads = default_threads()) {
+        workers_.reserve(threads);
+
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this, i] { run(i + 1); });
+        }
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock {mutex_};
+            stop_ = true;
+        }
+
+        start_.notify_all();
+
+        for (auto& t : workers_) {
+            t.join();
+        }
+    }
+
+    /**
+     * Number of threads executing a loop, including the calling one.
+     **/
+    std::size_t size() const noexcept {
+        return workers_.size() + 1;
+    }
+
+    /**
+     * Calls fun(thread_index, begin, end) for consecutive chunks of [0, count) range,
+     * blocks until all the chunks are done.
+     *
+     * Threads grab chunks dynamically so the load is balanced, thread_index is
+     * lower than size() and may be used to index per thread data.
+     *
+     * If fun throws, chunks not started yet are skipped and the first exception
+     * is rethrown once all the threads are done with the loop.
+     **/
+    template<class F>
+    void parallel_for(std::size_t count, std::size_t chunk, F&& fun) {
+        if (chunk == 0) {
+            chunk = 1;
+        }
+
+        std::unique_lock<std::mutex> lock {mutex_};
+
+        job_ = job{
+            [](void* f, std::size_t thread, std::size_t begin, std::size_t end) {
+                (*static_cast<std::remove_reference_t<F>*>(f))(thread, begin, end);
+            },
+            &fun,
+            count,
+            chunk};
+        next_.store(0, std::memory_order_relaxed);
+        busy_ = workers_.size();
+        generation_ ++;
+
+        lock.unlock();
+        start_.notify_all();
+
+        execute(0);
+
+        lock.lock();
+        done_.wait(lock, [this] { return busy_ == 0; });
+
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+
+private:
+    static std::size_t default_threads() noexcept {
+        auto const hw = std::thread::hardware_concurrency();
+        return hw > 1 ? hw - 1 : 0;
+    }
+
+    struct job {
+        void (*call)(void*, std::size_t, std::size_t, std::size_t) = nullptr;
+        void*       fun = nullptr;
+        std::size_t count = 0;
+        std::size_t chunk = 1;
+    };
+
+    void run(std::size_t thread) {
+        std::size_t seen = 0;
+        std::unique_lock<std::mutex> lock {mutex_};
+
+        while (true) {
+            start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+
+            if (stop_) {
+                return;
+            }
+
+            seen = generation_;
+
+            lock.unlock();
+            execute(thread);
+            lock.lock();
+
+            if (-- busy_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    // job_ is not modified until all the threads are done with it
+    void execute(std::size_t thread) noexcept {
+        try {
+            while (true) {
+                auto const begin = next_.fetch_add(job_.chunk, std::memory_order_relaxed);
+
+                if (begin >= job_.count) {
+                    return;
+                }
+
+                auto const end = begin + job_.chunk < job_.count ? begin + job_.chunk : job_.count;
+                job_.call(job_.fun, thread, begin, end);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock {mutex_};
+
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+
+            // the remaining chunks are skipped by all the threads
+            next_.store(job_.count, std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<std::thread>    workers_;
+    std::mutex                  mutex_;
+    std::condition_variable     start_;
+    std::condition_variable     done_;
+    bool                        stop_ = false;
+    std::size_t                 generation_ = 0;
+    std::size_t                 busy_ = 0;
+    job                         job_;
+    std::atomic<std::size_t>    next_ {0};
+    std::exception_ptr          error_;
+};
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_THREAD_POOL_HPP
@@ -0,0 +1,346 @@
+#ifndef FSMPP2_TIMER_WHEEL_HPP
+#define FSMPP2_TIMER_WHEEL_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace fsmpp2
+{
+
+class timer_wheel;
+
+/**
+ * Timer armed in a timer_wheel.
+ *
+ * Timers are intrusive, the wheel only links them together, so arming and
+ * cancelling never allocates. A timer is cancelled when destroyed.
+ **/
+class timer {
+public:
+    using callback_type = void (*)(timer&);
+
+    timer() noexcept = default;
+
+    explicit timer(callback_type callback) noexcept
+        : callback_ {callback}
+    {}
+
+    timer(timer const&) = delete;
+    timer& operator=(timer const&) = delete;
+
+    ~timer() {
+        cancel();
+    }
+
+    void set_callback(callback_type callback) noexcept {
+        callback_ = callback;
+    }
+
+    bool armed() const noexcept {
+        return wheel_ != nullptr;
+    }
+
+    /**
+     * Expiration time in wheel ticks, valid while armed.
+     **/
+    std::uint64_t expires() const noexcept {
+        return expires_;
+    }
+
+    inline void cancel() noexcept;
+
+private:
+    friend class timer_wheel;
+
+    void unlink() noexcept {
+        prev_->next_ = next_;
+        next_->prev_ = prev_;
+        prev_ = next_ = this;
+    }
+
+    void link_before(timer& node) noexcept {
+        prev_ = node.prev_;
+        next_ = &node;
+        node.prev_->next_ = this;
+        node.prev_ = this;
+    }
+
+    timer*          prev_ = this;
+    timer*          next_ = this;
+    timer_wheel*    wheel_ = nullptr;
+    std::uint64_t   expires_ = 0;
+    callback_type   callback_ = nullptr;
+    std::uint8_t    level_ = 0;
+    std::uint8_t    slot_ = 0;
+};
+
+/**
+ * Hierarchical timing wheel.
+ *
+ * Time is virtual, measured in ticks of a given resolution and moved forward only
+ * by advance(), so tests may drive it explicitly and applications may advance it
+ * from a real clock. There are 5 levels of 64 slots: level 0 holds timers expiring
+ * within 64 ticks, each next level covers 64 times longer span with a coarser slot
+ * and is cascaded down when the time reaches its slot. Timers beyond the range
+ * (2^30 ticks) are re-cascaded at the top level until they are in range.
+ *
+ * Arming and cancelling is O(1), the number of pending timers is not limited.
+ * Every level keeps a bitmap of non-empty slots, advance() jumps straight to the
+ * next tick with anything to expire or cascade. Callbacks are called from advance()
+ * and may arm and cancel any timers.
+ **/
+class timer_wheel {
+    static constexpr std::size_t level_bits = 6;
+    static constexpr std::size_t slots = std::size_t{1} << level_bits;
+    static constexpr std::size_t levels = 5;
+    static constexpr std::uint64_t range = std::uint64_t{1} << (level_bits * levels);
+
+public:
+    using duration = std::chrono::nanoseconds;
+
+    explicit timer_wheel(duration resolution = std::chrono::milliseconds{1}) noexcept
+        : resolution_ {resolution.count() > 0 ? resolution : duration{1}}
+    {}
+
+    timer_wheel(timer_wheel const&) = delete;
+    timer_wheel& operator=(timer_wheel const&) = delete;
+
+    ~timer_wheel() {
+        for (auto& level : wheel_) {
+            for (auto& slot : level) {
+                while (slot.next_ != &slot) {
+                    auto* t = slot.next_;
+                    t->unlink();
+                    t->wheel_ = nullptr;
+                }
+            }
+        }
+    }
+
+    /**
+     * Arms (or re-arms) a timer to expire after a number of ticks (at least one).
+     **/
+    void arm_ticks(timer& t, std::uint64_t ticks) noexcept {
+        t.cancel();
+        t.expires_ = now_ + (ticks > 0 ? ticks : 1);
+        t.wheel_ = this;
+        pending_ ++;
+        insert(t);
+    }
+
+    /**
+     * Arms (or re-arms) a timer to expire after a time, rounded up to the wheel resolution.
+     **/
+    template<class Rep, class Period>
+    void arm(timer& t, std::chrono::duration<Rep, Period> after) noexcept {
+        arm_ticks(t, to_ticks_ceil(after));
+    }
+
+    void cancel(timer& t) noexcept {
+        t.cancel();
+    }
+
+    /**
+     * Moves the time forward by a number of ticks, calling callbacks of all the
+     * expired timers in order of expiration.
+     **/
+    void advance_ticks(std::uint64_t ticks) {
+        auto const target = now_ + ticks;
+
+        while (now_ < target) {
+            auto const next = next_event();
+
+            if (next > target) {
+                now_ = target;
+                break;
+            }
+
+            now_ = next - 1;
+            tick();
+        }
+    }
+
+    /**
+     * Moves the time forward, fractions of a tick are carried to the next call.
+     **/
+    template<class Rep, class Period>
+    void advance(std::chrono::duration<Rep, Period> elapsed) {
+        carry_ += std::chrono::duration_cast<duration>(elapsed);
+        auto const ticks = carry_ / resolution_;
+        carry_ -= ticks * resolution_;
+        advance_ticks(static_cast<std::uint64_t>(ticks));
+    }
+
+    /**
+     * Current time in ticks.
+     **/
+    std::uint64_t now() const noexcept {
+        return now_;
+    }
+
+    duration resolution() const noexcept {
+        return resolution_;
+    }
+
+    /**
+     * Number of armed timers.
+     **/
+    std::size_t pending() const noexcept {
+        return pending_;
+    }
+
+private:
+    friend class timer;
+
+    template<class Rep, class Period>
+    std::uint64_t to_ticks_ceil(std::chrono::duration<Rep, Period> d) const noexcept {
+        auto const ns = std::chrono::duration_cast<duration>(d);
+        return ns.count() <= 0 ? 0 : static_cast<std::uint64_t>((ns + resolution_ - duration{1}) / resolution_);
+    }
+
+    void insert(timer& t) noexcept {
+        auto const delta = t.expires_ - now_;
+        // out of range timers wait in the farthest top level slot
+        auto const expires = delta < range ? t.expires_ : now_ + range - 1;
+        auto const distance = expires - now_;
+
+        std::size_t level = 0;
+
+        while (level + 1 < levels && distance >= (std::uint64_t{1} << (level_bits * (level + 1)))) {
+            level ++;
+        }
+
+        auto const slot = (expires >> (level_bits * level)) & (slots - 1);
+        t.link_before(wheel_[level][slot]);
+        t.level_ = static_cast<std::uint8_t>(level);
+        t.slot_ = static_cast<std::uint8_t>(slot);
+        occupied_[level] |= std::uint64_t{1} << slot;
+    }
+
+    void remove(timer& t) noexcept {
+        auto& head = wheel_[t.level_][t.slot_];
+        t.unlink();
+        t.wheel_ = nullptr;
+        pending_ --;
+
+        if (head.next_ == &head) {
+            occupied_[t.level_] &= ~(std::uint64_t{1} << t.slot_);
+        }
+    }
+
+    /**
+     * The nearest tick at which a non-empty slot is expired or cascaded.
+     **/
+    std::uint64_t next_event() const noexcept {
+        auto next = std::numeric_limits<std::uint64_t>::max();
+
+        for (std::size_t level = 0; level < levels; ++level) {
+            if (occupied_[level] == 0) {
+                continue;
+            }
+
+            auto const shift = level_bits * level;
+            auto const position = (now_ >> shift) & (slots - 1);
+            // bit 0 stands for the slot following the current one
+            auto const rotated = rotate_right(occupied_[level], (position + 1) % slots);
+            auto const distance = count_trailing_zeros(rotated) + 1;
+            auto const at = ((now_ >> shift) + distance) << shift;
+
+            next = at < next ? at : next;
+        }
+
+        return next;
+    }
+
+    static std::uint64_t rotate_right(std::uint64_t bits, std::size_t n) noexcept {
+        return n == 0 ? bits : (bits >> n) | (bits << (64 - n));
+    }
+
+    static std::size_t count_trailing_zeros(std::uint64_t bits) noexcept {
+#if defined(__GNUC__)
+        return static_cast<std::size_t>(__builtin_ctzll(bits));
+#else
+        std::size_t idx = 0;
+        for (; (bits & 1) == 0; bits >>= 1) idx ++;
+        return idx;
+#endif
+    }
+
+    void tick() {
+        now_ ++;
+
+        // cascade levels whose slot boundary has been reached, highest first
+        for (std::size_t level = levels - 1; level > 0; --level) {
+            auto const mask = (std::uint64_t{1} << (level_bits * level)) - 1;
+
+            if ((now_ & mask) == 0) {
+                cascade(level, (now_ >> (level_bits * level)) & (slots - 1));
+            }
+        }
+
+        // detach expired timers first, callbacks may arm timers in this slot
+        timer expired;
+        detach(0, now_ & (slots - 1), expired);
+
+        while (expired.next_ != &expired) {
+            auto* t = expired.next_;
+            t->unlink();
+            t->wheel_ = nullptr;
+            pending_ --;
+
+            if (t->callback_ != nullptr) {
+                t->callback_(*t);
+            }
+        }
+    }
+
+    void cascade(std::size_t level, std::uint64_t index) noexcept {
+        timer list;
+        detach(level, index, list);
+
+        while (list.next_ != &list) {
+            auto* t = list.next_;
+            t->unlink();
+            insert(*t);
+        }
+    }
+
+    void detach(std::size_t level, std::uint64_t index, timer& to) noexcept {
+        move_list(wheel_[level][index], to);
+        occupied_[level] &= ~(std::uint64_t{1} << index);
+    }
+
+    static void move_list(timer& from, timer& to) noexcept {
+        if (from.next_ == &from) {
+            return;
+        }
+
+        to.next_ = from.next_;
+        to.prev_ = from.prev_;
+        to.next_->prev_ = &to;
+        to.prev_->next_ = &to;
+        from.next_ = from.prev_ = &from;
+    }
+
+    using level_type = std::array<timer, slots>;
+
+    std::array<level_type, levels>      wheel_;
+    std::array<std::uint64_t, levels>   occupied_ {};
+    std::uint64_t                       now_ = 0;
+    std::size_t                         pending_ = 0;
+    duration                            resolution_;
+    duration                            carry_ {0};
+};
+
+void timer::cancel() noexcept {
+    if (wheel_ != nullptr) {
+        wheel_->remove(*this);
+    }
+}
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_TIMER_WHEEL_HPP
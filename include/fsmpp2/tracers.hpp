@@ -0,0 +1,381 @@
+#ifndef FSMPP2_TRACERS_HPP
+#define FSMPP2_TRACERS_HPP
+
+#include "fsmpp2/detail/tracer_calls.hpp"
+#include <atomic>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace fsmpp2
+{
+
+namespace detail
+{
+
+/**
+ * Storage of a single tracer within a composite, empty tracers are stored
+ * as a base class so they take no space.
+ **/
+template<std::size_t I, class T, bool Ebo = std::is_empty_v<T> && !std::is_final_v<T>>
+struct tracer_element : T {
+    tracer_element() = default;
+    explicit tracer_element(T&& t) : T {std::move(t)} {}
+
+    T& get() noexcept { return *this; }
+    T const& get() const noexcept { return *this; }
+};
+
+template<std::size_t I, class T>
+struct tracer_element<I, T, false> {
+    tracer_element() = default;
+    explicit tracer_element(T&& t) : value {std::move(t)} {}
+
+    T& get() noexcept { return value; }
+    T const& get() const noexcept { return value; }
+
+    T value;
+};
+
+template<class Indexes, class... T> struct tracers_base;
+
+template<std::size_t... I, class... T>
+struct tracers_base<std::index_sequence<I...>, T...> : tracer_element<I, T>... {
+    tracers_base() = default;
+    explicit tracers_base(T&&... t) : tracer_element<I, T> {std::move(t)}... {}
+
+    void begin_dispatch() {
+        (trace_dispatch(tracer_element<I, T>::get()), ...);
+    }
+
+    template<class S, class E>
+    void begin_event_handling() {
+        (trace_begin<S, E>(tracer_element<I, T>::get()), ...);
+    }
+
+    template<class S, class E>
+    void end_event_handling(bool result) {
+        (trace_end<S, E>(tracer_element<I, T>::get(), result), ...);
+    }
+
+    template<class From, class E, class To>
+    void transition() {
+        (trace_transition<From, E, To>(tracer_element<I, T>::get()), ...);
+    }
+
+    // only declared if any of the tracers is interested in state enter/exit,
+    // otherwise the state_manager does not call them at all
+    template<class S>
+    auto enter_state(S const& s) -> std::enable_if_t<(has_state_hooks<T, S>::value || ...)> {
+        (trace_enter(tracer_element<I, T>::get(), s), ...);
+    }
+
+    template<class S>
+    auto exit_state(S const& s) -> std::enable_if_t<(has_state_hooks<T, S>::value || ...)> {
+        (trace_exit(tracer_element<I, T>::get(), s), ...);
+    }
+};
+
+} // namespace detail
+
+/**
+ * Composite tracer, forwards every callback to all the tracers in order.
+ *
+ * Tracers are held by value, empty ones (eg. NullTracer) take no space and
+ * their callbacks compile to nothing.
+ *
+ *      fsmpp2::state_machine sm{States{}, Events{}, ctx,
+ *          fsmpp2::tracers{fsmpp2::dwell_time_tracer<States>{}, session.make_tracer()}};
+ *      sm.tracer().get<0>().stats<StateA>();
+ **/
+template<class... T>
+class tracers : public detail::tracers_base<std::index_sequence_for<T...>, T...> {
+    using base = detail::tracers_base<std::index_sequence_for<T...>, T...>;
+
+public:
+    tracers() = default;
+
+    explicit tracers(T... t)
+        : base {std::move(t)...}
+    {}
+
+    /**
+     * Gets I-th tracer.
+     **/
+    template<std::size_t I>
+    auto& get() noexcept {
+        return element<I>().get();
+    }
+
+    /**
+     * Gets I-th tracer.
+     **/
+    template<std::size_t I>
+    auto const& get() const noexcept {
+        return element<I>().get();
+    }
+
+private:
+    template<std::size_t I>
+    auto& element() noexcept {
+        return static_cast<detail::tracer_element<I, type_at<I>>&>(*this);
+    }
+
+    template<std::size_t I>
+    auto const& element() const noexcept {
+        return static_cast<detail::tracer_element<I, type_at<I>> const&>(*this);
+    }
+
+    template<std::size_t I>
+    using type_at = std::tuple_element_t<I, std::tuple<T...>>;
+};
+
+template<class... T> tracers(T...) -> tracers<T...>;
+
+/**
+ * Filters accepted by filtered_tracer, trace all types, only listed types or
+ * all but listed types.
+ **/
+struct trace_all {};
+template<class... T> struct trace_only {};
+template<class... T> struct trace_except {};
+
+namespace detail
+{
+
+template<class Filter, class T> struct trace_filter_passes;
+
+template<class T>
+struct trace_filter_passes<trace_all, T> : std::true_type {};
+
+template<class... L, class T>
+struct trace_filter_passes<trace_only<L...>, T> : std::bool_constant<(std::is_same_v<T, L> || ...)> {};
+
+template<class... L, class T>
+struct trace_filter_passes<trace_except<L...>, T> : std::bool_constant<!(std::is_same_v<T, L> || ...)> {};
+
+} // namespace detail
+
+/**
+ * Tracer adapter forwarding only callbacks concerning selected states and events.
+ *
+ * Filtering is done at compile time, for filtered out combinations the callbacks
+ * are empty functions. Handling callbacks are forwarded if both the state and the
+ * event pass the filters, a transition is forwarded if the event passes and
+ * either the source or the target state passes the filter, state hooks are filtered
+ * by the state only.
+ *
+ *      fsmpp2::filtered_tracer<
+ *          fsmpp2::chrome_trace::tracer<1024>,
+ *          fsmpp2::trace_only<Handshake, Closing>,
+ *          fsmpp2::trace_except<DataReceived>> tracer{session.make_tracer()};
+ **/
+template<class Tracer, class StatesFilter, class EventsFilter = trace_all>
+class filtered_tracer {
+    template<class S>
+    static constexpr bool state_passes = detail::trace_filter_passes<StatesFilter, S>::value;
+
+    template<class E>
+    static constexpr bool event_passes = detail::trace_filter_passes<EventsFilter, E>::value;
+
+public:
+    filtered_tracer() = default;
+
+    explicit filtered_tracer(Tracer tracer)
+        : tracer_ {std::move(tracer)}
+    {}
+
+    void begin_dispatch() {
+        detail::trace_dispatch(tracer_);
+    }
+
+    template<class S, class E>
+    void begin_event_handling() {
+        if constexpr (state_passes<S> && event_passes<E>) {
+            detail::trace_begin<S, E>(tracer_);
+        }
+    }
+
+    template<class S, class E>
+    void end_event_handling(bool result) {
+        if constexpr (state_passes<S> && event_passes<E>) {
+            detail::trace_end<S, E>(tracer_, result);
+        }
+    }
+
+    template<class From, class E, class To>
+    void transition() {
+        if constexpr ((state_passes<From> || state_passes<To>) && event_passes<E>) {
+            detail::trace_transition<From, E, To>(tracer_);
+        }
+    }
+
+    template<class S>
+    auto enter_state(S const& s) -> std::enable_if_t<detail::has_state_hooks<Tracer, S>::value> {
+        if constexpr (state_passes<S>) {
+            detail::trace_enter(tracer_, s);
+        }
+    }
+
+    template<class S>
+    auto exit_state(S const& s) -> std::enable_if_t<detail::has_state_hooks<Tracer, S>::value> {
+        if constexpr (state_passes<S>) {
+            detail::trace_exit(tracer_, s);
+        }
+    }
+
+    /**
+     * Gets the underlying tracer.
+     **/
+    Tracer& inner() noexcept {
+        return tracer_;
+    }
+
+    /**
+     * Gets the underlying tracer.
+     **/
+    Tracer const& inner() const noexcept {
+        return tracer_;
+    }
+
+private:
+    Tracer tracer_;
+};
+
+/**
+ * Tracer adapter which can be switched on and off at runtime.
+ *
+ * The flag is either owned by the tracer (per state machine) or shared by
+ * many tracers (global switch). It is read once per event, in begin_dispatch()
+ * called by the state_machine, and that value is used by all callbacks up to
+ * the next event, on every level of the hierarchy. Switching the flag while
+ * an event is being dispatched never results in unmatched callbacks, it takes
+ * effect with the next event. When disabled every callback costs a single branch.
+ *
+ *      std::atomic<bool> tracing {false};
+ *      fsmpp2::state_machine sm{States{}, Events{}, ctx, fsmpp2::toggled_tracer{session.make_tracer(), tracing}};
+ *      tracing = true;
+ **/
+template<class Tracer>
+class toggled_tracer {
+public:
+    toggled_tracer()
+        : flag_ {&own_}
+    {}
+
+    /**
+     * Creates a tracer with its own flag.
+     **/
+    explicit toggled_tracer(Tracer tracer, bool enabled = false)
+        : tracer_ {std::move(tracer)}
+        , own_ {enabled}
+        , flag_ {&own_}
+        , active_ {enabled}
+    {}
+
+    /**
+     * Creates a tracer controlled by an external flag.
+     **/
+    toggled_tracer(Tracer tracer, std::atomic<bool>& flag)
+        : tracer_ {std::move(tracer)}
+        , flag_ {&flag}
+        , active_ {flag.load(std::memory_order_relaxed)}
+    {}
+
+    toggled_tracer(toggled_tracer&& other)
+        : tracer_ {std::move(other.tracer_)}
+        , own_ {other.own_.load()}
+        , flag_ {other.flag_ == &other.own_ ? &own_ : other.flag_}
+        , active_ {other.active_}
+    {}
+
+    toggled_tracer(toggled_tracer const&) = delete;
+    toggled_tracer& operator=(toggled_tracer const&) = delete;
+
+    /**
+     * Enables or disables tracing, may be called from any thread.
+     **/
+    void enable(bool value = true) noexcept {
+        flag_->store(value, std::memory_order_relaxed);
+    }
+
+    void disable() noexcept {
+        enable(false);
+    }
+
+    bool enabled() const noexcept {
+        return flag_->load(std::memory_order_relaxed);
+    }
+
+    void begin_dispatch() {
+        active_ = enabled();
+
+        if (active_) {
+            detail::trace_dispatch(tracer_);
+        }
+    }
+
+    template<class S, class E>
+    void begin_event_handling() {
+        if (active_) {
+            detail::trace_begin<S, E>(tracer_);
+        }
+    }
+
+    template<class S, class E>
+    void end_event_handling(bool result) {
+        if (active_) {
+            detail::trace_end<S, E>(tracer_, result);
+        }
+    }
+
+    template<class From, class E, class To>
+    void transition() {
+        if (active_) {
+            detail::trace_transition<From, E, To>(tracer_);
+        }
+    }
+
+    template<class S>
+    auto enter_state(S const& s) -> std::enable_if_t<detail::has_state_hooks<Tracer, S>::value> {
+        if (active_) {
+            detail::trace_enter(tracer_, s);
+        }
+    }
+
+    template<class S>
+    auto exit_state(S const& s) -> std::enable_if_t<detail::has_state_hooks<Tracer, S>::value> {
+        if (active_) {
+            detail::trace_exit(tracer_, s);
+        }
+    }
+
+    /**
+     * Gets the underlying tracer.
+     **/
+    Tracer& inner() noexcept {
+        return tracer_;
+    }
+
+    /**
+     * Gets the underlying tracer.
+     **/
+    Tracer const& inner() const noexcept {
+        return tracer_;
+    }
+
+private:
+    Tracer              tracer_;
+    std::atomic<bool>   own_ {false};
+    std::atomic<bool>*  flag_;
+    // the flag as read by begin_dispatch
+    bool                active_ {false};
+};
+
+template<class T> toggled_tracer(T, bool) -> toggled_tracer<T>;
+template<class T> toggled_tracer(T, std::atomic<bool>&) -> toggled_tracer<T>;
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_TRACERS_HPP
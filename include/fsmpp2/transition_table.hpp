@@ -0,0 +1,228 @@
+#ifndef FSMPP2_TRANSITION_TABLE_HPP
+#define FSMPP2_TRANSITION_TABLE_HPP
+
+#include "fsmpp2/meta.hpp"
+#include "fsmpp2/transitions.hpp"
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace fsmpp2
+{
+
+/**
+ * Placeholder for a missing guard or action of a table row. As a target it
+ * makes an internal row, the event is handled without a transition.
+ **/
+struct none {};
+
+/**
+ * A row of a transition_table: in Source state, on Event, if Guard allows it,
+ * call Action and move to Target.
+ *
+ * Guard and Action are default constructible function objects, called as:
+ *
+ *      bool Guard::operator()(Event const&, Context const&) const;  // or (Event const&)
+ *      void Action::operator()(Event const&, Context&) const;       // or (Event const&)
+ **/
+template<class Source, class Event, class Guard, class Action, class Target>
+struct row {
+    using source = Source;
+    using event = Event;
+    using guard = Guard;
+    using action = Action;
+    using target = Target;
+};
+
+/**
+ * Unconditional transition, a row without a guard and an action.
+ **/
+template<class Source, class Event, class Target>
+using edge = row<Source, Event, none, none, Target>;
+
+namespace detail
+{
+
+template<class X, class... T>
+constexpr std::size_t index_of(meta::type_list<T...>) {
+    constexpr bool same[] = {std::is_same_v<X, T>..., false};
+    std::size_t idx = 0;
+
+    while (idx < sizeof...(T) && !same[idx]) {
+        idx ++;
+    }
+
+    return idx;
+}
+
+/**
+ * Dense index of table rows: first row of every (source, event) pair and
+ * the next row of the same pair for every row, Rows (row count) if there's none.
+ **/
+template<std::size_t Sources, std::size_t Events, std::size_t Rows>
+struct table_index {
+    std::array<std::size_t, Sources * Events + 1>   first {};
+    std::array<std::size_t, Rows + 1>               next {};
+
+    constexpr table_index(std::array<std::size_t, Rows + 1> const& sources, std::array<std::size_t, Rows + 1> const& events) {
+        for (auto& f : first) {
+            f = Rows;
+        }
+
+        // backwards, so rows of a pair are chained in the declaration order
+        for (auto r = Rows; r > 0; --r) {
+            auto const key = sources[r - 1] * Events + events[r - 1];
+            next[r - 1] = first[key];
+            first[key] = r - 1;
+        }
+
+        next[Rows] = Rows;
+    }
+};
+
+} // namespace detail
+
+/**
+ * Declarative transitions, an alternative to handle() overloads for plain
+ * "on an event go to a state" edges. A state uses rows with itself as a source
+ * when it declares:
+ *
+ *      using transition_table = Table;
+ *
+ * Rows are only used for events the state has no handle() overload for. Rows of
+ * the same source and event are tried in order, the first one with a passing
+ * guard is taken. The (source, event) lookup is a constexpr dense table.
+ **/
+template<class... Rows>
+struct transition_table {
+    using rows = meta::type_list<Rows...>;
+    using sources = typename meta::type_list_union<meta::type_list<>, meta::type_list<typename Rows::source>...>::result;
+    using events = typename meta::type_list_union<meta::type_list<>, meta::type_list<typename Rows::event>...>::result;
+
+    static constexpr std::size_t npos = sizeof...(Rows);
+
+private:
+    static constexpr auto sources_count = meta::type_list_size(sources{});
+    static constexpr auto events_count = meta::type_list_size(events{});
+
+    static constexpr detail::table_index<sources_count, events_count, sizeof...(Rows)> index_ {
+        {detail::index_of<typename Rows::source>(sources{})..., 0},
+        {detail::index_of<typename Rows::event>(events{})..., 0}
+    };
+
+public:
+    /**
+     * Index of the first row for State and E, npos if there's none.
+     **/
+    template<class State, class E>
+    static constexpr std::size_t first_row() {
+        constexpr auto s = detail::index_of<State>(sources{});
+        constexpr auto e = detail::index_of<E>(events{});
+
+        if constexpr (s == sources_count || e == events_count) {
+            return npos;
+        } else {
+            return index_.first[s * events_count + e];
+        }
+    }
+
+    /**
+     * Index of the next row with the same source and event as row R, npos if there's none.
+     **/
+    static constexpr std::size_t next_row(std::size_t r) {
+        return index_.next[r];
+    }
+
+    template<class State, class E>
+    static constexpr bool has_rows() {
+        return first_row<State, E>() != npos;
+    }
+};
+
+namespace detail
+{
+
+template<class S, class = void>
+struct has_transition_table : std::false_type {};
+
+template<class S>
+struct has_transition_table<S, std::void_t<typename S::transition_table>> : std::true_type {};
+
+template<class T> struct row_targets { using type = meta::type_list<T>; };
+template<> struct row_targets<none> { using type = meta::type_list<>; };
+
+template<class Table, std::size_t R, bool End = (R == Table::npos)>
+struct chain_targets {
+    using type = typename meta::type_list_union<
+        typename row_targets<typename meta::type_list_type<R, typename Table::rows>::type::target>::type,
+        typename chain_targets<Table, Table::next_row(R)>::type
+    >::result;
+};
+
+template<class Table, std::size_t R>
+struct chain_targets<Table, R, true> {
+    using type = meta::type_list<>;
+};
+
+/**
+ * Handler result equivalent of table rows for State and E: transitions<> to all their targets.
+ **/
+template<class State, class E>
+struct table_result {
+    using table = typename State::transition_table;
+    using type = typename meta::type_list_rename<
+        typename chain_targets<table, table::template first_row<State, E>()>::type,
+        fsmpp2::transitions
+    >::result;
+};
+
+template<class Guard, class E, class C>
+bool table_guard(E const& e, C& ctx) {
+    if constexpr (std::is_same_v<Guard, none>) {
+        return true;
+    } else if constexpr (std::is_invocable_v<Guard const&, E const&, C const&>) {
+        return Guard{}(e, std::as_const(ctx));
+    } else {
+        return Guard{}(e);
+    }
+}
+
+template<class Action, class E, class C>
+void table_action(E const& e, C& ctx) {
+    if constexpr (std::is_same_v<Action, none>) {
+        return;
+    } else if constexpr (std::is_invocable_v<Action const&, E const&, C&>) {
+        Action{}(e, ctx);
+    } else {
+        Action{}(e);
+    }
+}
+
+template<class Row, class C>
+struct row_uses_context : std::bool_constant<
+    std::is_invocable_v<typename Row::guard const&, typename Row::event const&, C const&> ||
+    std::is_invocable_v<typename Row::action const&, typename Row::event const&, C&>> {};
+
+template<class Table, std::size_t R, class C, bool End = (R == Table::npos)>
+struct chain_uses_context : std::bool_constant<
+    row_uses_context<typename meta::type_list_type<R, typename Table::rows>::type, C>::value ||
+    chain_uses_context<Table, Table::next_row(R), C>::value> {};
+
+template<class Table, std::size_t R, class C>
+struct chain_uses_context<Table, R, C, true> : std::false_type {};
+
+/**
+ * Checks if a guard or an action of any table row for State and E takes the context.
+ **/
+template<class State, class E, class C>
+struct table_uses_context : chain_uses_context<
+    typename State::transition_table,
+    State::transition_table::template first_row<State, E>(),
+    C> {};
+
+} // namespace detail
+
+} // namespace fsmpp2
+
+#endif // FSMPP2_TRANSITION_TABLE_HPP
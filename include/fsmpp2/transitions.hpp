@@ -17,11 +17,8 @@ namespace fsmpp2
 template<class... S>
 class transitions {
 private:
-    enum class result {
-        not_handled,
-        handled,
-        transition
-    };
+    // shared by all specializations so transitions<> can be converted to transitions<S...>
+    using result = detail::handle_outcome;
 
 public:
     /**
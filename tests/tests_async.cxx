@@ -0,0 +1,278 @@
+#include "catch.hpp"
+#include "fsmpp2/config.hpp"
+
+#ifdef FSMPP2_USE_CPP20
+
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/task.hpp"
+#include <coroutine>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+
+// completion of a pending operation is driven by the test
+struct Io {
+    struct awaiter {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) noexcept { io.waiting = h; }
+        int await_resume() const noexcept { return io.value; }
+
+        Io& io;
+    };
+
+    awaiter read() { return awaiter {*this}; }
+
+    void complete(int v) {
+        value = v;
+        std::exchange(waiting, {}).resume();
+    }
+
+    std::coroutine_handle<> waiting;
+    int value = 0;
+};
+
+struct Context {
+    Io io;
+    int pings = 0;
+    int early_pings = 0;
+    bool immediate = false;
+    bool nested = false;
+    bool fail = false;
+};
+
+struct Connect : fsmpp2::event {};
+struct Ping : fsmpp2::event {};
+
+struct Connected : fsmpp2::state<> {
+    auto handle(Ping const&, Context& ctx) {
+        ctx.pings ++;
+        return handled();
+    }
+};
+
+struct Failed : fsmpp2::state<> {};
+
+fsmpp2::task<int> read_twice(Io& io) {
+    auto a = co_await io.read();
+    auto b = co_await io.read();
+    co_return a + b;
+}
+
+fsmpp2::task<int> ready(int value) {
+    co_return value;
+}
+
+struct Idle : fsmpp2::state<> {
+    fsmpp2::task<fsmpp2::transitions<Connected, Failed>> handle(Connect const&, Context& ctx) {
+        if (ctx.fail) {
+            throw std::runtime_error {"connect"};
+        }
+
+        int status = 0;
+
+        if (ctx.immediate) {
+            status = co_await ready(0);
+        } else if (ctx.nested) {
+            status = co_await read_twice(ctx.io);
+        } else {
+            status = co_await ctx.io.read();
+        }
+
+        if (status == 0) {
+            co_return transition<Connected>();
+        }
+
+        co_return transition<Failed>();
+    }
+
+    auto handle(Ping const&, Context& ctx) {
+        ctx.early_pings ++;
+        return handled();
+    }
+};
+
+using States = fsmpp2::states<Idle, Connected, Failed>;
+using Events = fsmpp2::events<Connect, Ping>;
+
+struct Go : fsmpp2::event {};
+
+struct Read : fsmpp2::state<> {};
+
+struct Reading : fsmpp2::state<> {
+    fsmpp2::task<fsmpp2::transitions<Read>> handle(Go const&, Context& ctx) {
+        co_await ctx.io.read();
+        co_return transition<Read>();
+    }
+};
+
+struct Written : fsmpp2::state<> {};
+
+struct Writing : fsmpp2::state<> {
+    auto handle(Go const&) {
+        return transition<Written>();
+    }
+};
+
+struct Transfer : fsmpp2::parallel_state<
+    fsmpp2::states<Reading, Read>,
+    fsmpp2::states<Writing, Written>>
+{};
+
+using TransferStates = fsmpp2::states<Transfer>;
+using TransferEvents = fsmpp2::events<Go, Ping>;
+
+}
+
+TEST_CASE("Coroutine handler applies the transition when it completes", "[async]")
+{
+    Context ctx;
+    fsmpp2::state_machine sm {States{}, Events{}, ctx};
+
+    CHECK_FALSE(sm.busy());
+    CHECK(sm.dispatch(Connect{}));
+    CHECK(sm.busy());
+    CHECK(sm.is_in<Idle>());
+
+    // queued until the handler completes
+    CHECK(sm.dispatch(Ping{}));
+    CHECK(sm.dispatch(Ping{}));
+    CHECK(sm.queued_events() == 2);
+    CHECK(ctx.early_pings == 0);
+
+    ctx.io.complete(0);
+    CHECK_FALSE(sm.busy());
+    CHECK(sm.is_in<Connected>());
+    CHECK(sm.queued_events() == 0);
+    CHECK(ctx.pings == 2);
+}
+
+TEST_CASE("Coroutine handler completing synchronously", "[async]")
+{
+    Context ctx;
+    ctx.immediate = true;
+    fsmpp2::state_machine sm {States{}, Events{}, ctx};
+
+    CHECK(sm.dispatch(Connect{}));
+    CHECK_FALSE(sm.busy());
+    CHECK(sm.is_in<Connected>());
+}
+
+TEST_CASE("Coroutine handler awaiting another task", "[async]")
+{
+    Context ctx;
+    ctx.nested = true;
+    fsmpp2::state_machine sm {States{}, Events{}, ctx};
+
+    sm.dispatch(Connect{});
+    ctx.io.complete(1);
+    CHECK(sm.busy());
+
+    sm.dispatch(Ping{});
+    ctx.io.complete(2);
+    CHECK(sm.is_in<Failed>());
+    CHECK_FALSE(sm.busy());
+    CHECK(ctx.pings == 0);
+}
+
+TEST_CASE("Coroutine frames are allocated from a fixed arena", "[async]")
+{
+    using Tracer = fsmpp2::detail::NullTracer;
+
+    Context ctx;
+    ctx.nested = true;
+
+    // no room for the frame
+    fsmpp2::state_machine<States, Events, Context&, Tracer, fsmpp2::async_options<16, 2>> tiny {ctx};
+    CHECK_THROWS_AS(tiny.dispatch(Connect{}), std::bad_alloc);
+    CHECK_FALSE(tiny.busy());
+
+    // the handler fits, the task it awaits does not
+    fsmpp2::state_machine<States, Events, Context&, Tracer, fsmpp2::async_options<512, 1>> single {ctx};
+    CHECK_THROWS_AS(single.dispatch(Connect{}), std::bad_alloc);
+    CHECK_FALSE(single.busy());
+    CHECK(single.is_in<Idle>());
+
+    ctx.nested = false;
+    CHECK(single.dispatch(Connect{}));
+    ctx.io.complete(0);
+    CHECK(single.is_in<Connected>());
+}
+
+TEST_CASE("Busy policies", "[async]")
+{
+    using Tracer = fsmpp2::detail::NullTracer;
+
+    Context ctx;
+
+    SECTION("reject") {
+        fsmpp2::state_machine<States, Events, Context&, Tracer, fsmpp2::async_options<512, 2, fsmpp2::busy_reject>> sm {ctx};
+
+        sm.dispatch(Connect{});
+        CHECK_FALSE(sm.dispatch(Ping{}));
+        ctx.io.complete(0);
+        CHECK(sm.is_in<Connected>());
+        CHECK(ctx.pings == 0);
+    }
+
+    SECTION("bounded queue") {
+        fsmpp2::state_machine<States, Events, Context&, Tracer, fsmpp2::async_options<512, 2, fsmpp2::busy_queue<2>>> sm {ctx};
+
+        sm.dispatch(Connect{});
+        CHECK(sm.dispatch(Ping{}));
+        CHECK(sm.dispatch(Ping{}));
+        CHECK_FALSE(sm.dispatch(Ping{}));
+        ctx.io.complete(0);
+        CHECK(ctx.pings == 2);
+    }
+}
+
+TEST_CASE("Coroutine handler in an orthogonal region", "[async]")
+{
+    Context ctx;
+    fsmpp2::state_machine sm {TransferStates{}, TransferEvents{}, ctx};
+
+    // the other region gets the event while the coroutine is suspended
+    CHECK(sm.dispatch(Go{}));
+    CHECK(sm.busy());
+    CHECK(sm.is_in<Transfer, Reading>());
+    CHECK(sm.is_in<Transfer, Written>());
+
+    CHECK(sm.dispatch(Ping{}));
+    CHECK(sm.queued_events() == 1);
+
+    ctx.io.complete(0);
+    CHECK_FALSE(sm.busy());
+    CHECK(sm.is_in<Transfer, Read>());
+    CHECK(sm.is_in<Transfer, Written>());
+    CHECK(sm.queued_events() == 0);
+}
+
+TEST_CASE("Coroutine handler exceptions", "[async]")
+{
+    Context ctx;
+    ctx.fail = true;
+    fsmpp2::state_machine sm {States{}, Events{}, ctx};
+
+    CHECK_THROWS_AS(sm.dispatch(Connect{}), std::runtime_error);
+    CHECK_FALSE(sm.busy());
+    CHECK(sm.is_in<Idle>());
+}
+
+TEST_CASE("State machine destroyed with a suspended handler", "[async]")
+{
+    Context ctx;
+
+    {
+        fsmpp2::state_machine sm {States{}, Events{}, ctx};
+        sm.dispatch(Connect{});
+        CHECK(sm.busy());
+    }
+
+    // the frame is gone, it must not be resumed
+    CHECK(ctx.io.waiting);
+}
+
+#endif // FSMPP2_USE_CPP20
@@ -0,0 +1,199 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/broadcast.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+struct Context {
+    int ticks = 0;
+};
+
+struct Tick : fsmpp2::event {};
+struct Reload : fsmpp2::event {};
+struct Unknown : fsmpp2::event {};
+
+struct Idle;
+struct Working;
+
+struct Sub : fsmpp2::state<> {
+    auto handle(Tick const&, Context& ctx) const {
+        ctx.ticks ++;
+        return handled();
+    }
+};
+
+struct Idle : fsmpp2::state<> {
+    auto handle(Reload const&) const { return transition<Working>(); }
+};
+
+struct Working : fsmpp2::state<Sub> {
+    auto handle(Reload const&) const { return not_handled(); }
+};
+
+using States = fsmpp2::states<Idle, Working>;
+using Events = fsmpp2::events<Tick, Reload, Unknown>;
+using Machine = fsmpp2::state_machine<States, Events, Context>;
+
+struct Data : fsmpp2::event {};
+struct Done : fsmpp2::event {};
+
+struct Ready;
+
+struct Handshake : fsmpp2::state<> {
+    using deferred_events = fsmpp2::events<Data>;
+    auto handle(Done const&) const { return transition<Ready>(); }
+};
+
+struct Ready : fsmpp2::state<> {
+    auto handle(Data const&, Context& ctx) const {
+        ctx.ticks ++;
+        return handled();
+    }
+};
+
+using DeferringMachine = fsmpp2::state_machine<fsmpp2::states<Handshake, Ready>, fsmpp2::events<Data, Done>, Context>;
+
+}
+
+TEST_CASE("Compile time table of states which may handle an event", "[broadcast]")
+{
+    // ids: Idle 0, Working 1, Sub 2, no state 3
+    constexpr auto tick = fsmpp2::detail::path_handles<States, Tick, Context>();
+    STATIC_REQUIRE(!tick[0]);
+    STATIC_REQUIRE(!tick[1]);
+    STATIC_REQUIRE(tick[2]);
+    STATIC_REQUIRE(!tick[3]);
+
+    // handled by the parent of Sub
+    constexpr auto reload = fsmpp2::detail::path_handles<States, Reload, Context>();
+    STATIC_REQUIRE(reload[0]);
+    STATIC_REQUIRE(reload[2]);
+}
+
+TEST_CASE("Broadcast an event to many machines", "[broadcast]")
+{
+    fsmpp2::thread_pool pool{3};
+    std::vector<Machine> machines(10000);
+
+    // every third machine starts working
+    for (std::size_t i = 0; i < machines.size(); i += 3) {
+        machines[i].dispatch(Reload{});
+    }
+
+    auto const working = (machines.size() + 2) / 3;
+
+    auto ticks = fsmpp2::broadcast(pool, machines, Tick{});
+    CHECK(ticks.handled == working);
+    CHECK(ticks.skipped == machines.size() - working);
+    CHECK(ticks.not_handled == 0);
+    CHECK(ticks.transitioned == 0);
+
+    auto reload = fsmpp2::broadcast(pool, machines.begin(), machines.end(), Reload{}, 100);
+    CHECK(reload.handled == machines.size() - working);
+    CHECK(reload.not_handled == working);
+    CHECK(reload.transitioned == machines.size() - working);
+
+    auto unknown = fsmpp2::broadcast(pool, machines, Unknown{});
+    CHECK(unknown.skipped == machines.size());
+
+    auto total = 0;
+    auto all_working = true;
+    for (auto& m : machines) {
+        all_working = all_working && m.is_in<Working, Sub>();
+        total += m.context().ticks;
+    }
+    CHECK(all_working);
+    CHECK(total == static_cast<int>(working));
+}
+
+TEST_CASE("Broadcast an event deferred by active states", "[broadcast]")
+{
+    fsmpp2::thread_pool pool{3};
+    std::vector<DeferringMachine> machines(4);
+
+    // deferring counts as handling, the event must reach the machines
+    auto data = fsmpp2::broadcast(pool, machines, Data{});
+    CHECK(data.handled == machines.size());
+    CHECK(data.skipped == 0);
+
+    auto all_deferred = true;
+    for (auto& m : machines) {
+        all_deferred = all_deferred && m.deferred_events() == 1;
+    }
+    CHECK(all_deferred);
+
+    auto done = fsmpp2::broadcast(pool, machines, Done{});
+    CHECK(done.transitioned == machines.size());
+
+    auto total = 0;
+    for (auto& m : machines) {
+        total += m.context().ticks;
+    }
+    CHECK(total == static_cast<int>(machines.size()));
+}
+
+TEST_CASE("Thread pool covers the whole range", "[broadcast][thread_pool]")
+{
+    fsmpp2::thread_pool pool{2};
+    CHECK(pool.size() == 3);
+
+    std::vector<std::atomic<int>> visits(1001);
+    std::atomic<std::size_t> bad_index {0};
+
+    for (int round = 0; round < 10; ++round) {
+        pool.parallel_for(visits.size(), 7, [&](std::size_t thread, std::size_t begin, std::size_t end) {
+            if (thread >= pool.size()) {
+                bad_index ++;
+            }
+            for (auto i = begin; i < end; ++i) {
+                visits[i] ++;
+            }
+        });
+    }
+
+    auto all_ten = true;
+    for (auto& v : visits) {
+        all_ten = all_ten && v == 10;
+    }
+    CHECK(all_ten);
+    CHECK(bad_index == 0);
+
+    fsmpp2::thread_pool single{0};
+    auto calls = 0;
+    single.parallel_for(10, 3, [&](std::size_t, std::size_t, std::size_t) { calls ++; });
+    CHECK(calls == 4);
+}
+
+TEST_CASE("Thread pool rethrows an exception once the loop is done", "[broadcast][thread_pool]")
+{
+    fsmpp2::thread_pool pool{3};
+    std::atomic<int> running {0};
+
+    for (std::size_t failing : {std::size_t{0}, std::size_t{500}, std::size_t{999}}) {
+        auto const loop = [&] {
+            pool.parallel_for(1000, 1, [&](std::size_t, std::size_t begin, std::size_t) {
+                running ++;
+
+                if (begin == failing) {
+                    running --;
+                    throw std::runtime_error{"chunk failed"};
+                }
+
+                running --;
+            });
+        };
+
+        CHECK_THROWS_AS(loop(), std::runtime_error);
+        // no thread is still calling the (already destroyed) function
+        CHECK(running == 0);
+    }
+
+    // the pool is usable after a failed loop
+    std::atomic<int> calls {0};
+    pool.parallel_for(100, 10, [&](std::size_t, std::size_t, std::size_t) { calls ++; });
+    CHECK(calls == 10);
+}
@@ -0,0 +1,144 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/chrome_trace.hpp"
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+struct Ev1 : fsmpp2::event {};
+struct Ev2 : fsmpp2::event {};
+
+struct Idle;
+struct Active;
+
+struct Inner : fsmpp2::state<> {
+    auto handle(Ev2 const&) const { return handled(); }
+};
+
+struct Active : fsmpp2::state<Inner> {
+    auto handle(Ev1 const&) const { return transition<Idle>(); }
+};
+
+struct Idle : fsmpp2::state<> {
+    auto handle(Ev1 const&) const { return transition<Active>(); }
+};
+
+using States = fsmpp2::states<Idle, Active>;
+using Events = fsmpp2::events<Ev1, Ev2>;
+
+struct Left2 : fsmpp2::state<> {};
+
+struct Left1 : fsmpp2::state<> {
+    auto handle(Ev1 const&) const { return transition<Left2>(); }
+};
+
+struct Right : fsmpp2::state<> {};
+
+struct Split : fsmpp2::parallel_state<
+    fsmpp2::states<Left1, Left2>,
+    fsmpp2::states<Right>>
+{};
+
+std::size_t count(std::string const& str, std::string const& what)
+{
+    std::size_t result = 0;
+
+    for (auto pos = str.find(what); pos != std::string::npos; pos = str.find(what, pos + 1)) {
+        result ++;
+    }
+
+    return result;
+}
+
+// start time of the first residency slice of a state
+double slice_start(std::string const& json, std::string const& state)
+{
+    auto const slice = json.find("\"name\":\"(anonymous namespace)::" + state + "\",\"cat\":\"state\"");
+    auto const ts = json.find("\"ts\":", slice);
+
+    return std::stod(json.substr(ts + 5));
+}
+
+}
+
+TEST_CASE("Chrome trace session writes one track per machine", "[chrome_trace]")
+{
+    std::ostringstream oss;
+
+    {
+        fsmpp2::chrome_trace::session session{oss};
+        int ctx = 0;
+
+        fsmpp2::state_machine sm1{States{}, Events{}, ctx, session.make_tracer("first")};
+        fsmpp2::state_machine sm2{States{}, Events{}, ctx, session.make_tracer()};
+
+        sm1.dispatch(Ev1{});    // Idle -> Active/Inner
+        sm1.dispatch(Ev2{});    // handled by Inner
+        sm2.dispatch(Ev2{});    // not handled, no slice
+    }
+
+    auto const json = oss.str();
+
+    CHECK(json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") == 0);
+    CHECK(json.find("]}\n") == json.size() - 3);
+    CHECK(count(json, "\"ph\":\"M\"") == 2);
+    CHECK(count(json, "\"args\":{\"name\":\"first\"}") == 1);
+    CHECK(count(json, "\"args\":{\"name\":\"machine 2\"}") == 1);
+
+    // sm1: Idle, Active and Inner residencies, sm2: Idle only
+    CHECK(count(json, "\"cat\":\"state\"") == 4);
+    CHECK(count(json, "\"name\":\"(anonymous namespace)::Inner\",\"cat\":\"state\",\"ph\":\"X\",\"pid\":1,\"tid\":1") == 1);
+
+    // two handled events in sm1
+    CHECK(count(json, "\"cat\":\"handler\"") == 2);
+    CHECK(count(json, "\"name\":\"(anonymous namespace)::Ev2\",\"cat\":\"handler\",\"args\":{\"state\":\"(anonymous namespace)::Inner\"}") == 1);
+}
+
+TEST_CASE("Chrome trace tracer drops slices when the ring is full", "[chrome_trace]")
+{
+    std::ostringstream oss;
+    fsmpp2::chrome_trace::basic_session<4> session{oss, std::chrono::hours{1}};
+    int ctx = 0;
+
+    fsmpp2::state_machine sm{States{}, Events{}, ctx, session.make_tracer()};
+
+    sm.dispatch(Ev1{});             // handler and Idle slices
+
+    for (int i = 0; i < 4; ++i) {
+        sm.dispatch(Ev2{});         // handler slice
+    }
+
+    sm.dispatch(Ev1{});             // handler, Inner and Active slices
+
+    // everything above does not fit into the ring, the overflow is dropped unless
+    // the session thread managed to drain the ring in the meantime
+    session.stop();
+    CHECK(session.dropped() + count(oss.str(), "\"ph\":\"X\"") == 9);
+}
+
+TEST_CASE("Chrome trace of orthogonal regions", "[chrome_trace]")
+{
+    std::ostringstream oss;
+
+    {
+        fsmpp2::chrome_trace::session session{oss};
+        int ctx = 0;
+
+        fsmpp2::state_machine sm{fsmpp2::states<Split>{}, fsmpp2::events<Ev1>{}, ctx, session.make_tracer()};
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{2});
+
+        // Left1 is left while Right, entered after it, stays active
+        sm.dispatch(Ev1{});
+    }
+
+    auto const json = oss.str();
+
+    CHECK(count(json, "\"cat\":\"state\"") == 4);
+    CHECK(slice_start(json, "Split") <= slice_start(json, "Left1"));
+    CHECK(slice_start(json, "Left1") <= slice_start(json, "Right"));
+    CHECK(slice_start(json, "Right") + 1000.0 < slice_start(json, "Left2"));
+}
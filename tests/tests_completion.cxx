@@ -0,0 +1,193 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include <set>
+#include <vector>
+
+namespace
+{
+
+struct Context {
+    bool fast = false;
+    bool valid = true;
+    int checks = 0;
+    int bounces = 0;
+    std::set<void const*> frames;
+};
+
+struct Start : fsmpp2::event {};
+struct Reset : fsmpp2::event {};
+struct Bounce : fsmpp2::event {};
+
+struct Fast;
+struct Slow;
+struct Checking;
+struct Rejected;
+struct Idle;
+struct Ping;
+struct Pong;
+
+struct Deciding : fsmpp2::state<> {
+    auto completion(Context& ctx) -> fsmpp2::transitions<Checking, Slow> {
+        if (ctx.fast) {
+            return transition<Checking>();
+        }
+
+        return transition<Slow>();
+    }
+};
+
+struct Checking : fsmpp2::state<> {
+    auto completion(Context& ctx) -> fsmpp2::transitions<Fast, Rejected> {
+        ctx.checks ++;
+
+        if (ctx.valid) {
+            return transition<Fast>();
+        }
+
+        return transition<Rejected>();
+    }
+};
+
+struct Fast : fsmpp2::state<> {
+    auto handle(Reset const&) const { return transition<Idle>(); }
+};
+
+struct Slow : fsmpp2::state<> {
+    auto handle(Reset const&) const { return transition<Idle>(); }
+};
+
+// completion not requesting a transition
+struct Rejected : fsmpp2::state<> {
+    auto completion() const { return handled(); }
+    auto handle(Reset const&) const { return transition<Idle>(); }
+};
+
+struct Idle : fsmpp2::state<> {
+    auto handle(Start const&) const { return transition<Deciding>(); }
+    auto handle(Bounce const&) const { return transition<Ping>(); }
+};
+
+struct Ping : fsmpp2::state<> {
+    auto completion(Context& ctx) -> fsmpp2::transitions<Pong> {
+        char frame = 0;
+        ctx.frames.insert(&frame);
+        ctx.bounces ++;
+        return transition<Pong>();
+    }
+
+    auto handle(Reset const&) const { return transition<Idle>(); }
+};
+
+struct Pong : fsmpp2::state<> {
+    auto completion(Context& ctx) -> fsmpp2::transitions<Ping> {
+        char frame = 0;
+        ctx.frames.insert(&frame);
+        ctx.bounces ++;
+        return transition<Ping>();
+    }
+
+    auto handle(Reset const&) const { return transition<Idle>(); }
+};
+
+using States = fsmpp2::states<Idle, Deciding, Checking, Fast, Slow, Rejected, Ping, Pong>;
+using Events = fsmpp2::events<Start, Reset, Bounce>;
+
+struct TransitionLog {
+    template<class State, class E>
+    void begin_event_handling() {}
+
+    void end_event_handling(bool) {}
+
+    template<class State>
+    void transition() {}
+
+    template<class From, class E, class To>
+    void transition() {
+        completions.push_back(std::is_same_v<E, fsmpp2::completion_event>);
+    }
+
+    std::vector<bool> completions;
+};
+
+}
+
+TEST_CASE("Completion transitions are followed within a dispatch", "[completion]")
+{
+    Context ctx;
+    ctx.fast = true;
+
+    TransitionLog tracer;
+    fsmpp2::state_machine sm {States{}, Events{}, ctx, tracer};
+
+    CHECK(sm.dispatch(Start{}));
+    CHECK(sm.is_in<Fast>());
+    CHECK(ctx.checks == 1);
+
+    // Start -> Deciding, completion -> Checking, completion -> Fast
+    CHECK(tracer.completions == std::vector<bool>{false, true, true});
+
+    sm.dispatch(Reset{});
+    ctx.fast = false;
+    sm.dispatch(Start{});
+    CHECK(sm.is_in<Slow>());
+
+    // a completion check may leave the machine in the state
+    sm.dispatch(Reset{});
+    ctx.fast = true;
+    ctx.valid = false;
+    sm.dispatch(Start{});
+    CHECK(sm.is_in<Rejected>());
+}
+
+TEST_CASE("Completion transitions are bounded", "[completion]")
+{
+    Context ctx;
+    fsmpp2::state_machine sm {States{}, Events{}, ctx};
+
+    sm.dispatch(Bounce{});
+    CHECK(ctx.bounces == FSMPP2_COMPLETION_DEPTH);
+
+    // the chain is followed in a loop, not recursively, completions of a state always run in the same stack frame
+    CHECK(ctx.frames.size() <= 2);
+
+    // an even number of completions ends in Ping
+    STATIC_REQUIRE(FSMPP2_COMPLETION_DEPTH % 2 == 0);
+    CHECK(sm.is_in<Ping>());
+
+    // the bound applies to every chain separately
+    sm.dispatch(Reset{});
+    sm.dispatch(Bounce{});
+    CHECK(ctx.bounces == 2 * FSMPP2_COMPLETION_DEPTH);
+}
+
+namespace
+{
+
+struct Configured;
+
+struct Unconfigured : fsmpp2::state<> {
+    auto completion(Context& ctx) -> fsmpp2::transitions<Configured> {
+        if (ctx.valid) {
+            return transition<Configured>();
+        }
+
+        return handled();
+    }
+};
+
+struct Configured : fsmpp2::state<> {};
+
+struct Device : fsmpp2::state<Unconfigured, Configured> {};
+
+}
+
+TEST_CASE("Completion of initial states", "[completion]")
+{
+    Context ctx;
+    fsmpp2::state_machine sm {fsmpp2::states<Device>{}, fsmpp2::events<Reset>{}, ctx};
+    CHECK(sm.is_in<Device, Configured>());
+
+    ctx.valid = false;
+    fsmpp2::state_machine other {fsmpp2::states<Device>{}, fsmpp2::events<Reset>{}, ctx};
+    CHECK(other.is_in<Device, Unconfigured>());
+}
@@ -0,0 +1,222 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/context_access.hpp"
+#include <thread>
+
+namespace
+{
+
+struct CtxA { int value = 0; };
+struct CtxB { int value = 0; };
+struct CtxC { int value = 0; };
+
+struct Ev1 : fsmpp2::event {};
+struct Ev2 : fsmpp2::event {};
+struct Ev3 : fsmpp2::event {};
+
+struct S2;
+
+struct S1 : fsmpp2::state<> {
+    S1(fsmpp2::access_context<CtxA> ctx)
+        : ctx_ {ctx}
+    {}
+
+    auto handle(Ev1 const&) { return transition<S2>(); }
+
+    auto handle(Ev2 const&, fsmpp2::access_context<CtxB> ctx) {
+        ctx.get_context().value ++;
+        return handled();
+    }
+
+    fsmpp2::access_context<CtxA> ctx_;
+};
+
+struct S2a : fsmpp2::state<> {
+    S2a(CtxC&) {}
+};
+
+struct S2 : fsmpp2::state<S2a> {
+    auto handle(Ev3 const&, fsmpp2::contexts<CtxA, CtxB, CtxC>&) { return handled(); }
+};
+
+using States = fsmpp2::states<S1, S2>;
+using Events = fsmpp2::events<Ev1, Ev2, Ev3>;
+using Machine = fsmpp2::state_machine<States, Events, fsmpp2::contexts<CtxA, CtxB, CtxC>>;
+
+struct Ready;
+
+struct Handshake : fsmpp2::state<> {
+    using deferred_events = fsmpp2::events<Ev2>;
+
+    Handshake(fsmpp2::access_context<CtxA>) {}
+
+    auto handle(Ev1 const&) { return transition<Ready>(); }
+};
+
+struct Ready : fsmpp2::state<> {
+    auto handle(Ev2 const&, fsmpp2::access_context<CtxB> ctx) {
+        ctx.get_context().value ++;
+        return handled();
+    }
+};
+
+using DeferringMachine = fsmpp2::state_machine<fsmpp2::states<Handshake, Ready>, Events, fsmpp2::contexts<CtxA, CtxB, CtxC>>;
+
+struct Decide;
+struct Far;
+
+struct Near : fsmpp2::state<> {
+    auto handle(Ev1 const&) { return transition<Decide>(); }
+};
+
+struct Decide : fsmpp2::state<> {
+    auto completion(fsmpp2::access_context<CtxB> ctx) -> fsmpp2::transitions<Near, Far> {
+        if (ctx.get_context().value > 0) {
+            return transition<Far>();
+        }
+
+        return transition<Near>();
+    }
+};
+
+struct Far : fsmpp2::state<> {
+    Far(fsmpp2::access_context<CtxC>) {}
+};
+
+using CompletingMachine = fsmpp2::state_machine<fsmpp2::states<Near, Decide, Far>, Events, fsmpp2::contexts<CtxA, CtxB, CtxC>>;
+
+struct Pong;
+
+// completion transitions going round in a loop
+struct Ping : fsmpp2::state<> {
+    Ping(fsmpp2::access_context<CtxA>) {}
+    auto completion() -> fsmpp2::transitions<Pong> { return transition<Pong>(); }
+};
+
+struct Pong : fsmpp2::state<> {
+    auto completion(fsmpp2::access_context<CtxB>) -> fsmpp2::transitions<Ping> { return transition<Ping>(); }
+};
+
+struct Serve : fsmpp2::state<> {
+    auto handle(Ev1 const&) { return transition<Ping>(); }
+};
+
+using LoopingMachine = fsmpp2::state_machine<fsmpp2::states<Serve, Ping, Pong>, Events, fsmpp2::contexts<CtxA, CtxB, CtxC>>;
+
+template<class... T>
+using list = fsmpp2::meta::type_list<T...>;
+
+}
+
+TEST_CASE("Context access sets of state and event pairs", "[context][context_access]")
+{
+    // kept by the state, the transition leaves S1 and enters S2 with its initial substate S2a
+    STATIC_REQUIRE(std::is_same_v<Machine::context_access<S1, Ev1>, list<CtxA, CtxC>>);
+    // kept by the state and passed to the handler
+    STATIC_REQUIRE(std::is_same_v<Machine::context_access<S1, Ev2>, list<CtxA, CtxB>>);
+    // not handled
+    STATIC_REQUIRE(std::is_same_v<Machine::context_access<S1, Ev3>, list<>>);
+    // whole bundle passed to the handler
+    STATIC_REQUIRE(std::is_same_v<Machine::context_access<S2, Ev3>, list<CtxA, CtxB, CtxC>>);
+    STATIC_REQUIRE(std::is_same_v<Machine::context_access<S2a, Ev1>, list<>>);
+
+    STATIC_REQUIRE(std::is_same_v<Machine::event_context_access<Ev1>, list<CtxA, CtxC>>);
+    STATIC_REQUIRE(std::is_same_v<Machine::event_context_access<Ev2>, list<CtxA, CtxB>>);
+
+    STATIC_REQUIRE(fsmpp2::access_disjoint_v<list<CtxA>, list<CtxB, CtxC>>);
+    STATIC_REQUIRE(!fsmpp2::access_disjoint_v<Machine::context_access<S1, Ev1>, Machine::context_access<S1, Ev2>>);
+    STATIC_REQUIRE(fsmpp2::access_disjoint_v<list<>, list<CtxA>>);
+}
+
+TEST_CASE("Context access set with a single context", "[context][context_access]")
+{
+    struct Ctx {};
+
+    struct Plain : fsmpp2::state<> {
+        auto handle(Ev1 const&) { return handled(); }
+    };
+
+    struct Keeping : fsmpp2::state<> {
+        Keeping(Ctx&) {}
+        auto handle(Ev1 const&) { return handled(); }
+        auto handle(Ev2 const&) { return transition<Plain>(); }
+    };
+
+    using M = fsmpp2::state_machine<fsmpp2::states<Plain, Keeping>, Events, Ctx&>;
+
+    STATIC_REQUIRE(std::is_same_v<M::context_access<Plain, Ev1>, list<>>);
+    STATIC_REQUIRE(std::is_same_v<M::context_access<Keeping, Ev1>, list<Ctx>>);
+    STATIC_REQUIRE(std::is_same_v<M::context_access<Keeping, Ev2>, list<Ctx>>);
+    STATIC_REQUIRE(std::is_same_v<M::event_context_access<Ev3>, list<>>);
+}
+
+TEST_CASE("Context access set covers replayed deferred events", "[context][context_access]")
+{
+    // Ready handles Ev2 deferred by Handshake within the dispatch of Ev1
+    STATIC_REQUIRE(std::is_same_v<DeferringMachine::context_access<Handshake, Ev1>, list<CtxA>>);
+    STATIC_REQUIRE(std::is_same_v<DeferringMachine::event_context_access<Ev1>, list<CtxA, CtxB>>);
+    // deferring does not access any context, no transition so nothing is replayed
+    STATIC_REQUIRE(std::is_same_v<DeferringMachine::event_context_access<Ev2>, list<CtxB>>);
+
+    CtxA a;
+    CtxB b;
+    CtxC c;
+    fsmpp2::context_locks<CtxA, CtxB, CtxC> locks;
+    DeferringMachine sm{fsmpp2::contexts{a, b, c}};
+
+    locks.dispatch(sm, Ev2{});
+    CHECK(sm.deferred_events() == 1);
+    locks.dispatch(sm, Ev1{});
+    CHECK(b.value == 1);
+}
+
+TEST_CASE("Context access set covers completion transitions", "[context][context_access]")
+{
+    // Decide checks CtxB on completion and may enter Far keeping CtxC
+    STATIC_REQUIRE(std::is_same_v<CompletingMachine::event_context_access<Ev1>, list<CtxB, CtxC>>);
+    STATIC_REQUIRE(std::is_same_v<LoopingMachine::event_context_access<Ev1>, list<CtxA, CtxB>>);
+
+    CtxA a;
+    CtxB b;
+    CtxC c;
+    fsmpp2::context_locks<CtxA, CtxB, CtxC> locks;
+    CompletingMachine sm{fsmpp2::contexts{a, b, c}};
+
+    locks.dispatch(sm, Ev1{});
+    CHECK(sm.is_in<Near>());
+
+    b.value = 1;
+    locks.dispatch(sm, Ev1{});
+    CHECK(sm.is_in<Far>());
+}
+
+TEST_CASE("Dispatch with per context locks", "[context][context_access]")
+{
+    CtxA a;
+    CtxB b;
+    CtxC c;
+    fsmpp2::context_locks<CtxA, CtxB, CtxC> locks;
+
+    Machine sm1{fsmpp2::contexts{a, b, c}};
+    Machine sm2{fsmpp2::contexts{a, b, c}};
+
+    // CtxC is not used by Ev2 so it can be held meanwhile
+    auto guard = locks.lock<list<CtxC>>();
+
+    std::thread t1{[&] {
+        for (int i = 0; i < 1000; ++i) {
+            locks.dispatch(sm1, Ev2{});
+        }
+    }};
+
+    std::thread t2{[&] {
+        for (int i = 0; i < 1000; ++i) {
+            locks.dispatch(sm2, Ev2{});
+        }
+    }};
+
+    t1.join();
+    t2.join();
+
+    CHECK(b.value == 2000);
+}
@@ -0,0 +1,180 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+struct Context {
+    bool abort = false;
+};
+
+struct PowerOn : fsmpp2::event {};
+struct Resume : fsmpp2::event {};
+struct Start : fsmpp2::event {};
+struct Fault : fsmpp2::event {};
+struct Restart : fsmpp2::event {};
+struct Reload : fsmpp2::event {};
+
+struct Off;
+struct Idle;
+struct Running;
+struct On;
+
+struct Loading : fsmpp2::state<> {
+    static constexpr auto name = "loading";
+
+    // two levels up
+    auto completion(Context& ctx) -> fsmpp2::transitions<Off> {
+        if (ctx.abort) {
+            return transition<Off>();
+        }
+
+        return handled();
+    }
+
+    auto handle(Start const&) const { return transition<Running>(); }
+};
+
+struct Running : fsmpp2::state<> {
+    static constexpr auto name = "running";
+
+    auto handle(Fault const&) const { return transition<Off>(); }
+    auto handle(Restart const&) const { return transition<On>(); }
+};
+
+struct Working : fsmpp2::state<Loading, Running> {
+    static constexpr auto name = "working";
+
+    // own descendant, Working is left as well
+    auto handle(Reload const&) const { return transition<Loading>(); }
+};
+
+struct Idle : fsmpp2::state<> {
+    static constexpr auto name = "idle";
+
+    // into a substate of a sibling
+    auto handle(Start const&) const { return transition<Running>(); }
+};
+
+struct On : fsmpp2::state<Idle, Working> {
+    static constexpr auto name = "on";
+};
+
+struct Off : fsmpp2::state<> {
+    static constexpr auto name = "off";
+
+    auto handle(PowerOn const&) const { return transition<On>(); }
+
+    // down two levels
+    auto handle(Resume const&) const { return transition<Running>(); }
+};
+
+using States = fsmpp2::states<Off, On>;
+using Events = fsmpp2::events<PowerOn, Resume, Start, Fault, Restart, Reload>;
+
+struct HooksTracer : fsmpp2::detail::NullTracer {
+    template<class State>
+    void enter_state(State const&) {
+        log.push_back(std::string{"enter "} + State::name);
+    }
+
+    template<class State>
+    void exit_state(State const&) {
+        log.push_back(std::string{"exit "} + State::name);
+    }
+
+    std::vector<std::string> take() {
+        return std::exchange(log, {});
+    }
+
+    std::vector<std::string> log;
+};
+
+using Strings = std::vector<std::string>;
+
+}
+
+TEST_CASE("Transition routes are computed at compile time", "[cross_level]")
+{
+    using fsmpp2::detail::transition_route;
+    using fsmpp2::meta::type_list;
+
+    using up = transition_route<Running, Off, States>;
+    STATIC_REQUIRE(std::is_same_v<up::source, On>);
+    STATIC_REQUIRE(std::is_same_v<up::path, type_list<Off>>);
+    STATIC_REQUIRE(std::is_same_v<up::level, States>);
+
+    using down = transition_route<Off, Running, States>;
+    STATIC_REQUIRE(std::is_same_v<down::source, Off>);
+    STATIC_REQUIRE(std::is_same_v<down::path, type_list<On, Working, Running>>);
+
+    using sibling = transition_route<Idle, Running, States>;
+    STATIC_REQUIRE(std::is_same_v<sibling::source, Idle>);
+    STATIC_REQUIRE(std::is_same_v<sibling::path, type_list<Working, Running>>);
+    STATIC_REQUIRE(std::is_same_v<sibling::level, fsmpp2::states<Idle, Working>>);
+
+    STATIC_REQUIRE(std::is_void_v<transition_route<Idle, int, States>::level>);
+}
+
+TEST_CASE("Transitions between levels of the hierarchy", "[cross_level]")
+{
+    Context ctx;
+    HooksTracer tracer;
+    fsmpp2::state_machine sm {States{}, Events{}, ctx, tracer};
+    tracer.take();
+
+    CHECK(sm.dispatch(Resume{}));
+    CHECK(sm.is_in<On, Working, Running>());
+    CHECK(tracer.take() == Strings{"exit off", "enter on", "enter working", "enter running"});
+
+    CHECK(sm.dispatch(Fault{}));
+    CHECK(sm.is_in<Off>());
+    CHECK(tracer.take() == Strings{"exit running", "exit working", "exit on", "enter off"});
+
+    sm.dispatch(PowerOn{});
+    CHECK(sm.is_in<On, Idle>());
+    tracer.take();
+
+    CHECK(sm.dispatch(Start{}));
+    CHECK(sm.is_in<On, Working, Running>());
+    CHECK(tracer.take() == Strings{"exit idle", "enter working", "enter running"});
+
+    // an ancestor is left and entered again, in its initial substate
+    CHECK(sm.dispatch(Restart{}));
+    CHECK(sm.is_in<On, Idle>());
+    CHECK(tracer.take() == Strings{"exit running", "exit working", "exit on", "enter on", "enter idle"});
+}
+
+TEST_CASE("Transition to a descendant leaves the source state", "[cross_level]")
+{
+    Context ctx;
+    HooksTracer tracer;
+    fsmpp2::state_machine sm {States{}, Events{}, ctx, tracer};
+
+    sm.dispatch(Resume{});
+    tracer.take();
+
+    CHECK(sm.dispatch(Reload{}));
+    CHECK(sm.is_in<On, Working, Loading>());
+    CHECK(tracer.take() == Strings{"exit running", "exit working", "enter working", "enter loading"});
+}
+
+TEST_CASE("Completion transition to an upper level", "[cross_level][completion]")
+{
+    Context ctx;
+    HooksTracer tracer;
+    fsmpp2::state_machine sm {States{}, Events{}, ctx, tracer};
+
+    sm.dispatch(Resume{});
+    tracer.take();
+
+    ctx.abort = true;
+    CHECK(sm.dispatch(Reload{}));
+    CHECK(sm.is_in<Off>());
+    CHECK(tracer.take() == Strings{
+        "exit running", "exit working", "enter working", "enter loading",
+        "exit loading", "exit working", "exit on", "enter off"});
+}
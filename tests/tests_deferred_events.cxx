@@ -0,0 +1,115 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include <vector>
+
+namespace
+{
+
+struct Context {
+    std::vector<int> received;
+    int keys = 0;
+};
+
+struct Data : fsmpp2::event {
+    int seq = 0;
+};
+
+struct HandshakeDone : fsmpp2::event {};
+struct KeyExchanged : fsmpp2::event {};
+struct Ready : fsmpp2::event {};
+struct Close : fsmpp2::event {};
+
+Data data(int seq) {
+    Data e;
+    e.seq = seq;
+    return e;
+}
+
+struct Open;
+struct Connecting;
+struct Authenticating;
+
+struct Open : fsmpp2::state<> {
+    auto handle(Data const& e, Context& ctx) {
+        ctx.received.push_back(e.seq);
+        return handled();
+    }
+
+    auto handle(Close const&) const { return transition<Connecting>(); }
+};
+
+struct Handshaking : fsmpp2::state<> {
+    using deferred_events = fsmpp2::events<Data>;
+    static constexpr std::size_t deferred_capacity = 4;
+
+    auto handle(HandshakeDone const&) const { return transition<Authenticating>(); }
+};
+
+struct Authenticating : fsmpp2::state<> {
+    using deferred_events = fsmpp2::events<Data, Close>;
+
+    auto handle(KeyExchanged const&, Context& ctx) const {
+        ctx.keys ++;
+        return handled();
+    }
+};
+
+struct Connecting : fsmpp2::state<Handshaking, Authenticating> {
+    auto handle(Ready const&) const { return transition<Open>(); }
+};
+
+using States = fsmpp2::states<Connecting, Open>;
+using Events = fsmpp2::events<Data, HandshakeDone, KeyExchanged, Ready, Close>;
+using Machine = fsmpp2::state_machine<States, Events, Context>;
+
+}
+
+TEST_CASE("Deferred events are replayed after the deferring state is left", "[deferred_events]")
+{
+    STATIC_REQUIRE(fsmpp2::detail::deferred_capacity<States>::value == 16);
+    STATIC_REQUIRE(!Machine::is_read_only<Data>());
+
+    Machine sm;
+    auto& ctx = sm.context();
+
+    CHECK(sm.dispatch(data(1)));
+    CHECK(sm.dispatch(data(2)));
+    CHECK(sm.deferred_events() == 2);
+    CHECK(ctx.received.empty());
+
+    // Authenticating defers them again, the order is kept
+    sm.dispatch(HandshakeDone{});
+    CHECK(sm.is_in<Connecting, Authenticating>());
+    CHECK(sm.dispatch(data(3)));
+    CHECK(sm.dispatch(Close{}));
+    CHECK(sm.deferred_events() == 4);
+
+    // a handled event without a transition does not replay anything
+    sm.dispatch(KeyExchanged{});
+    CHECK(ctx.keys == 1);
+    CHECK(sm.deferred_events() == 4);
+
+    sm.dispatch(Ready{});
+    CHECK(ctx.received == std::vector<int>{1, 2, 3});
+
+    // Close was replayed in Open as well
+    CHECK(sm.is_in<Connecting, Handshaking>());
+    CHECK(sm.deferred_events() == 0);
+}
+
+TEST_CASE("Deferred events buffer is bounded", "[deferred_events]")
+{
+    Machine sm;
+
+    for (int i = 0; i < 16; ++i) {
+        CHECK(sm.dispatch(data(i)));
+    }
+
+    CHECK_FALSE(sm.dispatch(data(16)));
+    CHECK(sm.deferred_events() == 16);
+
+    sm.dispatch(HandshakeDone{});
+    sm.dispatch(Ready{});
+    CHECK(sm.context().received.size() == 16);
+    CHECK(sm.context().received.back() == 15);
+}
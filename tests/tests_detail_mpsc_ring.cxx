@@ -0,0 +1,70 @@
+#include "catch.hpp"
+#include "fsmpp2/detail/mpsc_ring.hpp"
+#include <thread>
+#include <vector>
+
+TEST_CASE("MPSC ring is bounded and FIFO", "[mpsc_ring]")
+{
+    fsmpp2::detail::mpsc_ring<int, 4> ring;
+    int value = 0;
+
+    CHECK(ring.try_pop(value) == false);
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK(ring.try_push(i));
+    }
+
+    CHECK(ring.try_push(4) == false);
+
+    CHECK(ring.try_pop(value));
+    CHECK(value == 0);
+    CHECK(ring.try_push(4));
+
+    for (int i = 1; i < 5; ++i) {
+        CHECK(ring.try_pop(value));
+        CHECK(value == i);
+    }
+
+    CHECK(ring.try_pop(value) == false);
+}
+
+TEST_CASE("MPSC ring passes elements from many threads", "[mpsc_ring]")
+{
+    fsmpp2::detail::mpsc_ring<int, 256> ring;
+    constexpr int producers = 4;
+    constexpr int count = 10000;
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&ring, p] {
+            for (int i = 0; i < count; ++i) {
+                while (!ring.try_push(p * count + i))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // elements of a single producer are popped in order
+    std::vector<int> last(producers, -1);
+    bool ordered = true;
+    long long sum = 0;
+
+    for (int received = 0; received < producers * count; ) {
+        int value;
+
+        if (ring.try_pop(value)) {
+            auto const p = value / count;
+            ordered = ordered && value % count == last[p] + 1;
+            last[p] = value % count;
+            sum += value;
+            received ++;
+        }
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    CHECK(ordered);
+    CHECK(sum == (long long)producers * count * (producers * count - 1) / 2);
+}
@@ -0,0 +1,84 @@
+#include "catch.hpp"
+#include "fsmpp2/detail/spsc_ring.hpp"
+#include <thread>
+
+TEST_CASE("SPSC ring is bounded and FIFO", "[spsc_ring]")
+{
+    fsmpp2::detail::spsc_ring<int, 4> ring;
+    int value = 0;
+
+    CHECK(ring.try_pop(value) == false);
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK(ring.try_push(i));
+    }
+
+    CHECK(ring.try_push(4) == false);
+    CHECK(ring.size() == 4);
+
+    CHECK(ring.try_pop(value));
+    CHECK(value == 0);
+    CHECK(ring.try_push(4));
+
+    for (int i = 1; i < 5; ++i) {
+        CHECK(ring.try_pop(value));
+        CHECK(value == i);
+    }
+
+    CHECK(ring.try_pop(value) == false);
+}
+
+TEST_CASE("SPSC ring passes elements between threads", "[spsc_ring]")
+{
+    fsmpp2::detail::spsc_ring<int, 64> ring;
+    constexpr int count = 100000;
+
+    std::thread producer{[&ring] {
+        for (int i = 0; i < count; ++i) {
+            while (!ring.try_push(i))
+                std::this_thread::yield();
+        }
+    }};
+
+    long long sum = 0;
+    int expected = 0;
+    bool ordered = true;
+
+    while (expected < count) {
+        int value;
+
+        if (ring.try_pop(value)) {
+            ordered = ordered && value == expected;
+            sum += value;
+            expected ++;
+        }
+    }
+
+    producer.join();
+
+    CHECK(ordered);
+    CHECK(sum == (long long)count * (count - 1) / 2);
+}
+
+TEST_CASE("SPSC ring pushes and pops in batches", "[spsc_ring]")
+{
+    fsmpp2::detail::spsc_ring<int, 8> ring;
+    int in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    int out[10] = {};
+
+    CHECK(ring.try_push(in, 5) == 5);
+    CHECK(ring.try_push(in + 5, 5) == 3);
+    CHECK(ring.try_push(in, 1) == 0);
+
+    CHECK(ring.try_pop(out, 3) == 3);
+    CHECK(ring.try_pop(out + 3, 10) == 5);
+    CHECK(ring.try_pop(out, 1) == 0);
+
+    CHECK(out[0] == 0);
+    CHECK(out[7] == 7);
+
+    // wraps around
+    CHECK(ring.try_push(in, 6) == 6);
+    CHECK(ring.try_pop(out, 10) == 6);
+    CHECK(out[5] == 5);
+}
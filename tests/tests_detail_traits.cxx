@@ -1,6 +1,8 @@
 #include "catch.hpp"
 #include "fsmpp2/detail/traits.hpp"
 #include "fsmpp2/contexts.hpp"
+#include "fsmpp2/detail/read_only.hpp"
+#include "fsmpp2/states.hpp"
 
 TEST_CASE("Can handle event trait", "[traits][can_handle_event]")
 {
@@ -55,4 +57,43 @@ TEST_CASE("Detecting handler accepting access_context parameter", "[traits][can_
     CHECK(fsmpp2::detail::can_handle_event_with_context<Handler, Ev2, Ctx2>::value == true);
     CHECK(fsmpp2::detail::can_handle_event_with_context<Handler, Ev3, fsmpp2::contexts<Ctx1, Ctx2>>::value == true);
     CHECK(fsmpp2::detail::can_handle_event_with_context<Handler, Ev4, fsmpp2::contexts<Ctx1, Ctx2>>::value == true);
-}
\ No newline at end of file
+}
+TEST_CASE("Read-only handler trait", "[traits][read_only]")
+{
+    struct Ev1 {};
+    struct Ev2 {};
+    struct Ev3 {};
+    struct Ev4 {};
+    struct Ev5 {};
+    struct Ev6 {};
+    struct Ctx {};
+
+    struct Other : fsmpp2::state<> {};
+
+    struct Handler : fsmpp2::state<> {
+        auto handle(Ev1) const { return handled(); }
+        auto handle(Ev2) { return handled(); }
+        auto handle(Ev3) const { return transition<Other>(); }
+        auto handle(Ev4, Ctx const&) const { return handled(); }
+        auto handle(Ev5, Ctx&) const { return handled(); }
+    };
+
+    using fsmpp2::detail::is_read_only_handler;
+
+    CHECK(is_read_only_handler<Handler, Ev1, Ctx>::value == true);
+    CHECK(is_read_only_handler<Handler, Ev2, Ctx>::value == false);
+    CHECK(is_read_only_handler<Handler, Ev3, Ctx>::value == false);
+    CHECK(is_read_only_handler<Handler, Ev4, Ctx>::value == true);
+    CHECK(is_read_only_handler<Handler, Ev5, Ctx>::value == false);
+    CHECK(is_read_only_handler<Handler, Ev6, Ctx>::value == true);
+
+    struct Parent : fsmpp2::state<Handler> {
+        auto handle(Ev1) { return handled(); }
+    };
+
+    using fsmpp2::detail::is_read_only_event;
+
+    CHECK(is_read_only_event<fsmpp2::states<Parent, Other>, Ev1, Ctx>::value == false);
+    CHECK(is_read_only_event<fsmpp2::states<Parent, Other>, Ev4, Ctx>::value == true);
+    CHECK(is_read_only_event<fsmpp2::states<Parent, Other>, Ev5, Ctx>::value == false);
+}
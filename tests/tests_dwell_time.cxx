@@ -0,0 +1,206 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/dwell_time.hpp"
+#include "fsmpp2/config.hpp"
+
+#ifdef FSMPP2_USE_CPP20
+#include "fsmpp2/task.hpp"
+#include <coroutine>
+#include <utility>
+#endif
+
+namespace
+{
+
+struct FakeClock {
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<FakeClock>;
+
+    static time_point now() {
+        reads ++;
+        return current;
+    }
+
+    static inline time_point current {};
+    static inline int reads = 0;
+};
+
+struct Ev1 : fsmpp2::event {};
+struct Ev2 : fsmpp2::event {};
+
+struct Inner1;
+struct Inner2;
+struct Idle;
+struct Active;
+
+struct Inner1 : fsmpp2::state<> {
+    auto handle(Ev2 const&) const { return transition<Inner2>(); }
+};
+
+struct Inner2 : fsmpp2::state<> {};
+
+struct Active : fsmpp2::state<Inner1, Inner2> {
+    auto handle(Ev1 const&) const { return transition<Idle>(); }
+};
+
+struct Idle : fsmpp2::state<> {
+    auto handle(Ev1 const&) const { return transition<Active>(); }
+};
+
+using States = fsmpp2::states<Idle, Active>;
+using Events = fsmpp2::events<Ev1, Ev2>;
+
+}
+
+TEST_CASE("Dwell time is accounted for every state at every level", "[dwell_time]")
+{
+    using namespace std::chrono_literals;
+    using tracer_type = fsmpp2::dwell_time_tracer<States, FakeClock>;
+
+    FakeClock::current = FakeClock::time_point{};
+    int ctx = 0;
+    fsmpp2::state_machine sm{States{}, Events{}, ctx, tracer_type{}};
+    auto const& tr = sm.tracer();
+
+    FakeClock::current += 10ns;
+    sm.dispatch(Ev1{});             // Idle -> Active/Inner1
+
+    CHECK(tr.stats<Idle>().visits == 1);
+    CHECK(tr.stats<Idle>().total == 10ns);
+    CHECK(tr.stats<Active>().visits == 0);
+
+    FakeClock::current += 100ns;
+    sm.dispatch(Ev2{});             // Inner1 -> Inner2
+
+    CHECK(tr.stats<Inner1>().visits == 1);
+    CHECK(tr.stats<Inner1>().total == 100ns);
+    CHECK(tr.stats<Active>().visits == 0);
+
+    FakeClock::current += 1000ns;
+    sm.dispatch(Ev1{});             // Active/Inner2 -> Idle
+
+    CHECK(tr.stats<Inner2>().visits == 1);
+    CHECK(tr.stats<Inner2>().total == 1000ns);
+    CHECK(tr.stats<Active>().visits == 1);
+    CHECK(tr.stats<Active>().total == 1100ns);
+    CHECK(tr.stats<Active>().min == 1100ns);
+    CHECK(tr.stats<Active>().max == 1100ns);
+
+    // 1100 is within [1024, 2048)
+    CHECK(tr.stats<Active>().histogram[10] == 1);
+}
+
+TEST_CASE("Dwell time tracer reads the clock once per transition", "[dwell_time]")
+{
+    using tracer_type = fsmpp2::dwell_time_tracer<States, FakeClock>;
+
+    int ctx = 0;
+    fsmpp2::state_machine sm{States{}, Events{}, ctx, tracer_type{}};
+
+    FakeClock::reads = 0;
+    sm.dispatch(Ev1{});             // leaves Idle, enters Active and Inner1
+    CHECK(FakeClock::reads == 1);
+
+    sm.dispatch(Ev1{});             // leaves Inner1 and Active, enters Idle
+    CHECK(FakeClock::reads == 2);
+}
+
+TEST_CASE("Dwell time histogram buckets", "[dwell_time]")
+{
+    using stats = fsmpp2::dwell_time_stats<std::chrono::nanoseconds>;
+
+    CHECK(stats::bucket(std::chrono::nanoseconds{0}) == 0);
+    CHECK(stats::bucket(std::chrono::nanoseconds{1}) == 0);
+    CHECK(stats::bucket(std::chrono::nanoseconds{2}) == 1);
+    CHECK(stats::bucket(std::chrono::nanoseconds{3}) == 1);
+    CHECK(stats::bucket(std::chrono::nanoseconds{1024}) == 10);
+}
+
+namespace
+{
+
+struct Settled;
+
+struct Starting : fsmpp2::state<> {
+    auto completion() const { return transition<Settled>(); }
+};
+
+struct Settled : fsmpp2::state<> {};
+
+}
+
+TEST_CASE("Dwell time of states entered by completion of the initial state", "[dwell_time]")
+{
+    using namespace std::chrono_literals;
+    using CompletionStates = fsmpp2::states<Starting, Settled>;
+    using tracer_type = fsmpp2::dwell_time_tracer<CompletionStates, FakeClock>;
+
+    FakeClock::current = FakeClock::time_point{};
+    tracer_type tracer;
+    int ctx = 0;
+
+    {
+        fsmpp2::state_machine sm{CompletionStates{}, fsmpp2::events<Ev1>{}, ctx, tracer};
+        CHECK(sm.is_in<Settled>());
+
+        FakeClock::current += 1000ns;
+    }
+
+    // the transition made on construction does not leave a stale timestamp behind
+    CHECK(tracer.stats<Settled>().total == 1000ns);
+}
+
+#ifdef FSMPP2_USE_CPP20
+
+namespace
+{
+
+struct Resume {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) noexcept { *waiting = h; }
+    void await_resume() const noexcept {}
+
+    std::coroutine_handle<>* waiting;
+};
+
+struct Done;
+
+struct Waiting : fsmpp2::state<> {
+    fsmpp2::task<fsmpp2::transitions<Done>> handle(Ev1 const&, std::coroutine_handle<>& waiting) {
+        co_await Resume{&waiting};
+        co_return transition<Done>();
+    }
+};
+
+struct Done : fsmpp2::state<> {};
+
+}
+
+TEST_CASE("Dwell time of states entered by a resumed coroutine handler", "[dwell_time][async]")
+{
+    using namespace std::chrono_literals;
+    using AsyncStates = fsmpp2::states<Waiting, Done>;
+    using tracer_type = fsmpp2::dwell_time_tracer<AsyncStates, FakeClock>;
+
+    FakeClock::current = FakeClock::time_point{};
+    tracer_type tracer;
+    std::coroutine_handle<> waiting;
+
+    {
+        fsmpp2::state_machine sm{AsyncStates{}, fsmpp2::events<Ev1>{}, waiting, tracer};
+        sm.dispatch(Ev1{});
+
+        FakeClock::current += 100ns;
+        std::exchange(waiting, {}).resume();
+        CHECK(sm.is_in<Done>());
+
+        FakeClock::current += 1000ns;
+    }
+
+    CHECK(tracer.stats<Waiting>().total == 100ns);
+    CHECK(tracer.stats<Done>().total == 1000ns);
+}
+
+#endif
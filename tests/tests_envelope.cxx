@@ -0,0 +1,137 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/envelope.hpp"
+#include "fsmpp2/mailbox.hpp"
+#include <array>
+#include <new>
+#include <vector>
+
+namespace
+{
+
+struct Small : fsmpp2::event {
+    int value = 0;
+};
+
+struct Large : fsmpp2::event {
+    std::array<int, 64> payload {};
+};
+
+struct Empty : fsmpp2::event {};
+
+struct Context {
+    int small = 0;
+    int large = 0;
+};
+
+struct Receiving : fsmpp2::state<> {
+    auto handle(Small const& e, Context& ctx) const {
+        ctx.small += e.value;
+        return handled();
+    }
+
+    auto handle(Large const& e, Context& ctx) const {
+        ctx.large += e.payload[63];
+        return handled();
+    }
+};
+
+using Events = fsmpp2::events<Small, Large, Empty>;
+using Machine = fsmpp2::state_machine<fsmpp2::states<Receiving>, Events, Context>;
+
+Large large(int value) {
+    Large e;
+    e.payload[63] = value;
+    return e;
+}
+
+}
+
+TEST_CASE("Envelope keeps events inline", "[envelope]")
+{
+    using Envelope = fsmpp2::envelope<Events>;
+
+    STATIC_REQUIRE(sizeof(Envelope) <= sizeof(Large) + alignof(Large) + sizeof(std::uint32_t));
+    STATIC_REQUIRE(Envelope::is_inline<Large>());
+    STATIC_REQUIRE(Envelope::id_of<Small>() == 1);
+    STATIC_REQUIRE(Envelope::id_of<Empty>() == 3);
+
+    Machine sm;
+
+    Envelope empty;
+    CHECK(empty.empty());
+    CHECK_FALSE(empty.dispatch(sm));
+
+    Envelope small {Small{{}, 5}};
+    CHECK(small.holds<Small>());
+    CHECK(small.get<Small>().value == 5);
+    CHECK(small.dispatch(sm));
+
+    Envelope copy {small};
+    CHECK(copy.dispatch(sm));
+    CHECK(sm.context().small == 10);
+
+    Envelope moved {std::move(copy)};
+    CHECK(copy.empty());
+    CHECK(moved.holds<Small>());
+
+    moved = Envelope {large(7)};
+    CHECK(moved.dispatch(sm));
+    CHECK(sm.context().large == 7);
+
+    CHECK_FALSE(Envelope{Empty{}}.dispatch(sm));
+}
+
+TEST_CASE("Envelope places oversized events in an arena", "[envelope]")
+{
+    using Envelope = fsmpp2::envelope<Events, 16>;
+
+    STATIC_REQUIRE(Envelope::is_inline<Small>());
+    STATIC_REQUIRE(!Envelope::is_inline<Large>());
+    STATIC_REQUIRE(sizeof(Envelope) <= 24);
+
+    fsmpp2::envelope_arena arena {sizeof(Large), 2};
+    CHECK(arena.available() == 2);
+
+    Machine sm;
+
+    {
+        Envelope a {large(1), &arena};
+        Envelope small {Small{{}, 1}, &arena};
+        CHECK(arena.available() == 1);
+
+        Envelope b {a};
+        CHECK(arena.available() == 0);
+        CHECK_THROWS_AS(Envelope(large(2), &arena), std::bad_alloc);
+
+        // moving transfers the block
+        Envelope c {std::move(a)};
+        CHECK(arena.available() == 0);
+        CHECK(c.dispatch(sm));
+        CHECK(b.dispatch(sm));
+        CHECK(sm.context().large == 2);
+
+        c.reset();
+        CHECK(arena.available() == 1);
+    }
+
+    CHECK(arena.available() == 2);
+    CHECK_THROWS_AS(Envelope(large(2), nullptr), std::bad_alloc);
+}
+
+TEST_CASE("Mailbox with small envelopes and an arena", "[envelope][mailbox]")
+{
+    Machine sm;
+    fsmpp2::envelope_arena arena {sizeof(Large), 4};
+    fsmpp2::mailbox<Machine, 16> mbox {sm, &arena};
+
+    mbox.post(Small{{}, 1});
+    mbox.post(large(2));
+    mbox.post(large(3));
+    CHECK(arena.available() == 2);
+
+    CHECK(mbox.process() == 3);
+    CHECK(arena.available() == 4);
+    CHECK(sm.context().small == 1);
+    CHECK(sm.context().large == 5);
+}
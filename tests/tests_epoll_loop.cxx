@@ -0,0 +1,140 @@
+#include "catch.hpp"
+
+#if defined(__linux__)
+
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/epoll_loop.hpp"
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+struct Context {
+    fsmpp2::epoll_loop* loop = nullptr;
+    std::string received;
+    int readable = 0;
+    int writable = 0;
+    int closed = 0;
+    std::uint64_t ticks = 0;
+};
+
+struct SocketReadable : fsmpp2::fd_event {};
+struct SocketWritable : fsmpp2::fd_event {};
+struct SocketClosed : fsmpp2::fd_event {};
+struct Tick : fsmpp2::fd_event {};
+
+struct Finished;
+
+struct Connected : fsmpp2::state<> {
+    auto handle(SocketReadable const& e, Context& ctx) const {
+        ctx.readable ++;
+        char buffer[4];
+
+        // edge-triggered, read everything
+        while (true) {
+            auto const n = ::read(e.fd, buffer, sizeof(buffer));
+
+            if (n <= 0) {
+                break;
+            }
+
+            ctx.received.append(buffer, static_cast<std::size_t>(n));
+        }
+
+        return handled();
+    }
+
+    auto handle(SocketWritable const&, Context& ctx) const {
+        ctx.writable ++;
+        return handled();
+    }
+
+    auto handle(SocketClosed const& e, Context& ctx) const {
+        ctx.closed ++;
+        ctx.loop->remove(e.fd);
+        return transition<Finished>();
+    }
+
+    auto handle(Tick const& e, Context& ctx) const {
+        std::uint64_t value = 0;
+
+        if (::read(e.fd, &value, sizeof(value)) == sizeof(value)) {
+            ctx.ticks += value;
+        }
+
+        return handled();
+    }
+};
+
+struct Finished : fsmpp2::state<> {};
+
+using States = fsmpp2::states<Connected, Finished>;
+using Events = fsmpp2::events<SocketReadable, SocketWritable, SocketClosed, Tick>;
+
+}
+
+TEST_CASE("Readiness of file descriptors is dispatched as events", "[epoll_loop]")
+{
+    fsmpp2::epoll_loop loop;
+    REQUIRE(loop.valid());
+
+    int fds[2];
+    REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    auto const tick_fd = ::eventfd(0, EFD_NONBLOCK);
+
+    Context ctx;
+    ctx.loop = &loop;
+    fsmpp2::state_machine sm {States{}, Events{}, ctx};
+
+    CHECK(loop.add(fds[0], sm, fsmpp2::fd_events<SocketReadable, SocketWritable, SocketClosed>{}));
+    CHECK(loop.add(tick_fd, sm, fsmpp2::fd_events<Tick>{}));
+    CHECK_FALSE(loop.add(tick_fd, sm, fsmpp2::fd_events<Tick>{}));
+    CHECK(loop.size() == 2);
+
+    // writable right away
+    CHECK(loop.run_once(0) == 1);
+    CHECK(ctx.writable == 1);
+
+    // edge-triggered: not reported again until something changes
+    CHECK(loop.run_once(0) == 0);
+
+    CHECK(::write(fds[1], "hello world", 11) == 11);
+    std::uint64_t two = 2;
+    CHECK(::write(tick_fd, &two, sizeof(two)) == sizeof(two));
+
+    // one wait for both descriptors
+    CHECK(loop.run_once(1000) == 2);
+    CHECK(ctx.received == "hello world");
+    CHECK(ctx.ticks == 2);
+
+    ::close(fds[1]);
+    loop.run_once(1000);
+    CHECK(ctx.closed == 1);
+    CHECK(sm.is_in<Finished>());
+    CHECK(loop.size() == 1);
+
+    CHECK(loop.remove(tick_fd));
+    CHECK_FALSE(loop.remove(tick_fd));
+
+    ::close(fds[0]);
+    ::close(tick_fd);
+}
+
+TEST_CASE("Event loop is stopped from another thread", "[epoll_loop]")
+{
+    fsmpp2::epoll_loop loop;
+    REQUIRE(loop.valid());
+
+    std::thread stopper {[&loop] { loop.stop(); }};
+    loop.run();
+    stopper.join();
+
+    SUCCEED();
+}
+
+#endif
@@ -0,0 +1,85 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/event_bus.hpp"
+
+namespace
+{
+
+struct Context {
+    int power_lost = 0;
+};
+
+struct PowerLost : fsmpp2::event {};
+struct Open : fsmpp2::event {};
+struct Toggle : fsmpp2::event {};
+struct Noise : fsmpp2::event {};
+
+struct DoorOpen;
+
+struct DoorClosed : fsmpp2::state<> {
+    auto handle(Open const&) const { return transition<DoorOpen>(); }
+    auto handle(PowerLost const&, Context& ctx) const { ctx.power_lost ++; return handled(); }
+};
+
+struct DoorOpen : fsmpp2::state<> {
+    auto handle(PowerLost const&, Context& ctx) const { ctx.power_lost ++; return not_handled(); }
+};
+
+struct Armed : fsmpp2::state<> {
+    auto handle(PowerLost const&, Context& ctx) const { ctx.power_lost ++; return handled(); }
+};
+
+struct LightOff : fsmpp2::state<> {
+    auto handle(Toggle const&) const { return handled(); }
+};
+
+using Door = fsmpp2::state_machine<fsmpp2::states<DoorClosed, DoorOpen>, fsmpp2::events<PowerLost, Open>, Context>;
+using Alarm = fsmpp2::state_machine<fsmpp2::states<Armed>, fsmpp2::events<PowerLost, Noise>, Context>;
+// PowerLost is declared but not handled by any state
+using Light = fsmpp2::state_machine<fsmpp2::states<LightOff>, fsmpp2::events<PowerLost, Toggle>, Context>;
+
+using Bus = fsmpp2::event_bus<Door, Alarm, Light>;
+
+}
+
+TEST_CASE("Event bus routing is computed at compile time", "[event_bus]")
+{
+    using fsmpp2::meta::type_list;
+
+    STATIC_REQUIRE(std::is_same_v<Bus::receivers<PowerLost>, type_list<Door, Alarm>>);
+    STATIC_REQUIRE(std::is_same_v<Bus::receivers<Open>, type_list<Door>>);
+    STATIC_REQUIRE(std::is_same_v<Bus::receivers<Toggle>, type_list<Light>>);
+    // declared by Alarm, but not handled
+    STATIC_REQUIRE(std::is_same_v<Bus::receivers<Noise>, type_list<>>);
+    STATIC_REQUIRE(!Bus::routes<Noise>());
+}
+
+TEST_CASE("Publish an event to subscribed machines", "[event_bus]")
+{
+    Door front, back;
+    Alarm alarm;
+    Light light;
+
+    Bus bus;
+    bus.subscribe(front);
+    bus.subscribe(back);
+    bus.subscribe(alarm);
+    bus.subscribe(light);
+
+    CHECK(bus.count<Door>() == 2);
+
+    CHECK(bus.publish(Open{}) == 2);
+    CHECK(bus.publish(PowerLost{}) == 1); // not handled by the open doors
+    CHECK(front.context().power_lost == 1);
+    CHECK(back.context().power_lost == 1);
+    CHECK(alarm.context().power_lost == 1);
+    CHECK(bus.publish(Toggle{}) == 1);
+    CHECK(bus.publish(Noise{}) == 0);
+
+    bus.unsubscribe(back);
+    CHECK(bus.count<Door>() == 1);
+
+    bus.publish(PowerLost{});
+    CHECK(front.context().power_lost == 2);
+    CHECK(back.context().power_lost == 1);
+}
@@ -0,0 +1,190 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/flight_recorder.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+struct Ev1 : fsmpp2::event {};
+struct Ev2 : fsmpp2::event {};
+
+struct Idle;
+
+struct Inner : fsmpp2::state<> {
+    auto handle(Ev2 const&) const { return handled(); }
+};
+
+struct Active : fsmpp2::state<Inner> {
+    auto handle(Ev1 const&) const { return transition<Idle>(); }
+};
+
+struct Idle : fsmpp2::state<> {
+    auto handle(Ev1 const&) const { return transition<Active>(); }
+};
+
+using States = fsmpp2::states<Idle, Active>;
+using Events = fsmpp2::events<Ev1, Ev2>;
+
+template<class Recorder>
+std::string dump_and_decode(Recorder const& rec)
+{
+    auto file = std::tmpfile();
+    rec.dump(fileno(file));
+
+    std::string raw;
+    std::rewind(file);
+    for (int c; (c = std::fgetc(file)) != EOF; ) {
+        raw.push_back(static_cast<char>(c));
+    }
+    std::fclose(file);
+
+    std::istringstream is{raw};
+    std::ostringstream os;
+    REQUIRE(fsmpp2::flight::decode(is, os));
+    return os.str();
+}
+
+}
+
+TEST_CASE("Flight recorder records machine history", "[flight_recorder]")
+{
+    int ctx = 0;
+    fsmpp2::state_machine sm{States{}, Events{}, ctx, fsmpp2::flight_recorder<States, Events>{}};
+
+    sm.dispatch(Ev1{});
+    sm.dispatch(Ev2{});
+
+    CHECK(dump_and_decode(sm.tracer()) ==
+        "recorder 0: last 9 of 9 records\n"
+        "#0 L0 enter (anonymous namespace)::Idle\n"
+        "#1 L0 dispatch (anonymous namespace)::Ev1 to (anonymous namespace)::Idle\n"
+        "#2 L0 transition (anonymous namespace)::Idle -> (anonymous namespace)::Active on (anonymous namespace)::Ev1\n"
+        "#3 L0 exit (anonymous namespace)::Idle\n"
+        "#4 L0 enter (anonymous namespace)::Active\n"
+        "#5 L1 enter (anonymous namespace)::Inner\n"
+        "#6 L0 handled (anonymous namespace)::Ev1 in (anonymous namespace)::Idle\n"
+        "#7 L1 dispatch (anonymous namespace)::Ev2 to (anonymous namespace)::Inner\n"
+        "#8 L1 handled (anonymous namespace)::Ev2 in (anonymous namespace)::Inner\n"
+        );
+}
+
+TEST_CASE("Flight recorder keeps only last N records", "[flight_recorder]")
+{
+    int ctx = 0;
+    fsmpp2::state_machine sm{States{}, Events{}, ctx, fsmpp2::flight_recorder<States, Events, 4>{}};
+
+    sm.dispatch(Ev1{});
+    sm.dispatch(Ev1{});
+
+    CHECK(sm.tracer().written() == 15);
+    CHECK(dump_and_decode(sm.tracer()) ==
+        "recorder 0: last 4 of 15 records\n"
+        "#11 L1 exit (anonymous namespace)::Inner\n"
+        "#12 L0 exit (anonymous namespace)::Active\n"
+        "#13 L0 enter (anonymous namespace)::Idle\n"
+        "#14 L0 handled (anonymous namespace)::Ev1 in (anonymous namespace)::Active\n"
+        );
+}
+
+TEST_CASE("Registered flight recorders are dumped on SIGUSR1", "[flight_recorder]")
+{
+    auto const path = std::string{"fsmpp2_flight_recorder_test.bin"};
+    REQUIRE(fsmpp2::flight::install_signal_handlers(path.c_str()));
+
+    int ctx = 0;
+    fsmpp2::state_machine sm1{States{}, Events{}, ctx, fsmpp2::flight_recorder<States, Events>{}};
+    fsmpp2::state_machine sm2{States{}, Events{}, ctx, fsmpp2::flight_recorder<States, Events>{}};
+    fsmpp2::state_machine sm3{States{}, Events{}, ctx, fsmpp2::flight_recorder<States, Events>{}};
+
+    REQUIRE(sm1.tracer().register_for_dump());
+    REQUIRE(sm2.tracer().register_for_dump());
+
+    sm1.dispatch(Ev1{});
+
+    ::raise(SIGUSR1);
+
+    std::ifstream ifs{path, std::ios::binary};
+    std::ostringstream os;
+    REQUIRE(fsmpp2::flight::decode(ifs, os));
+
+    auto const text = os.str();
+    CHECK(text.find("recorder 0: last 7 of 7 records") != std::string::npos);
+    CHECK(text.find("recorder 1: last 1 of 1 records") != std::string::npos);
+    CHECK(text.find("recorder 2") == std::string::npos);
+
+    std::remove(path.c_str());
+    fsmpp2::flight::uninstall_signal_handlers();
+}
+
+namespace
+{
+
+volatile sig_atomic_t previous_handler_calls = 0;
+
+void previous_handler(int) {
+    previous_handler_calls = previous_handler_calls + 1;
+}
+
+}
+
+TEST_CASE("Flight recorder signal handlers keep previous handlers and errno", "[flight_recorder]")
+{
+    struct sigaction action {};
+    action.sa_handler = previous_handler;
+    sigemptyset(&action.sa_mask);
+
+    struct sigaction original {};
+    REQUIRE(::sigaction(SIGUSR1, &action, &original) == 0);
+
+    // the dump can't be written, open() fails inside the handler
+    REQUIRE(fsmpp2::flight::install_signal_handlers("/nonexistent/fsmpp2_flight_recorder_test.bin"));
+
+    errno = EDOM;
+    ::raise(SIGUSR1);
+
+    CHECK(errno == EDOM);
+    CHECK(previous_handler_calls == 1);
+
+    fsmpp2::flight::uninstall_signal_handlers();
+
+    struct sigaction current {};
+    ::sigaction(SIGUSR1, nullptr, &current);
+    CHECK(current.sa_handler == previous_handler);
+
+    ::sigaction(SIGUSR1, &original, nullptr);
+}
+
+TEST_CASE("Flight recorder passes crashes on to previous handlers", "[flight_recorder]")
+{
+    auto const path = std::string{"fsmpp2_flight_recorder_crash.bin"};
+    auto const pid = ::fork();
+    REQUIRE(pid >= 0);
+
+    if (pid == 0) {
+        // child, crashes with a handler of its own installed before the recorder's one
+        struct sigaction action {};
+        action.sa_handler = [](int) { ::_exit(42); };
+        sigemptyset(&action.sa_mask);
+        ::sigaction(SIGABRT, &action, nullptr);
+
+        fsmpp2::flight::install_signal_handlers(path.c_str());
+        std::abort();
+    }
+
+    int status = 0;
+    REQUIRE(::waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status));
+    CHECK(WEXITSTATUS(status) == 42);
+
+    // the dump was written before the previous handler got the signal
+    CHECK(std::ifstream{path}.good());
+    std::remove(path.c_str());
+}
@@ -0,0 +1,148 @@
+#include "catch.hpp"
+#include "fsmpp2/lockstep.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+struct Open : fsmpp2::event {};
+struct Syn : fsmpp2::event {};
+struct Ack : fsmpp2::event {};
+struct Fin : fsmpp2::event {};
+struct Reset : fsmpp2::event {};
+
+struct Closed;
+struct Listen;
+struct SynReceived;
+struct Established;
+struct Closing;
+
+using Table = fsmpp2::transition_table<
+    fsmpp2::edge<Closed, Open, Listen>,
+    fsmpp2::edge<Listen, Syn, SynReceived>,
+    fsmpp2::edge<Listen, Reset, Closed>,
+    fsmpp2::edge<SynReceived, Ack, Established>,
+    fsmpp2::edge<SynReceived, Reset, Listen>,
+    fsmpp2::edge<Established, Fin, Closing>,
+    fsmpp2::edge<Established, Reset, Closed>,
+    fsmpp2::edge<Closing, Ack, Closed>,
+    fsmpp2::edge<Closing, Syn, fsmpp2::none>
+>;
+
+struct Closed : fsmpp2::state<> { using transition_table = Table; };
+struct Listen : fsmpp2::state<> { using transition_table = Table; };
+struct SynReceived : fsmpp2::state<> { using transition_table = Table; };
+struct Established : fsmpp2::state<> { using transition_table = Table; };
+struct Closing : fsmpp2::state<> { using transition_table = Table; };
+
+using States = fsmpp2::states<Closed, Listen, SynReceived, Established, Closing>;
+using Events = fsmpp2::events<Open, Syn, Ack, Fin, Reset>;
+using Lockstep = fsmpp2::lockstep<States, Events>;
+
+struct Context {};
+using Machine = fsmpp2::state_machine<States, Events, Context>;
+
+template<class... S>
+std::uint8_t current_state(Machine const& sm, fsmpp2::states<S...>) {
+    std::uint8_t idx = 0;
+    ((sm.is_in<S>() ? idx = Lockstep::state_index<S>() : 0), ...);
+    return idx;
+}
+
+template<class... E>
+void dispatch_by_id(Machine& sm, std::uint8_t id, fsmpp2::meta::type_list<E...>) {
+    ((id == Lockstep::event_index<E>() ? (sm.dispatch(E{}), 0) : 0), ...);
+}
+
+struct Next : fsmpp2::event {};
+
+constexpr std::size_t ring_size = 300;
+
+template<std::size_t I>
+struct Ring : fsmpp2::state<> {
+    using transition_table = fsmpp2::transition_table<fsmpp2::edge<Ring<I>, Next, Ring<(I + 1) % ring_size>>>;
+};
+
+template<std::size_t... I>
+auto ring_states(std::index_sequence<I...>) -> fsmpp2::states<Ring<I>...>;
+
+using RingLockstep = fsmpp2::lockstep<decltype(ring_states(std::make_index_sequence<ring_size>{})), fsmpp2::events<Next>>;
+
+std::vector<fsmpp2::lockstep_isa> const isas {
+    fsmpp2::lockstep_isa::scalar, fsmpp2::lockstep_isa::avx2, fsmpp2::lockstep_isa::avx512
+};
+
+}
+
+TEST_CASE("Lockstep table is extracted at compile time", "[lockstep]")
+{
+    STATIC_REQUIRE(std::is_same_v<Lockstep::index_type, std::uint8_t>);
+    STATIC_REQUIRE(Lockstep::next(Lockstep::state_index<Closed>(), Lockstep::event_index<Open>()) == Lockstep::state_index<Listen>());
+    STATIC_REQUIRE(Lockstep::next(Lockstep::state_index<Closed>(), Lockstep::event_index<Ack>()) == Lockstep::state_index<Closed>());
+    STATIC_REQUIRE(Lockstep::next(Lockstep::state_index<Closing>(), Lockstep::event_index<Syn>()) == Lockstep::state_index<Closing>());
+    STATIC_REQUIRE(Lockstep::next(Lockstep::state_index<Established>(), Lockstep::no_event) == Lockstep::state_index<Established>());
+
+    STATIC_REQUIRE(std::is_same_v<RingLockstep::index_type, std::uint16_t>);
+}
+
+TEST_CASE("Lockstep stepping matches state machines", "[lockstep]")
+{
+    // not a multiple of any vector width, the tail is stepped too
+    constexpr std::size_t count = 77;
+    constexpr std::size_t steps = 200;
+
+    std::vector<std::uint8_t> events(count * steps);
+    std::uint32_t seed = 12345;
+
+    for (auto& e : events) {
+        seed = seed * 1103515245u + 12345u;
+        e = static_cast<std::uint8_t>((seed >> 16) % (Lockstep::events_count + 1));
+    }
+
+    std::vector<Machine> machines(count);
+    std::vector<std::uint8_t> expected(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        for (std::size_t t = 0; t < steps; ++t) {
+            dispatch_by_id(machines[i], events[t * count + i], Events{});
+        }
+
+        expected[i] = current_state(machines[i], States{});
+    }
+
+    for (auto isa : isas) {
+        std::vector<std::uint8_t> states(count, Lockstep::state_index<Closed>());
+        Lockstep::run(states.data(), events.data(), count, steps, isa);
+        CHECK(states == expected);
+    }
+}
+
+TEST_CASE("Lockstep stepping with 16-bit state indices", "[lockstep]")
+{
+    constexpr std::size_t count = 45;
+
+    for (auto isa : isas) {
+        std::vector<std::uint16_t> states(count);
+        std::vector<std::uint16_t> events(count, RingLockstep::event_index<Next>());
+
+        for (std::size_t i = 0; i < count; ++i) {
+            states[i] = static_cast<std::uint16_t>(i * 7 % ring_size);
+        }
+
+        // the last one stays
+        events.back() = RingLockstep::no_event;
+
+        for (int t = 0; t < 10; ++t) {
+            RingLockstep::step(states.data(), events.data(), count, isa);
+        }
+
+        for (std::size_t i = 0; i + 1 < count; ++i) {
+            CHECK(states[i] == (i * 7 % ring_size + 10) % ring_size);
+        }
+
+        CHECK(states.back() == (count - 1) * 7 % ring_size);
+    }
+}
@@ -0,0 +1,290 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/mailbox.hpp"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct TimeElapsed : fsmpp2::event {
+    std::chrono::seconds delta {0};
+    using coalescing = fsmpp2::coalesce_sum<&TimeElapsed::delta>;
+};
+
+struct Temperature : fsmpp2::event {
+    int value = 0;
+};
+
+struct Button : fsmpp2::event {
+    using coalescing = fsmpp2::coalesce_drop_duplicates;
+    int id = 0;
+    bool operator==(Button const& rhs) const { return id == rhs.id; }
+};
+
+struct DoorOpen : fsmpp2::event {};
+
+}
+
+template<> struct fsmpp2::coalescing<Temperature> {
+    using type = fsmpp2::coalesce_replace_latest;
+};
+
+namespace
+{
+
+struct Context {
+    std::vector<std::string> log;
+    std::chrono::seconds elapsed {0};
+    int dispatched = 0;
+};
+
+struct Running : fsmpp2::state<> {
+    auto handle(TimeElapsed const& e, Context& ctx) const {
+        ctx.log.push_back("time " + std::to_string(e.delta.count()));
+        ctx.elapsed += e.delta;
+        ctx.dispatched ++;
+        return handled();
+    }
+
+    auto handle(Temperature const& e, Context& ctx) const {
+        ctx.log.push_back("temp " + std::to_string(e.value));
+        ctx.dispatched ++;
+        return handled();
+    }
+
+    auto handle(Button const& e, Context& ctx) const {
+        ctx.log.push_back("button " + std::to_string(e.id));
+        ctx.dispatched ++;
+        return handled();
+    }
+
+    auto handle(DoorOpen const&, Context& ctx) const {
+        ctx.log.push_back("door");
+        ctx.dispatched ++;
+        return handled();
+    }
+};
+
+using Events = fsmpp2::events<TimeElapsed, Temperature, Button, DoorOpen>;
+using Machine = fsmpp2::state_machine<fsmpp2::states<Running>, Events, Context>;
+
+TimeElapsed elapsed(int s) {
+    TimeElapsed e;
+    e.delta = std::chrono::seconds{s};
+    return e;
+}
+
+}
+
+TEST_CASE("Coalescing policy declared by an event", "[coalescing]")
+{
+    STATIC_REQUIRE(std::is_same_v<fsmpp2::coalescing<DoorOpen>::type, fsmpp2::coalesce_none>);
+    STATIC_REQUIRE(std::is_same_v<fsmpp2::coalescing<Button>::type, fsmpp2::coalesce_drop_duplicates>);
+    STATIC_REQUIRE(std::is_same_v<fsmpp2::coalescing<Temperature>::type, fsmpp2::coalesce_replace_latest>);
+}
+
+TEST_CASE("Events are coalesced at enqueue time", "[coalescing][mailbox]")
+{
+    Machine sm;
+    fsmpp2::mailbox<Machine> mbox {sm};
+
+    CHECK(mbox.post(elapsed(1)));
+    CHECK_FALSE(mbox.post(elapsed(2)));
+    CHECK(mbox.post(Temperature{{}, 20}));
+    CHECK_FALSE(mbox.post(Temperature{{}, 21}));
+    CHECK(mbox.post(Button{{}, 1}));
+    CHECK_FALSE(mbox.post(Button{{}, 1}));
+    CHECK(mbox.post(Button{{}, 2}));
+    CHECK(mbox.post(DoorOpen{}));
+    CHECK(mbox.post(DoorOpen{}));
+    CHECK(mbox.post(elapsed(3)));
+    CHECK_FALSE(mbox.post(elapsed(3)));
+
+    CHECK(mbox.size() == 7);
+    CHECK(mbox.process() == 7);
+    CHECK(mbox.size() == 0);
+
+    CHECK(sm.context().log == std::vector<std::string>{
+        "time 3", "temp 21", "button 1", "button 2", "door", "door", "time 6"});
+
+    // nothing is pending anymore, new events are queued
+    CHECK(mbox.post(elapsed(1)));
+    CHECK(mbox.post(Button{{}, 2}));
+    CHECK(mbox.process() == 2);
+    CHECK(sm.context().elapsed == std::chrono::seconds{10});
+}
+
+TEST_CASE("Events are not coalesced across other events", "[coalescing][mailbox]")
+{
+    Machine sm;
+    fsmpp2::mailbox<Machine> mbox {sm};
+
+    CHECK(mbox.post(elapsed(5)));
+    CHECK(mbox.post(DoorOpen{}));
+    CHECK(mbox.post(elapsed(3)));
+    CHECK(mbox.post(Temperature{{}, 20}));
+    CHECK(mbox.post(Button{{}, 1}));
+    CHECK(mbox.post(Temperature{{}, 21}));
+    CHECK(mbox.post(DoorOpen{}));
+    CHECK(mbox.post(Button{{}, 1}));
+
+    CHECK(mbox.process() == 8);
+    CHECK(sm.context().log == std::vector<std::string>{
+        "time 5", "door", "time 3", "temp 20", "button 1", "temp 21", "door", "button 1"});
+}
+
+TEST_CASE("Mailbox accepts events from many threads", "[mailbox]")
+{
+    Machine sm;
+    fsmpp2::mailbox<Machine> mbox {sm};
+    std::vector<std::thread> producers;
+
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&mbox] {
+            for (int i = 0; i < 1000; ++i) {
+                mbox.post(elapsed(1));
+                mbox.post(DoorOpen{});
+            }
+        });
+    }
+
+    while (sm.context().elapsed < std::chrono::seconds{4000}) {
+        mbox.process();
+    }
+
+    for (auto& p : producers) {
+        p.join();
+    }
+
+    mbox.process();
+
+    auto doors = 0;
+    for (auto const& l : sm.context().log) {
+        doors += l == "door";
+    }
+
+    CHECK(doors == 4000);
+    CHECK(sm.context().elapsed == std::chrono::seconds{4000});
+    CHECK(sm.context().dispatched <= 8000);
+}
+
+namespace
+{
+
+struct Data : fsmpp2::event {
+    int value = 0;
+};
+
+struct Timeout : fsmpp2::event {
+    static constexpr std::size_t priority = 1;
+};
+
+struct Shutdown : fsmpp2::event {};
+
+}
+
+template<> struct fsmpp2::priority<Shutdown> : std::integral_constant<std::size_t, 2> {};
+
+namespace
+{
+
+struct LanesContext {
+    std::vector<std::string> log;
+};
+
+struct Serving : fsmpp2::state<> {
+    auto handle(Data const& e, LanesContext& ctx) const {
+        ctx.log.push_back("data " + std::to_string(e.value));
+        return handled();
+    }
+
+    auto handle(Timeout const&, LanesContext& ctx) const {
+        ctx.log.push_back("timeout");
+        return handled();
+    }
+
+    auto handle(Shutdown const&, LanesContext& ctx) const {
+        ctx.log.push_back("shutdown");
+        return handled();
+    }
+};
+
+using LanesMachine = fsmpp2::state_machine<fsmpp2::states<Serving>, fsmpp2::events<Data, Timeout, Shutdown>, LanesContext>;
+
+}
+
+TEST_CASE("Priority lanes are served from the highest one", "[mailbox][priority]")
+{
+    STATIC_REQUIRE(fsmpp2::priority<Data>::value == 0);
+    STATIC_REQUIRE(fsmpp2::priority<Timeout>::value == 1);
+    STATIC_REQUIRE(fsmpp2::priority<Shutdown>::value == 2);
+
+    LanesMachine sm;
+    fsmpp2::priority_mailbox<LanesMachine, 8, 3> mbox {sm, 2};
+
+    for (int i = 0; i < 5; ++i) {
+        CHECK(mbox.post(Data{{}, i}));
+    }
+
+    CHECK(mbox.post(Timeout{}));
+    CHECK(mbox.post(Timeout{}));
+    CHECK(mbox.post(Timeout{}));
+    CHECK(mbox.post(Shutdown{}));
+
+    CHECK(mbox.process() == 9);
+
+    // at most 2 events from a lane in a round
+    CHECK(sm.context().log == std::vector<std::string>{
+        "shutdown", "timeout", "timeout", "data 0", "data 1",
+        "timeout", "data 2", "data 3",
+        "data 4"});
+
+    // lanes are bounded
+    for (int i = 0; i < 8; ++i) {
+        CHECK(mbox.post(Data{{}, i}));
+    }
+
+    CHECK_FALSE(mbox.post(Data{}));
+    CHECK(mbox.post(Shutdown{}));
+
+    CHECK(mbox.process(3) == 3);
+    CHECK(mbox.process() == 6);
+}
+
+TEST_CASE("Priority mailbox accepts events from many threads", "[mailbox][priority]")
+{
+    LanesMachine sm;
+    fsmpp2::priority_mailbox<LanesMachine, 64, 3> mbox {sm};
+    std::vector<std::thread> producers;
+
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&mbox] {
+            for (int i = 0; i < 1000; ++i) {
+                while (!mbox.post(Data{{}, i})) {
+                    std::this_thread::yield();
+                }
+            }
+
+            while (!mbox.post(Timeout{})) {
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    std::size_t total = 0;
+
+    while (total < 4004) {
+        total += mbox.process();
+    }
+
+    for (auto& p : producers) {
+        p.join();
+    }
+
+    CHECK(total == 4004);
+    CHECK(mbox.process() == 0);
+    CHECK(sm.context().log.size() == 4004);
+}
@@ -30,4 +30,19 @@ static_assert(std::is_same_v<type_list_type<2, list_0>::type, float>, "float at
 // TODO: static_assert(std::is_same_v<type_list_type<3, list_0>::type, double> == ???, "??");
 
 // type_list_first
-static_assert(std::is_same_v<typename type_list_first<list_0>::type, char>, "first type should be char");
\ No newline at end of file
+static_assert(std::is_same_v<typename type_list_first<list_0>::type, char>, "first type should be char");
+
+// type_list_concat
+static_assert(std::is_same_v<typename type_list_concat<>::result, type_list<>>, "empty concat");
+static_assert(std::is_same_v<typename type_list_concat<list_0, type_list<>>::result, list_0>, "concat with empty list");
+static_assert(std::is_same_v<typename type_list_concat<type_list<char>, type_list<int>, type_list<float>>::result, list_0>, "concat three lists");
+
+// type_list_remove
+static_assert(std::is_same_v<typename type_list_remove<int, list_0>::result, type_list<char, float>>, "remove a type");
+static_assert(std::is_same_v<typename type_list_remove<double, list_0>::result, list_0>, "remove missing type");
+static_assert(std::is_same_v<typename type_list_remove<int, type_list<>>::result, type_list<>>, "remove from empty list");
+
+// type_list_union
+static_assert(std::is_same_v<typename type_list_union<>::result, type_list<>>, "empty union");
+static_assert(std::is_same_v<typename type_list_union<type_list<char, int>, type_list<int, float>>::result, list_0>, "union skips duplicates");
+static_assert(std::is_same_v<typename type_list_union<type_list<>, type_list<char>, list_0>::result, list_0>, "union of three lists");
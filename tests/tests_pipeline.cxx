@@ -0,0 +1,129 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/pipeline.hpp"
+
+namespace
+{
+
+struct Bytes : fsmpp2::event { int value = 0; };
+struct Frame : fsmpp2::event { int value = 0; };
+struct Close : fsmpp2::event {};
+struct Send : fsmpp2::event { int value = 0; };
+
+using SessionEvents = fsmpp2::events<Frame, Close>;
+using EgressEvents = fsmpp2::events<Send>;
+
+struct DecoderContext : fsmpp2::outbox<SessionEvents> {
+    int decoded = 0;
+};
+
+struct SessionContext {
+    int frames = 0;
+    int last = -1;
+    bool ordered = true;
+};
+
+struct EgressContext {
+    long long sum = 0;
+    int sent = 0;
+};
+
+struct Decoding : fsmpp2::state<> {
+    auto handle(Bytes const& b, DecoderContext& ctx) {
+        ctx.decoded ++;
+        ctx.emit(Frame{{}, b.value});
+
+        if (b.value % 100 == 99) {
+            ctx.emit(Close{});
+        }
+
+        return handled();
+    }
+};
+
+struct Established : fsmpp2::state<> {
+    auto handle(Frame const& f, fsmpp2::access_context<SessionContext, fsmpp2::outbox<EgressEvents>> c) {
+        auto& ctx = c.get_context<SessionContext>();
+        ctx.ordered = ctx.ordered && f.value == ctx.last + 1;
+        ctx.last = f.value;
+        ctx.frames ++;
+        c.get_context<fsmpp2::outbox<EgressEvents>>().emit(Send{{}, f.value * 2});
+        return handled();
+    }
+
+    auto handle(Close const&) {
+        return handled();
+    }
+};
+
+struct Sending : fsmpp2::state<> {
+    auto handle(Send const& s, EgressContext& ctx) {
+        ctx.sum += s.value;
+        ctx.sent ++;
+        return handled();
+    }
+};
+
+using SessionContexts = fsmpp2::contexts<SessionContext, fsmpp2::outbox<EgressEvents>>;
+
+using Decoder = fsmpp2::state_machine<fsmpp2::states<Decoding>, fsmpp2::events<Bytes>, DecoderContext&>;
+using Session = fsmpp2::state_machine<fsmpp2::states<Established>, SessionEvents, SessionContexts>;
+using Egress = fsmpp2::state_machine<fsmpp2::states<Sending>, EgressEvents, EgressContext&>;
+
+}
+
+TEST_CASE("Outbox buffers emitted events", "[pipeline]")
+{
+    fsmpp2::outbox<EgressEvents> out;
+    out.emit(Send{});
+    out.emit(Send{});
+    CHECK(out.size() == 2);
+}
+
+TEST_CASE("Pipeline passes events through all the stages", "[pipeline]")
+{
+    constexpr int count = 20000;
+
+    DecoderContext decoder_ctx;
+    SessionContext session_ctx;
+    fsmpp2::outbox<EgressEvents> to_egress;
+    EgressContext egress_ctx;
+
+    Decoder decoder {decoder_ctx};
+    Session session {SessionContexts{session_ctx, to_egress}};
+    Egress egress {egress_ctx};
+
+    {
+        // small rings to exercise backpressure
+        fsmpp2::pipeline<16, Decoder, Session, Egress> chain {decoder, session, egress};
+
+        for (int i = 0; i < count; ++i) {
+            chain.push(Bytes{{}, i});
+        }
+
+        chain.stop();
+    }
+
+    CHECK(decoder_ctx.decoded == count);
+    CHECK(session_ctx.frames == count);
+    CHECK(session_ctx.ordered);
+    CHECK(egress_ctx.sent == count);
+    CHECK(egress_ctx.sum == (long long)count * (count - 1));
+}
+
+TEST_CASE("Pipeline with a single stage", "[pipeline]")
+{
+    EgressContext ctx;
+    Egress egress {ctx};
+
+    {
+        fsmpp2::pipeline<4, Egress> chain {egress};
+
+        for (int i = 0; i < 100; ++i) {
+            while (!chain.try_push(Send{{}, 1})) {
+            }
+        }
+    }
+
+    CHECK(ctx.sent == 100);
+}
@@ -0,0 +1,177 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/plantuml.hpp"
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Context {
+    int resets = 0;
+};
+
+struct Connect : fsmpp2::event {};
+struct Disconnect : fsmpp2::event {};
+struct Login : fsmpp2::event {};
+struct Logout : fsmpp2::event {};
+struct Reset : fsmpp2::event {};
+struct Shutdown : fsmpp2::event {};
+struct Start : fsmpp2::event {};
+struct Ping : fsmpp2::event {};
+
+struct Connected;
+struct Authenticated;
+struct Offline;
+
+struct Disconnected : fsmpp2::state<> {
+    static constexpr auto name = "disconnected";
+    auto handle(Connect const&) const { return transition<Connected>(); }
+};
+
+struct Connected : fsmpp2::state<> {
+    static constexpr auto name = "connected";
+    auto handle(Disconnect const&) const { return transition<Disconnected>(); }
+    auto handle(Reset const&, Context& ctx) const { ctx.resets ++; return handled(); }
+};
+
+struct Anonymous : fsmpp2::state<> {
+    static constexpr auto name = "anonymous";
+    auto handle(Login const&) const { return transition<Authenticated>(); }
+};
+
+struct Authenticated : fsmpp2::state<> {
+    static constexpr auto name = "authenticated";
+    auto handle(Logout const&) const { return transition<Anonymous>(); }
+    auto handle(Reset const&, Context& ctx) const { ctx.resets ++; return handled(); }
+};
+
+struct Online : fsmpp2::parallel_state<
+    fsmpp2::states<Disconnected, Connected>,
+    fsmpp2::states<Anonymous, Authenticated>>
+{
+    static constexpr auto name = "online";
+    auto handle(Shutdown const&) const { return transition<Offline>(); }
+};
+
+struct Offline : fsmpp2::state<> {
+    static constexpr auto name = "offline";
+    auto handle(Start const&) const { return transition<Online>(); }
+};
+
+using States = fsmpp2::states<Online, Offline>;
+using Events = fsmpp2::events<Connect, Disconnect, Login, Logout, Reset, Shutdown, Start, Ping>;
+
+struct HooksTracer : fsmpp2::detail::NullTracer {
+    template<class State>
+    void enter_state(State const&) {
+        log.push_back(std::string{"enter "} + State::name);
+    }
+
+    template<class State>
+    void exit_state(State const&) {
+        log.push_back(std::string{"exit "} + State::name);
+    }
+
+    std::vector<std::string> log;
+};
+
+}
+
+TEST_CASE("Orthogonal regions are active at once", "[state_machine][regions]")
+{
+    Context ctx;
+    fsmpp2::state_machine sm{States{}, Events{}, ctx};
+
+    CHECK(sm.is_in<Online>());
+    CHECK(sm.is_in<Online, Disconnected>());
+    CHECK(sm.is_in<Online, Anonymous>());
+    CHECK_FALSE(sm.is_in<Connected>());
+
+    CHECK(sm.dispatch(Connect{}));
+    CHECK(sm.is_in<Connected>());
+    CHECK(sm.is_in<Anonymous>());
+
+    CHECK(sm.dispatch(Login{}));
+    CHECK(sm.is_in<Connected>());
+    CHECK(sm.is_in<Authenticated>());
+
+    // handled by both regions
+    CHECK(sm.dispatch(Reset{}));
+    CHECK(ctx.resets == 2);
+
+    CHECK(sm.dispatch(Logout{}));
+    CHECK(sm.dispatch(Reset{}));
+    CHECK(ctx.resets == 3);
+
+    CHECK_FALSE(sm.dispatch(Ping{}));
+
+    // not handled by regions, passed to the parallel state
+    CHECK(sm.dispatch(Shutdown{}));
+    CHECK(sm.is_in<Offline>());
+    CHECK_FALSE(sm.is_in<Online>());
+    CHECK_FALSE(sm.is_in<Connected>());
+    CHECK_FALSE(sm.is_in<Anonymous>());
+
+    CHECK(sm.dispatch(Start{}));
+    CHECK(sm.is_in<Online, Disconnected>());
+    CHECK(sm.is_in<Online, Anonymous>());
+}
+
+TEST_CASE("Orthogonal regions are entered in order and exited in reverse order", "[state_machine][regions][tracer]")
+{
+    Context ctx;
+    HooksTracer tracer;
+
+    {
+        fsmpp2::state_machine sm{States{}, Events{}, ctx, tracer};
+        sm.dispatch(Login{});
+        sm.dispatch(Shutdown{});
+    }
+
+    CHECK(tracer.log == std::vector<std::string>{
+        "enter online",
+        "enter disconnected",
+        "enter anonymous",
+        "exit anonymous",
+        "enter authenticated",
+        "exit authenticated",
+        "exit disconnected",
+        "exit online",
+        "enter offline",
+        "exit offline"});
+}
+
+TEST_CASE("Orthogonal regions in state tree", "[regions][state_tree]")
+{
+    using fsmpp2::detail::all_states;
+    using fsmpp2::meta::type_list;
+
+    STATIC_REQUIRE(std::is_same_v<
+        all_states<States>::type,
+        type_list<Online, Disconnected, Connected, Anonymous, Authenticated, Offline>>);
+    STATIC_REQUIRE(fsmpp2::detail::has_regions<States>::value);
+    STATIC_REQUIRE(!fsmpp2::detail::has_regions<fsmpp2::states<Offline>>::value);
+
+    constexpr auto parents = fsmpp2::detail::state_parents<States>();
+    STATIC_REQUIRE(parents[1] == 0);
+    STATIC_REQUIRE(parents[3] == 0);
+    STATIC_REQUIRE(parents[5] == 6);
+
+    constexpr auto depths = fsmpp2::detail::state_depths<States>();
+    STATIC_REQUIRE(depths[2] == 1);
+    STATIC_REQUIRE(depths[4] == 1);
+    STATIC_REQUIRE(depths[5] == 0);
+}
+
+TEST_CASE("Orthogonal regions in state diagram", "[regions][plantuml]")
+{
+    std::ostringstream os;
+    fsmpp2::plantuml::print_state_diagram<States, Events>(os);
+
+    auto const diagram = os.str();
+    CHECK(diagram.find("state (anonymous namespace)__Online {\n"
+        "[*] --> (anonymous namespace)__Disconnected\n") != std::string::npos);
+    CHECK(diagram.find("--\n[*] --> (anonymous namespace)__Anonymous\n") != std::string::npos);
+}
@@ -0,0 +1,94 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/shared_dispatch.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct Context {
+    int value = 0;
+};
+
+struct Get : fsmpp2::event {};
+struct Set : fsmpp2::event { int value; };
+struct Stop : fsmpp2::event {};
+
+struct Stopped : fsmpp2::state<> {};
+
+struct Running : fsmpp2::state<> {
+    auto handle(Get const&, Context const& ctx) const {
+        return ctx.value >= 0 ? handled() : not_handled();
+    }
+
+    auto handle(Set const& e, Context& ctx) {
+        ctx.value = e.value;
+        return handled();
+    }
+
+    auto handle(Stop const&) const {
+        return transition<Stopped>();
+    }
+};
+
+using States = fsmpp2::states<Running, Stopped>;
+using Events = fsmpp2::events<Get, Set, Stop>;
+using Machine = fsmpp2::state_machine<States, Events, Context&>;
+
+static_assert(Machine::is_read_only<Get>());
+static_assert(!Machine::is_read_only<Set>());
+static_assert(!Machine::is_read_only<Stop>());
+
+}
+
+TEST_CASE("Dispatch read-only event to a const state machine", "[state_machine][read_only]")
+{
+    Context ctx;
+    Machine sm{ctx};
+    auto const& csm = sm;
+
+    CHECK(csm.dispatch(Get{}));
+
+    sm.dispatch(Set{{}, -1});
+    CHECK_FALSE(csm.dispatch(Get{}));
+
+    sm.dispatch(Stop{});
+    CHECK_FALSE(csm.dispatch(Get{}));
+}
+
+TEST_CASE("Shared lock dispatch of read-only events", "[shared_dispatch][read_only]")
+{
+    Context ctx;
+    fsmpp2::shared_dispatch<Machine> sm{ctx};
+
+    std::atomic<bool> done {false};
+    std::atomic<int> handled {0};
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            while (!done) {
+                if (sm.dispatch(Get{})) {
+                    handled ++;
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        sm.dispatch(Set{{}, i});
+    }
+
+    sm.dispatch(Stop{});
+    done = true;
+
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    CHECK(sm.machine().is_in<Stopped>());
+    CHECK(ctx.value == 999);
+    CHECK_FALSE(sm.dispatch(Get{}));
+}
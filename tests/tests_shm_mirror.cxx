@@ -0,0 +1,216 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/shm_mirror.hpp"
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+
+struct Ev1 : fsmpp2::event {};
+struct Ev2 : fsmpp2::event {};
+
+struct Idle;
+
+struct Inner : fsmpp2::state<> {
+    auto handle(Ev2 const&) const { return handled(); }
+};
+
+struct Active : fsmpp2::state<Inner> {
+    auto handle(Ev1 const&) const { return transition<Idle>(); }
+};
+
+struct Idle : fsmpp2::state<> {
+    auto handle(Ev1 const&) const { return transition<Active>(); }
+};
+
+using States = fsmpp2::states<Idle, Active>;
+using Events = fsmpp2::events<Ev1, Ev2>;
+
+// ids in the flattened hierarchy
+constexpr std::uint16_t idle_id = 0;
+constexpr std::uint16_t active_id = 1;
+constexpr std::uint16_t inner_id = 2;
+
+std::string segment_name()
+{
+    return "/fsmpp2-tests-" + std::to_string(::getpid());
+}
+
+}
+
+TEST_CASE("Shared memory mirror publishes state path and counters", "[shm_mirror]")
+{
+    fsmpp2::mirror::segment shm{segment_name(), 4};
+    REQUIRE(shm.valid());
+
+    fsmpp2::mirror::reader view{segment_name()};
+    REQUIRE(view.valid());
+    CHECK(view.slot_count() == 4);
+
+    fsmpp2::mirror::machine_snapshot snap;
+    CHECK_FALSE(view.read(0, snap));
+
+    {
+        int ctx = 0;
+        fsmpp2::state_machine sm{States{}, Events{}, ctx, shm.make_tracer<States>("machine-1")};
+        REQUIRE(sm.tracer().attached());
+
+        REQUIRE(view.read(0, snap));
+        CHECK(snap.label == "machine-1");
+        REQUIRE(snap.states.size() == 3);
+        CHECK(snap.states[active_id].find("Active") != std::string::npos);
+        CHECK(snap.path == std::vector<std::uint16_t>{idle_id});
+
+        sm.dispatch(Ev1{});
+        sm.dispatch(Ev2{});
+
+        REQUIRE(view.read(0, snap));
+        CHECK(snap.path == std::vector<std::uint16_t>{active_id, inner_id});
+        CHECK(snap.entered == std::vector<std::uint64_t>{1, 1, 1});
+        CHECK(snap.handled == std::vector<std::uint64_t>{1, 0, 1});
+
+        sm.dispatch(Ev1{});
+
+        REQUIRE(view.read(0, snap));
+        CHECK(snap.path == std::vector<std::uint16_t>{idle_id});
+        CHECK(snap.entered == std::vector<std::uint64_t>{2, 1, 1});
+        CHECK(snap.handled == std::vector<std::uint64_t>{1, 1, 1});
+    }
+
+    // slot is released together with the state machine
+    CHECK_FALSE(view.read(0, snap));
+}
+
+TEST_CASE("Shared memory mirror reader rejects a segment shorter than its header claims", "[shm_mirror]")
+{
+    fsmpp2::mirror::segment shm{segment_name(), 4};
+    REQUIRE(shm.valid());
+
+    auto const fd = ::shm_open(segment_name().c_str(), O_RDWR, 0);
+    REQUIRE(fd >= 0);
+
+    SECTION("truncated segment") {
+        REQUIRE(::ftruncate(fd, fsmpp2::mirror::detail::segment_size(2)) == 0);
+    }
+
+    SECTION("bogus slot count") {
+        std::uint32_t const slots = 1000;
+        REQUIRE(::pwrite(fd, &slots, sizeof(slots), offsetof(fsmpp2::mirror::segment_header, slot_count)) == sizeof(slots));
+    }
+
+    ::close(fd);
+
+    fsmpp2::mirror::reader view{segment_name()};
+    CHECK_FALSE(view.valid());
+    CHECK(view.slot_count() == 0);
+}
+
+TEST_CASE("Shared memory mirror runs out of slots", "[shm_mirror]")
+{
+    fsmpp2::mirror::segment shm{segment_name(), 1};
+    REQUIRE(shm.valid());
+
+    auto t1 = shm.make_tracer<States>();
+    auto t2 = shm.make_tracer<States>();
+
+    CHECK(t1.attached());
+    CHECK_FALSE(t2.attached());
+
+    // detached tracer is a no-op
+    int ctx = 0;
+    fsmpp2::state_machine sm{States{}, Events{}, ctx, std::move(t2)};
+    sm.dispatch(Ev1{});
+    CHECK_FALSE(sm.tracer().attached());
+}
+
+TEST_CASE("Shared memory mirror snapshots are consistent under concurrent dispatch", "[shm_mirror]")
+{
+    fsmpp2::mirror::segment shm{segment_name(), 1};
+    fsmpp2::mirror::reader view{segment_name()};
+    REQUIRE(view.valid());
+
+    std::atomic<bool> done {false};
+    std::thread writer{[&] {
+        int ctx = 0;
+        fsmpp2::state_machine sm{States{}, Events{}, ctx, shm.make_tracer<States>("writer")};
+
+        for (int i = 0; i < 100000; ++i) {
+            sm.dispatch(Ev1{});
+            sm.dispatch(Ev2{});
+        }
+
+        done = true;
+    }};
+
+    fsmpp2::mirror::machine_snapshot snap;
+    auto inconsistent = 0;
+    auto taken = 0;
+
+    while (!done) {
+        // slot not claimed yet or initial state not entered yet
+        if (!view.read(0, snap) || snap.path.empty()) {
+            continue;
+        }
+
+        taken ++;
+
+        // a snapshot may be taken between the steps of a transition, never in the middle of one
+        auto const& entered = snap.entered;
+        auto const idle = snap.path == std::vector<std::uint16_t>{idle_id};
+        auto const active = snap.path == std::vector<std::uint16_t>{active_id};
+        auto const inner = snap.path == std::vector<std::uint16_t>{active_id, inner_id};
+
+        auto const consistent =
+            (idle && entered[idle_id] == entered[active_id] + 1 && entered[active_id] == entered[inner_id])
+            || (active && entered[idle_id] == entered[active_id] && entered[active_id] - entered[inner_id] <= 1)
+            || (inner && entered[idle_id] == entered[active_id] && entered[active_id] == entered[inner_id]);
+
+        if (!consistent) {
+            inconsistent ++;
+        }
+    }
+
+    writer.join();
+
+    INFO("snapshots taken: " << taken);
+    CHECK(inconsistent == 0);
+}
+
+namespace
+{
+
+struct Fragile : fsmpp2::state<> {
+    auto handle(Ev1 const&) const {
+        throw std::runtime_error{"handler failed"};
+        return handled();
+    }
+};
+
+}
+
+TEST_CASE("Shared memory mirror stays readable when a handler throws", "[shm_mirror]")
+{
+    using FragileStates = fsmpp2::states<Fragile>;
+
+    fsmpp2::mirror::segment shm{segment_name(), 1};
+    fsmpp2::mirror::reader view{segment_name()};
+    REQUIRE(view.valid());
+
+    int ctx = 0;
+    fsmpp2::state_machine sm{FragileStates{}, fsmpp2::events<Ev1>{}, ctx, shm.make_tracer<FragileStates>("fragile")};
+
+    CHECK_THROWS_AS(sm.dispatch(Ev1{}), std::runtime_error);
+
+    // the slot is not left in the middle of an update, the first attempt succeeds
+    fsmpp2::mirror::machine_snapshot snap;
+    REQUIRE(view.read(0, snap, 1));
+    CHECK(snap.path == std::vector<std::uint16_t>{0});
+    CHECK(snap.handled == std::vector<std::uint64_t>{0});
+}
@@ -1,5 +1,7 @@
 #include "catch.hpp"
 #include "fsmpp2/state_machine.hpp"
+#include <atomic>
+#include <thread>
 
 namespace
 {
@@ -89,3 +91,85 @@ TEST_CASE("Multiple contexts", "[contexts][state_machine]")
     CHECK(ctx_b.value == true);
 }
 
+
+namespace
+{
+
+struct PathEv : fsmpp2::event {};
+struct PathInnerEv : fsmpp2::event {};
+
+struct Inner2;
+struct Outer2;
+
+struct Inner1 : fsmpp2::state<> {
+    auto handle(PathInnerEv const&) { return transition<Inner2>(); }
+};
+
+struct Inner2 : fsmpp2::state<> {};
+
+struct Outer1 : fsmpp2::state<Inner1, Inner2> {
+    auto handle(PathEv const&) { return transition<Outer2>(); }
+};
+
+struct Outer2 : fsmpp2::state<> {};
+
+using PathStates = fsmpp2::states<Outer1, Outer2>;
+using PathEvents = fsmpp2::events<PathEv, PathInnerEv>;
+
+}
+
+TEST_CASE("Query active state path", "[state_machine]")
+{
+    Context ctx;
+    fsmpp2::state_machine sm{PathStates{}, PathEvents{}, ctx};
+    using sm_t = decltype(sm);
+
+    static_assert(sm_t::path_id<Outer1>() == 0);
+    static_assert(sm_t::path_id<Outer1, Inner2>() == 2);
+    static_assert(sm_t::path_id<Inner2>() == sm_t::path_id<Outer1, Inner2>());
+
+    CHECK(sm.current_path_id() == sm_t::path_id<Outer1, Inner1>());
+    CHECK(sm.is_in<Outer1>());
+    CHECK(sm.is_in<Outer1, Inner1>());
+    CHECK_FALSE(sm.is_in<Outer1, Inner2>());
+    CHECK_FALSE(sm.is_in<Outer2>());
+
+    sm.dispatch(PathInnerEv{});
+    CHECK(sm.current_path_id() == sm_t::path_id<Outer1, Inner2>());
+    CHECK(sm.is_in<Outer1>());
+    CHECK(sm.is_in<Inner2>());
+    CHECK_FALSE(sm.is_in<Inner1>());
+
+    sm.dispatch(PathEv{});
+    CHECK(sm.current_path_id() == sm_t::path_id<Outer2>());
+    CHECK(sm.is_in<Outer2>());
+    CHECK_FALSE(sm.is_in<Outer1>());
+    CHECK_FALSE(sm.is_in<Inner2>());
+}
+
+TEST_CASE("Query active state path from another thread", "[state_machine]")
+{
+    Context ctx;
+    fsmpp2::state_machine sm{PathStates{}, PathEvents{}, ctx};
+
+    std::atomic<bool> done {false};
+    std::atomic<int> invalid {0};
+    std::thread observer{[&] {
+        while (!done) {
+            auto const path = sm.current_path_id();
+
+            if (path > decltype(sm)::path_id<Outer2>()) {
+                invalid ++;
+            }
+        }
+    }};
+
+    sm.dispatch(PathInnerEv{});
+    sm.dispatch(PathEv{});
+
+    done = true;
+    observer.join();
+
+    CHECK(invalid == 0);
+    CHECK(sm.is_in<Outer2>());
+}
@@ -187,3 +187,57 @@ TEST_CASE("Event handler accepting context reference", "[state_manager]")
     sm.dispatch(Ev1{});
     CHECK(ctx.value == true);
 }
+
+namespace
+{
+
+struct HooksTracer : fsmpp2::detail::NullTracer {
+    template<class State>
+    void enter_state(State const&) {
+        log.push_back(std::string{"enter "} + State::name);
+    }
+
+    template<class State>
+    void exit_state(State const&) {
+        log.push_back(std::string{"exit "} + State::name);
+    }
+
+    std::vector<std::string> log;
+};
+
+struct HookInner : fsmpp2::state<> {
+    static constexpr auto name = "inner";
+};
+
+struct HookOther : fsmpp2::state<> {
+    static constexpr auto name = "other";
+};
+
+struct HookOuter : fsmpp2::state<HookInner> {
+    static constexpr auto name = "outer";
+
+    auto handle(Ev1 const&) const {
+        return transition<HookOther>();
+    }
+};
+
+}
+
+TEST_CASE("Tracer state hooks follow state hierarchy", "[state_manager][tracer]")
+{
+    CtxA ctx;
+    HooksTracer tracer;
+
+    {
+        fsmpp2::detail::state_manager<fsmpp2::states<HookOuter, HookOther>, CtxA, HooksTracer> sm{ctx, tracer};
+        sm.dispatch(Ev1{});
+    }
+
+    CHECK(tracer.log == std::vector<std::string>{
+        "enter outer",
+        "enter inner",
+        "exit inner",
+        "exit outer",
+        "enter other",
+        "exit other"});
+}
@@ -0,0 +1,253 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/state_timeouts.hpp"
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+struct RecordingTimer : fsmpp2::timer {
+    RecordingTimer(std::vector<int>& log, int id)
+        : fsmpp2::timer {[](fsmpp2::timer& t) {
+            auto& self = static_cast<RecordingTimer&>(t);
+            self.log.push_back(self.id);
+        }}
+        , log {log}
+        , id {id}
+    {}
+
+    std::vector<int>& log;
+    int id;
+};
+
+}
+
+TEST_CASE("Timers expire in order", "[timer_wheel]")
+{
+    fsmpp2::timer_wheel wheel;
+    std::vector<int> log;
+    RecordingTimer a {log, 1}, b {log, 2}, c {log, 3}, d {log, 4};
+
+    wheel.arm_ticks(a, 10);
+    wheel.arm_ticks(b, 5);
+    wheel.arm_ticks(c, 5000);       // level 2
+    wheel.arm_ticks(d, 70);         // level 1
+    CHECK(wheel.pending() == 4);
+
+    wheel.advance_ticks(4);
+    CHECK(log.empty());
+
+    wheel.advance_ticks(1);
+    CHECK(log == std::vector<int>{2});
+
+    wheel.advance_ticks(64);
+    CHECK(log == std::vector<int>{2, 1});
+
+    wheel.advance_ticks(1);
+    CHECK(log == std::vector<int>{2, 1, 4});
+
+    wheel.advance_ticks(4929);
+    CHECK(log.size() == 3);
+    wheel.advance_ticks(1);
+    CHECK(log == std::vector<int>{2, 1, 4, 3});
+    CHECK(wheel.pending() == 0);
+    CHECK(wheel.now() == 5000);
+}
+
+TEST_CASE("Timers can be cancelled and re-armed", "[timer_wheel]")
+{
+    fsmpp2::timer_wheel wheel;
+    std::vector<int> log;
+    RecordingTimer a {log, 1}, b {log, 2};
+
+    wheel.arm_ticks(a, 100);
+    wheel.arm_ticks(b, 100);
+    wheel.cancel(a);
+    CHECK_FALSE(a.armed());
+    CHECK(wheel.pending() == 1);
+
+    {
+        RecordingTimer c {log, 3};
+        wheel.arm_ticks(c, 50);
+        CHECK(wheel.pending() == 2);
+    }
+
+    // destroyed timer is cancelled
+    CHECK(wheel.pending() == 1);
+
+    wheel.advance_ticks(50);
+    wheel.arm_ticks(b, 10);         // re-armed at 60
+    wheel.advance_ticks(50);
+    CHECK(log == std::vector<int>{2});
+    CHECK(wheel.now() == 100);
+}
+
+TEST_CASE("Timer wheel uses a virtual clock with a resolution", "[timer_wheel]")
+{
+    using namespace std::chrono;
+
+    fsmpp2::timer_wheel wheel {milliseconds{10}};
+    std::vector<int> log;
+    RecordingTimer a {log, 1};
+
+    wheel.arm(a, milliseconds{25});  // rounded up to 3 ticks
+    CHECK(a.expires() == 3);
+
+    wheel.advance(milliseconds{15});
+    wheel.advance(milliseconds{14});
+    CHECK(wheel.now() == 2);
+    CHECK(log.empty());
+
+    wheel.advance(milliseconds{1});
+    CHECK(log == std::vector<int>{1});
+}
+
+TEST_CASE("Timers beyond the wheel range", "[timer_wheel]")
+{
+    fsmpp2::timer_wheel wheel;
+    std::vector<int> log;
+    RecordingTimer a {log, 1}, b {log, 2};
+
+    auto const far = (std::uint64_t{1} << 30) + 12345;
+    wheel.arm_ticks(a, far);
+    wheel.arm_ticks(b, 1);
+
+    wheel.advance_ticks(far - 1);
+    CHECK(log == std::vector<int>{2});
+
+    wheel.advance_ticks(1);
+    CHECK(log == std::vector<int>{2, 1});
+}
+
+TEST_CASE("Many pending timers", "[timer_wheel]")
+{
+    fsmpp2::timer_wheel wheel;
+    constexpr std::size_t count = 200000;
+
+    struct CountingTimer : fsmpp2::timer {
+        std::uint64_t* fired_late;
+        std::uint64_t* fired;
+        fsmpp2::timer_wheel* wheel;
+    };
+
+    std::uint64_t fired = 0, fired_late = 0;
+    auto timers = std::make_unique<CountingTimer[]>(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        auto& t = timers[i];
+        t.fired = &fired;
+        t.fired_late = &fired_late;
+        t.wheel = &wheel;
+        t.set_callback([](fsmpp2::timer& base) {
+            auto& self = static_cast<CountingTimer&>(base);
+            (*self.fired) ++;
+            *self.fired_late += self.wheel->now() != self.expires();
+        });
+
+        wheel.arm_ticks(t, (i * 7919) % 100000 + 1);
+    }
+
+    // half of them cancelled
+    for (std::size_t i = 0; i < count; i += 2) {
+        timers[i].cancel();
+    }
+
+    CHECK(wheel.pending() == count / 2);
+
+    wheel.advance_ticks(100000);
+    CHECK(fired == count / 2);
+    CHECK(fired_late == 0);
+    CHECK(wheel.pending() == 0);
+}
+
+namespace
+{
+
+struct Context {
+    std::chrono::milliseconds heating_time {0};
+    int cooking_done = 0;
+};
+
+struct CookingDone : fsmpp2::event {};
+struct HeatingDone : fsmpp2::event {};
+struct Open : fsmpp2::event {};
+struct Start : fsmpp2::event {};
+
+struct Idle;
+struct Heating;
+
+struct Cooking : fsmpp2::state<> {
+    using timeout_event = CookingDone;
+    static constexpr auto timeout = std::chrono::seconds{30};
+
+    auto handle(CookingDone const&, Context& ctx) const {
+        ctx.cooking_done ++;
+        return transition<Idle>();
+    }
+
+    auto handle(Open const&) const { return transition<Idle>(); }
+};
+
+struct Heating : fsmpp2::state<>, fsmpp2::state_timeout<HeatingDone> {
+    Heating(Context& ctx) {
+        if (ctx.heating_time.count() > 0) {
+            set_timeout(ctx.heating_time);
+        }
+    }
+
+    auto handle(HeatingDone const&) const { return transition<Cooking>(); }
+    auto handle(Open const&) const { return transition<Idle>(); }
+};
+
+struct Idle : fsmpp2::state<> {
+    auto handle(Start const&) const { return transition<Heating>(); }
+};
+
+using States = fsmpp2::states<Idle, Heating, Cooking>;
+using Events = fsmpp2::events<CookingDone, HeatingDone, Open, Start>;
+
+}
+
+TEST_CASE("State timeouts are armed on enter and cancelled on exit", "[timer_wheel][state_timeouts]")
+{
+    using namespace std::chrono;
+
+    Context ctx;
+    ctx.heating_time = seconds{5};
+
+    fsmpp2::timer_wheel wheel;
+    fsmpp2::timeout_tracer<States> timeouts {wheel};
+    fsmpp2::state_machine sm {States{}, Events{}, ctx, timeouts};
+    timeouts.attach(sm);
+
+    sm.dispatch(Start{});
+    CHECK(timeouts.armed<Heating>());
+    CHECK(wheel.pending() == 1);
+
+    wheel.advance(seconds{5});
+    CHECK(sm.is_in<Cooking>());
+    CHECK_FALSE(timeouts.armed<Heating>());
+    CHECK(timeouts.armed<Cooking>());
+
+    wheel.advance(seconds{30});
+    CHECK(sm.is_in<Idle>());
+    CHECK(ctx.cooking_done == 1);
+    CHECK(wheel.pending() == 0);
+
+    // left before the timeout
+    sm.dispatch(Start{});
+    wheel.advance(seconds{5});
+    wheel.advance(seconds{10});
+    sm.dispatch(Open{});
+    CHECK(wheel.pending() == 0);
+    wheel.advance(seconds{60});
+    CHECK(ctx.cooking_done == 1);
+
+    // timeout not set by the state constructor
+    ctx.heating_time = milliseconds{0};
+    sm.dispatch(Start{});
+    CHECK(sm.is_in<Heating>());
+    CHECK(wheel.pending() == 0);
+}
@@ -0,0 +1,365 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/tracers.hpp"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Ev1 : fsmpp2::event {};
+
+struct StateB : fsmpp2::state<> {};
+
+struct StateA : fsmpp2::state<> {
+    auto handle(Ev1 const&) const { return transition<StateB>(); }
+};
+
+using States = fsmpp2::states<StateA, StateB>;
+using Events = fsmpp2::events<Ev1>;
+
+struct LoggingTracer {
+    explicit LoggingTracer(std::vector<std::string>& l, std::string n)
+        : log {&l}
+        , name {std::move(n)}
+    {}
+
+    template<class State, class E>
+    void begin_event_handling() { log->push_back(name + " begin"); }
+    void end_event_handling(bool) { log->push_back(name + " end"); }
+    template<class State>
+    void transition() { log->push_back(name + " transition"); }
+
+    std::vector<std::string>* log;
+    std::string name;
+};
+
+struct HookTracer {
+    template<class State, class E>
+    void begin_event_handling() {}
+    void end_event_handling(bool) {}
+    template<class State>
+    void transition() {}
+
+    template<class State>
+    void enter_state(State const&) { entered ++; }
+    template<class State>
+    void exit_state(State const&) { exited ++; }
+
+    int entered = 0;
+    int exited = 0;
+};
+
+using fsmpp2::detail::NullTracer;
+
+}
+
+static_assert(std::is_empty_v<fsmpp2::tracers<NullTracer>>, "single NullTracer takes no space");
+static_assert(sizeof(fsmpp2::tracers<NullTracer, HookTracer>) == sizeof(HookTracer), "NullTracer takes no space");
+static_assert(fsmpp2::detail::has_state_hooks<fsmpp2::tracers<NullTracer>, StateA>::value == false, "no hooks if none of the tracers has them");
+static_assert(fsmpp2::detail::has_state_hooks<fsmpp2::tracers<NullTracer, HookTracer>, StateA>::value, "hooks forwarded");
+
+TEST_CASE("Composite tracer forwards callbacks to all tracers in order", "[tracers]")
+{
+    std::vector<std::string> log;
+    int ctx = 0;
+
+    fsmpp2::state_machine sm{States{}, Events{}, ctx,
+        fsmpp2::tracers{LoggingTracer{log, "a"}, NullTracer{}, LoggingTracer{log, "b"}}};
+
+    sm.dispatch(Ev1{});
+
+    CHECK(log == std::vector<std::string>{
+        "a begin", "b begin",
+        "a transition", "b transition",
+        "a end", "b end"});
+
+    CHECK(sm.tracer().get<0>().name == "a");
+    CHECK(sm.tracer().get<2>().name == "b");
+}
+
+TEST_CASE("Composite tracer forwards state hooks only to interested tracers", "[tracers]")
+{
+    int ctx = 0;
+
+    {
+        fsmpp2::state_machine sm{States{}, Events{}, ctx, fsmpp2::tracers{NullTracer{}, HookTracer{}}};
+        CHECK(sm.tracer().get<1>().entered == 1);
+
+        sm.dispatch(Ev1{});
+        CHECK(sm.tracer().get<1>().entered == 2);
+        CHECK(sm.tracer().get<1>().exited == 1);
+    }
+}
+
+namespace
+{
+
+struct Ev2 : fsmpp2::event {};
+
+struct FilterB;
+
+struct FilterA : fsmpp2::state<> {
+    auto handle(Ev1 const&) const { return transition<FilterB>(); }
+    auto handle(Ev2 const&) const { return handled(); }
+};
+
+struct FilterB : fsmpp2::state<> {
+    auto handle(Ev1 const&) const { return transition<FilterA>(); }
+    auto handle(Ev2 const&) const { return handled(); }
+};
+
+struct TypedTracer {
+    template<class State, class E>
+    void begin_event_handling() { begins ++; }
+
+    template<class State, class E>
+    void end_event_handling(bool) { ends ++; }
+
+    template<class From, class E, class To>
+    void transition() { transitions ++; }
+
+    template<class State>
+    void enter_state(State const&) { enters ++; }
+
+    template<class State>
+    void exit_state(State const&) { exits ++; }
+
+    int begins = 0;
+    int ends = 0;
+    int transitions = 0;
+    int enters = 0;
+    int exits = 0;
+};
+
+}
+
+TEST_CASE("Filtered tracer forwards only selected states", "[tracers][filtered_tracer]")
+{
+    int ctx = 0;
+    fsmpp2::state_machine sm{
+        fsmpp2::states<FilterA, FilterB>{},
+        fsmpp2::events<Ev1, Ev2>{},
+        ctx,
+        fsmpp2::filtered_tracer<TypedTracer, fsmpp2::trace_only<FilterB>>{}};
+
+    auto const& tr = sm.tracer().inner();
+
+    sm.dispatch(Ev2{});         // FilterA, filtered out
+    CHECK(tr.begins == 0);
+    CHECK(tr.ends == 0);
+    CHECK(tr.enters == 0);
+
+    sm.dispatch(Ev1{});         // FilterA -> FilterB, target passes
+    CHECK(tr.begins == 0);
+    CHECK(tr.transitions == 1);
+    CHECK(tr.exits == 0);
+    CHECK(tr.enters == 1);
+
+    sm.dispatch(Ev2{});         // FilterB
+    CHECK(tr.begins == 1);
+    CHECK(tr.ends == 1);
+}
+
+TEST_CASE("Filtered tracer forwards all but excluded events", "[tracers][filtered_tracer]")
+{
+    int ctx = 0;
+    fsmpp2::state_machine sm{
+        fsmpp2::states<FilterA, FilterB>{},
+        fsmpp2::events<Ev1, Ev2>{},
+        ctx,
+        fsmpp2::filtered_tracer<TypedTracer, fsmpp2::trace_all, fsmpp2::trace_except<Ev2>>{}};
+
+    auto const& tr = sm.tracer().inner();
+
+    sm.dispatch(Ev2{});
+    sm.dispatch(Ev2{});
+    CHECK(tr.begins == 0);
+
+    sm.dispatch(Ev1{});
+    CHECK(tr.begins == 1);
+    CHECK(tr.ends == 1);
+    CHECK(tr.transitions == 1);
+}
+
+TEST_CASE("Filtered tracer works with untyped tracers", "[tracers][filtered_tracer]")
+{
+    std::vector<std::string> log;
+    int ctx = 0;
+    fsmpp2::state_machine sm{
+        fsmpp2::states<FilterA, FilterB>{},
+        fsmpp2::events<Ev1, Ev2>{},
+        ctx,
+        fsmpp2::filtered_tracer<LoggingTracer, fsmpp2::trace_only<FilterA>, fsmpp2::trace_only<Ev1>>{LoggingTracer{log, "t"}}};
+
+    sm.dispatch(Ev2{});
+    sm.dispatch(Ev1{});
+
+    CHECK(log == std::vector<std::string>{"t begin", "t transition", "t end"});
+}
+
+TEST_CASE("Toggled tracer forwards callbacks only when enabled", "[tracers][toggled_tracer]")
+{
+    int ctx = 0;
+    fsmpp2::state_machine sm{
+        fsmpp2::states<FilterA, FilterB>{},
+        fsmpp2::events<Ev1, Ev2>{},
+        ctx,
+        fsmpp2::toggled_tracer{TypedTracer{}, false}};
+
+    auto const& tr = sm.tracer().inner();
+
+    sm.dispatch(Ev2{});
+    CHECK(tr.begins == 0);
+    CHECK(tr.enters == 0);
+
+    sm.tracer().enable();
+    sm.dispatch(Ev2{});
+    CHECK(tr.begins == 1);
+
+    sm.dispatch(Ev1{});
+    CHECK(tr.transitions == 1);
+    CHECK(tr.exits == 1);
+    CHECK(tr.enters == 1);
+
+    sm.tracer().disable();
+    sm.dispatch(Ev1{});
+    CHECK(tr.begins == 2);
+    CHECK(tr.transitions == 1);
+}
+
+TEST_CASE("Toggled tracers share a global flag", "[tracers][toggled_tracer]")
+{
+    std::atomic<bool> flag {false};
+    int ctx = 0;
+
+    fsmpp2::state_machine sm1{fsmpp2::states<FilterA, FilterB>{}, fsmpp2::events<Ev1, Ev2>{}, ctx, fsmpp2::toggled_tracer{TypedTracer{}, flag}};
+    fsmpp2::state_machine sm2{fsmpp2::states<FilterA, FilterB>{}, fsmpp2::events<Ev1, Ev2>{}, ctx, fsmpp2::toggled_tracer{TypedTracer{}, flag}};
+
+    sm1.dispatch(Ev2{});
+    sm2.dispatch(Ev2{});
+    CHECK(sm1.tracer().inner().begins == 0);
+    CHECK(sm2.tracer().inner().begins == 0);
+
+    flag = true;
+    CHECK(sm1.tracer().enabled());
+
+    sm1.dispatch(Ev2{});
+    sm2.dispatch(Ev2{});
+    CHECK(sm1.tracer().inner().begins == 1);
+    CHECK(sm2.tracer().inner().begins == 1);
+}
+
+namespace
+{
+
+struct Toggle : fsmpp2::event {};
+
+struct ToggleB;
+
+// nested states, so every event is handled on two levels
+struct ToggleInner : fsmpp2::state<> {
+    auto handle(Toggle const&, std::atomic<bool>& flag) {
+        flag = !flag;
+        return transition<ToggleB>();
+    }
+};
+
+struct ToggleA : fsmpp2::state<ToggleInner> {};
+
+struct ToggleB : fsmpp2::state<> {
+    auto handle(Toggle const&, std::atomic<bool>& flag) {
+        flag = !flag;
+        return transition<ToggleA>();
+    }
+};
+
+}
+
+TEST_CASE("Toggled tracer keeps callbacks of an event matched", "[tracers][toggled_tracer]")
+{
+    std::atomic<bool> flag {false};
+    fsmpp2::state_machine sm{
+        fsmpp2::states<ToggleA, ToggleB>{},
+        fsmpp2::events<Toggle>{},
+        flag,
+        fsmpp2::toggled_tracer{TypedTracer{}, flag}};
+
+    auto const& tr = sm.tracer().inner();
+
+    // switched on by the handler, the whole event stays untraced
+    sm.dispatch(Toggle{});
+    CHECK(flag);
+    CHECK(sm.is_in<ToggleB>());
+    CHECK(tr.begins == 0);
+    CHECK(tr.ends == 0);
+    CHECK(tr.exits == 0);
+
+    // switched off by the handler, the whole event is traced
+    sm.dispatch(Toggle{});
+    CHECK_FALSE(flag);
+    CHECK(tr.begins == 1);
+    CHECK(tr.ends == 1);
+    CHECK(tr.transitions == 1);
+    CHECK(tr.exits == 1);
+    CHECK(tr.enters == 2);
+
+    sm.dispatch(Toggle{});
+    CHECK(tr.begins == tr.ends);
+    CHECK(tr.begins == 1);
+}
+
+namespace
+{
+
+struct Clear : fsmpp2::event {};
+
+// the substate does not handle the event after switching tracing off, its parent does
+struct ClearingLeaf : fsmpp2::state<> {
+    auto handle(Clear const&, std::atomic<bool>& flag) {
+        flag = false;
+        return not_handled();
+    }
+};
+
+struct ClearingParent : fsmpp2::state<ClearingLeaf> {
+    auto handle(Clear const&) {
+        return handled();
+    }
+};
+
+}
+
+TEST_CASE("Toggled tracer reads the flag once per dispatch", "[tracers][toggled_tracer]")
+{
+    std::atomic<bool> flag {true};
+
+    SECTION("on its own") {
+        fsmpp2::state_machine sm{
+            fsmpp2::states<ClearingParent>{},
+            fsmpp2::events<Clear>{},
+            flag,
+            fsmpp2::toggled_tracer{TypedTracer{}, flag}};
+
+        // both levels are traced although the flag is cleared by the first one
+        sm.dispatch(Clear{});
+        CHECK(sm.tracer().inner().begins == 2);
+        CHECK(sm.tracer().inner().ends == 2);
+
+        sm.dispatch(Clear{});
+        CHECK(sm.tracer().inner().begins == 2);
+    }
+
+    SECTION("within a composite tracer") {
+        fsmpp2::state_machine sm{
+            fsmpp2::states<ClearingParent>{},
+            fsmpp2::events<Clear>{},
+            flag,
+            fsmpp2::tracers{fsmpp2::toggled_tracer{TypedTracer{}, flag}}};
+
+        sm.dispatch(Clear{});
+        CHECK(sm.tracer().get<0>().inner().begins == 2);
+        CHECK(sm.tracer().get<0>().inner().ends == 2);
+    }
+}
@@ -0,0 +1,151 @@
+#include "catch.hpp"
+#include "fsmpp2/state_machine.hpp"
+#include "fsmpp2/transition_table.hpp"
+#include <vector>
+
+namespace
+{
+
+struct Context {
+    int retries = 0;
+    int closes = 0;
+    std::vector<int> received;
+};
+
+struct Connect : fsmpp2::event {};
+struct Ack : fsmpp2::event {};
+struct Timeout : fsmpp2::event {};
+struct Close : fsmpp2::event {};
+
+struct Data : fsmpp2::event {
+    int value = 0;
+};
+
+Data data(int value) {
+    Data e;
+    e.value = value;
+    return e;
+}
+
+struct CanRetry {
+    bool operator()(Timeout const&, Context const& ctx) const { return ctx.retries < 2; }
+};
+
+struct CountRetry {
+    void operator()(Timeout const&, Context& ctx) const { ctx.retries ++; }
+};
+
+struct IsEmpty {
+    bool operator()(Data const& e) const { return e.value == 0; }
+};
+
+struct Store {
+    void operator()(Data const& e, Context& ctx) const { ctx.received.push_back(e.value); }
+};
+
+struct Idle;
+struct Connecting;
+struct Open;
+struct Closed;
+
+using Table = fsmpp2::transition_table<
+    fsmpp2::edge<Idle, Connect, Connecting>,
+    fsmpp2::row<Connecting, Timeout, CanRetry, CountRetry, Connecting>,
+    fsmpp2::edge<Connecting, Ack, Open>,
+    fsmpp2::edge<Connecting, Timeout, Closed>,
+    fsmpp2::row<Open, Data, IsEmpty, fsmpp2::none, Closed>,
+    fsmpp2::row<Open, Data, fsmpp2::none, Store, fsmpp2::none>,
+    fsmpp2::edge<Open, Close, Idle>
+>;
+
+struct Idle : fsmpp2::state<> {
+    using transition_table = Table;
+};
+
+struct Connecting : fsmpp2::state<> {
+    using transition_table = Table;
+};
+
+struct Open : fsmpp2::state<> {
+    using transition_table = Table;
+
+    // a handler takes precedence over rows of the same event
+    auto handle(Close const&, Context& ctx) {
+        ctx.closes ++;
+        return transition<Closed>();
+    }
+};
+
+// a handler-based state in the same machine
+struct Closed : fsmpp2::state<> {
+    auto handle(Connect const&) const { return transition<Connecting>(); }
+};
+
+using States = fsmpp2::states<Idle, Connecting, Open, Closed>;
+using Events = fsmpp2::events<Connect, Ack, Timeout, Close, Data>;
+using Machine = fsmpp2::state_machine<States, Events, Context>;
+
+}
+
+TEST_CASE("Transition table rows are indexed at compile time", "[transition_table]")
+{
+    STATIC_REQUIRE(Table::first_row<Idle, Connect>() == 0);
+    STATIC_REQUIRE(Table::first_row<Connecting, Timeout>() == 1);
+    STATIC_REQUIRE(Table::next_row(1) == 3);
+    STATIC_REQUIRE(Table::next_row(3) == Table::npos);
+    STATIC_REQUIRE(Table::first_row<Open, Data>() == 4);
+    STATIC_REQUIRE(Table::next_row(4) == 5);
+    STATIC_REQUIRE_FALSE(Table::has_rows<Idle, Data>());
+    STATIC_REQUIRE_FALSE(Table::has_rows<Closed, Connect>());
+
+    // rows are seen as handlers returning transitions<> to their targets
+    STATIC_REQUIRE(std::is_same_v<
+        fsmpp2::detail::mutable_handle_result<Connecting, Timeout, Context>::type,
+        fsmpp2::transitions<Connecting, Closed>>);
+    STATIC_REQUIRE(std::is_same_v<
+        fsmpp2::detail::mutable_handle_result<Open, Data, Context>::type,
+        fsmpp2::transitions<Closed>>);
+
+    STATIC_REQUIRE(!Machine::is_read_only<Data>());
+    STATIC_REQUIRE(std::is_same_v<Machine::context_access<Idle, Connect>, fsmpp2::meta::type_list<>>);
+    STATIC_REQUIRE(std::is_same_v<Machine::context_access<Open, Data>, fsmpp2::meta::type_list<Context>>);
+}
+
+TEST_CASE("Transition table drives a state machine", "[transition_table]")
+{
+    Machine sm;
+    auto& ctx = sm.context();
+
+    CHECK_FALSE(sm.dispatch(Ack{}));
+    CHECK(sm.dispatch(Connect{}));
+    CHECK(sm.is_in<Connecting>());
+
+    // guarded rows are tried in order
+    CHECK(sm.dispatch(Timeout{}));
+    CHECK(sm.dispatch(Timeout{}));
+    CHECK(sm.is_in<Connecting>());
+    CHECK(ctx.retries == 2);
+
+    CHECK(sm.dispatch(Timeout{}));
+    CHECK(sm.is_in<Closed>());
+
+    CHECK(sm.dispatch(Connect{}));
+    CHECK(sm.dispatch(Ack{}));
+    CHECK(sm.is_in<Open>());
+
+    // internal row, handled without a transition
+    CHECK(sm.dispatch(data(1)));
+    CHECK(sm.dispatch(data(2)));
+    CHECK(sm.is_in<Open>());
+    CHECK(ctx.received == std::vector<int>{1, 2});
+
+    CHECK(sm.dispatch(Close{}));
+    CHECK(sm.is_in<Closed>());
+    CHECK(ctx.closes == 1);
+
+    sm.dispatch(Connect{});
+    sm.dispatch(Ack{});
+    CHECK(sm.dispatch(data(0)));
+    CHECK(sm.is_in<Closed>());
+    CHECK(ctx.received == std::vector<int>{1, 2});
+}
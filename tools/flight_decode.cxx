@@ -0,0 +1,25 @@
+#include <fsmpp2/flight_recorder.hpp>
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    if (argc != 2) {
+        std::cerr << "usage: " << argv[0] << " <dump file>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream ifs{argv[1], std::ios::binary};
+
+    if (!ifs) {
+        std::cerr << "can't open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    if (!fsmpp2::flight::decode(ifs, std::cout)) {
+        std::cerr << "malformed dump" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <fsmpp2/shm_mirror.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+
+void print(fsmpp2::mirror::reader const& shm)
+{
+    fsmpp2::mirror::machine_snapshot snap;
+
+    for (std::size_t i = 0; i < shm.slot_count(); ++i) {
+        if (!shm.read(i, snap)) {
+            continue;
+        }
+
+        std::cout << "[" << i << "] " << (snap.label.empty() ? "(unnamed)" : snap.label) << ": ";
+
+        for (std::size_t lvl = 0; lvl < snap.path.size(); ++lvl) {
+            auto const id = snap.path[lvl];
+            std::cout << (lvl ? " / " : "") << (id < snap.states.size() ? snap.states[id] : "?");
+        }
+
+        std::cout << "\n";
+
+        for (std::size_t id = 0; id < snap.states.size(); ++id) {
+            if (snap.entered[id] || snap.handled[id]) {
+                std::cout << "    " << snap.states[id]
+                          << " entered " << snap.entered[id]
+                          << " handled " << snap.handled[id] << "\n";
+            }
+        }
+    }
+
+    std::cout << std::flush;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3) {
+        std::cerr << "usage: " << argv[0] << " <segment name> [refresh interval ms]" << std::endl;
+        return 1;
+    }
+
+    fsmpp2::mirror::reader shm{argv[1]};
+
+    if (!shm.valid()) {
+        std::cerr << "can't open segment " << argv[1] << std::endl;
+        return 1;
+    }
+
+    if (argc == 2) {
+        print(shm);
+        return 0;
+    }
+
+    auto const interval = std::chrono::milliseconds{std::atoi(argv[2])};
+
+    while (true) {
+        std::cout << "\033[2J\033[H";
+        print(shm);
+        std::this_thread::sleep_for(interval);
+    }
+}